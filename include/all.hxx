@@ -35,49 +35,208 @@ extern string verbosity;
 
 #define use_bmi_flag FALSE       // TODO set to TRUE to run in BMI environment
 
-#define MAX_NUM_SOIL_LAYERS 4
-#define MAX_NUM_SOIL_TYPES 16
 #define MAX_SOIL_NAME_CHARS 25
 #define MAX_NUM_WETTING_FRONTS 300
 
+// tables of the cumulative K(h) integral used by the numeric Geff (see calc_Geff_table): nodes from h = 0.1 cm to
+// GEFF_TABLE_H_MAX, GEFF_TABLE_NODES_PER_DECADE per decade, two values (I, dI/dln(h)) per node
+#define GEFF_TABLE_H_MAX            1.0E8
+#define GEFF_TABLE_DECADES          9
+#define GEFF_TABLE_NODES_PER_DECADE 32
+#define GEFF_TABLE_SIZE             (2*(GEFF_TABLE_DECADES*GEFF_TABLE_NODES_PER_DECADE + 1))
+#define GEFF_TABLE_NODE_TOLERANCE   1.0E-8 // relative tolerance of the quadrature of the table between nodes
+
+// tables of the van Genuchten relations (see calc_vg_table): ln(Se) at nodes of ln(h) from VG_TABLE_LN_H_MIN to
+// VG_TABLE_LN_H_MAX, ln(h) and ln(K/Ksat) at nodes of logit(Se) = ln(Se/(1-Se)) from VG_TABLE_LOGIT_MIN to
+// VG_TABLE_LOGIT_MAX, VG_TABLE_NODES_PER_UNIT nodes per unit of ln(h) or logit(Se), two values (value, slope) per node
+#define VG_TABLE_LN_H_MIN       (-5)
+#define VG_TABLE_LN_H_MAX       19
+#define VG_TABLE_LOGIT_MIN      (-12)
+#define VG_TABLE_LOGIT_MAX      23
+#define VG_TABLE_NODES_PER_UNIT 32
+#define VG_TABLE_H_INTERVALS    ((VG_TABLE_LN_H_MAX - VG_TABLE_LN_H_MIN)*VG_TABLE_NODES_PER_UNIT)
+#define VG_TABLE_SE_INTERVALS   ((VG_TABLE_LOGIT_MAX - VG_TABLE_LOGIT_MIN)*VG_TABLE_NODES_PER_UNIT)
+#define VG_TABLE_TOLERANCE      1.0E-5  // maximum relative error of the tables (Se, h, K), checked when a table is built
+
+// largest number of trial heads evaluated at once by the psi search of lgar_theta_mass_balance (psi_search_candidates)
+#define LGAR_MAX_PSI_CANDIDATES 8
+
+// instruction sets of the batch van Genuchten functions (see soil_batch.cxx); SOIL_BATCH_SCALAR calls the scalar
+// functions
+enum soil_batch_isa_ {SOIL_BATCH_SCALAR, SOIL_BATCH_SSE2, SOIL_BATCH_AVX2, SOIL_BATCH_AVX512};
+
+// precision profiles of the solvers (see lgar_set_precision_profile): the tolerances and iteration caps of the
+// reference profile, looser ones for operational forecasts (bounded time per step) and for calibration screening
+enum precision_profile_ {PRECISION_REFERENCE, PRECISION_OPERATIONAL, PRECISION_SCREENING};
+
+// integrators of the wetting front depths (see BmiLGAR::Update): explicit Euler with dz/dt at the start of the
+// substep, or Heun's predictor-corrector with the mean of dz/dt at the start and at the end of an Euler predictor
+enum front_integrator_ {FRONT_INTEGRATOR_EULER, FRONT_INTEGRATOR_HEUN};
+
+// outcome of an Euler predictor under front_integrator=heun (see lgar_heun_dzdt): kept as is, retaken with the mean
+// dz/dt (corrector), or retried with half the step because a front merged or crossed a layer or the domain boundary
+enum heun_step_ {HEUN_KEEP_EULER, HEUN_CORRECT, HEUN_HALVE};
+
+// events acted on after the wetting fronts have been moved (see lgar_scan_front_events)
+#define FRONT_EVENT_NONE          0
+#define FRONT_EVENT_DRY_OVER_WET  1
+#define FRONT_EVENT_MERGE         2
+#define FRONT_EVENT_CROSS_LAYER   4
+#define FRONT_EVENT_CROSS_DOMAIN  8
+
+// results of lgar_check_fronts, which decides whether a substep is rolled back (see BmiLGAR::Update)
+#define FRONT_CHECK_OK     0
+#define FRONT_CHECK_DEPTH  1  // a non-positive or non-finite depth, or a non-finite theta
+#define FRONT_CHECK_ORDER  2  // a wetting front below the next one (a failed merge or layer crossing)
+
+// substeps of BmiLGAR::Update: the model timestep halved at most LGAR_MAX_STEP_HALVINGS times on rollback, or
+// multiplied by powers of two in calm periods (adaptive_timestep); the histogram of the accepted substeps has a bin per
+// power of two from the smallest substep
+#define LGAR_MAX_STEP_HALVINGS 4
+#define LGAR_SUBSTEP_BINS      16
+
+
+// Define a data structure to hold all wetting fronts of a soil column. The wetting fronts are stored as a
+// structure of arrays sorted by depth; the wetting front number is the array index (1-indexed, index 0 is unused),
+// so any front is reached in O(1), and inserting or deleting a front shifts the deeper fronts in place.
+struct wetting_front_list
+{
+  int     num_fronts;       // number of wetting fronts currently in the list
+  int     capacity;         // number of wetting fronts the arrays can hold
+  double *depth_cm;         // depth down from the land surface (absolute depth)
+  double *theta;            // water content of the soil moisture block
+  double *psi_cm;           // psi calculated at rhs of the current wetting front
+  double *K_cm_per_h;       // the value of K(theta) associated with the wetting front
+  int    *layer_num;        // the layer containing this wetting front.
+  bool   *to_bottom;        // TRUE iff this wetting front is in contact with the layer bottom
+  double *dzdt_cm_per_h;    // use to store the calculated wetting front speed
+  double *mass_cm;          // water (cm) held by the wetting front; the column mass is the sum over all fronts
+  double  mass_total_cm;    // running total of mass_cm (column mass), maintained incrementally
+
+  // cached inputs/results of lgar_dzdt_calc; a cache entry is valid only if its layer number matches the front's
+  // layer (0 marks it dirty) and its inputs are unchanged, otherwise it is recomputed
+  double *Geff_cm;           // cached capillary drive of the wetting front
+  double *Geff_theta1;       // theta of the wetting front below, used for the cached Geff
+  double *Geff_theta2;       // theta of the wetting front, used for the cached Geff
+  int    *Geff_layer_num;    // layer the cached Geff was computed for (0 = dirty)
+  double *resistance_h;      // cached sum of L_k/K_k(psi) over the layers above the wetting front (multi-layer dz/dt)
+  double *resistance_psi_cm; // psi of the wetting front used for the cached resistance
+  int    *resistance_layer_num; // layer the cached resistance was computed for (0 = dirty)
+
+  // psi of a wetting front projected into the layers above it (the front extends to the surface in terms of psi);
+  // row wf holds theta and K in layers 1..proj_num_layers[wf], stored at [wf*proj_stride + layer]
+  int     proj_stride;       // row length of the projection arrays (num_layers+1)
+  double *proj_theta;        // theta(psi) of the wetting front in each overlying layer
+  double *proj_K_cm_per_h;   // K(theta(psi)) of the wetting front in each overlying layer, including the frozen factor
+  double *proj_psi_cm;       // psi the projection was computed for
+  int    *proj_num_layers;   // number of overlying layers projected (0 = dirty)
+
+  struct wetting_front_pool *pool; // pool the list storage was acquired from
+  int     pool_index;       // index of this list in the pool
+};
+
 
-// Define a data structure to hold everything that describes a wetting front
-struct wetting_front
+// Define a per-instance pool of wetting front lists. The arrays of all lists of a model instance (current and
+// previous state) are carved out of one block allocated at initialization; lists are acquired and released in O(1)
+// through a free list, so adding or removing wetting fronts never touches the heap while the model runs.
+struct wetting_front_pool
 {
-  double depth_cm;         // depth down from the land surface (absolute depth)
-  double theta;            // water content of the soil moisture block
-  double psi_cm;           // psi calculated at rhs of the current wetting front
-  double K_cm_per_h;       // the value of K(theta) associated with the wetting front
-  int    layer_num;        // the layer containing this wetting front.
-  int    front_num;        // the wetting front number (might be irrelevant), but useful to debug
-  bool   to_bottom;        // TRUE iff this wetting front is in contact with the layer bottom
-  double dzdt_cm_per_h;    // use to store the calculated wetting front speed
-  struct wetting_front *next;  // pointer to the next wetting front.
+  int    capacity;                    // number of wetting fronts each list can hold (MAX_NUM_WETTING_FRONTS)
+  int    num_lists;                   // number of lists in the pool
+  int    num_free;                    // number of lists available for acquisition
+  int   *free_list;                   // stack of indices of the available lists
+  struct wetting_front_list *lists;   // list headers; their arrays point into block
+  void  *block;                       // single allocation holding the arrays of all lists
+  size_t nbytes;                      // bytes held by the pool (block, list headers and free list)
 };
 
-/* head is a GLOBALLY defined pointer to the first link in the wetting front list.
-   Making it a local variable in main() makes all linked list operations
-   in subroutines a pain of referencing.  Since it is just one thing,
-   making it global just makes everything easier.
-*/
+
+// Define the per-instance arena. All arrays of a model instance whose size is known once the config file is read
+// (soil properties, layer arrays, calibratable parameters, wetting front outputs, giuh) are carved out of one block
+// at computed offsets, see lgar_arena_create. The soil temperature profile is only needed when coupled to soil
+// freeze-thaw and otherwise lives in a separate block allocated on first use (lgar_soil_temperature_alloc).
+struct model_arena
+{
+  void   *block;                      // single allocation holding the per-instance arrays
+  size_t nbytes;                      // size of block in bytes
+  double *sft_block;                  // soil temperature and soil temperature depths (lazy when uncoupled)
+  size_t sft_nbytes;                  // size of sft_block in bytes
+};
+
+
+// Define a data structure to hold the table of the cumulative K(h) integral of a soil (optional, see calc_Geff_table);
+// it is built at the first numeric Geff of the soil and kept as long as the van Genuchten parameters do not change
+struct geff_table_
+{
+  double I[GEFF_TABLE_SIZE];    // I and dI/dln(h) at the nodes
+  double vg_alpha, vg_n, vg_m;  // parameters the table was built for (zero if not built yet)
+  double tolerance_min;         // smallest Geff tolerance the table meets; the quadrature is used for tighter ones
+};
+
+
+// Define a data structure to hold the tables of the van Genuchten relations of a soil (optional, see calc_vg_table)
+struct vg_table_
+{
+  double ln_Se[2*(VG_TABLE_H_INTERVALS+1)];   // ln(Se) and its slope at the nodes of ln(h)
+  double ln_h[2*(VG_TABLE_SE_INTERVALS+1)];   // ln(h) and its slope at the nodes of logit(Se)
+  double ln_Kr[2*(VG_TABLE_SE_INTERVALS+1)];  // ln(K/Ksat) and its slope at the nodes of logit(Se)
+  double max_error;                           // largest relative error found when the table was built
+};
+
+
+// Define a data structure to hold the constants the soil kernels derive from the parameters of a soil, so that they are
+// not recomputed (divisions, pow) at every call; refreshed by lgar_update_soil_constants whenever the parameters change
+struct soil_constants_
+{
+  double theta_range;         // theta_e - theta_r
+  double inv_vg_alpha;        // 1/vg_alpha_per_cm (cm)
+  double inv_vg_n;            // 1/vg_n
+  double inv_vg_m;            // 1/vg_m
+  double dtheta_dh_scale;     // (theta_e - theta_r)*vg_m*vg_n, the factor of d(theta)/dh
+  double dtheta_dh_exponent;  // -(vg_m + 1), the exponent of 1 + (alpha*h)^n in d(theta)/dh
+  double bc_exponent;         // 3 + 1/bc_lambda, the Brooks & Corey exponent of the closed form Geff
+  double bc_Hc_cm;            // Brooks & Corey capillary drive of the closed form Geff (cm)
+};
 
 
 // Define a data structure to hold properties and parameters for each soil type
-struct soil_properties_  /* note the trailing underscore on the name.  It is just part of the name */
+// The record is aligned to a 64-byte cache line; the first line holds the parameters read by the kernels at every
+// call (van Genuchten functions, dz/dt, mass balance), the second line the constants derived from them, the third
+// the Brooks & Corey parameters, the tables, and the soil name. The array of soils must therefore be allocated with
+// this alignment (see lgar_arena_create).
+struct alignas(64) soil_properties_  /* note the trailing underscore on the name.  It is just part of the name */
 {
-  char soil_name[MAX_SOIL_NAME_CHARS];  // string to hold the soil name
+  // hot: first cache line
   double theta_r;          // residual water content
   double theta_e;          // water content at effective saturation <= porosity
   double vg_alpha_per_cm;  // van Genuchten  "alpha" cm^(-1)
   double vg_n;             // van Genuchten  "n"
   double vg_m;             // van Genuchten  "m"
-  double bc_lambda;        // Brooks & Corey pore distribution index
-  double bc_psib_cm;       // Brooks & Corey bubbling pressure head (cm)
-  double h_min_cm;         // the minimum Geff calculated as per Morel-Seytoux and Khanji
   double Ksat_cm_per_h;    // saturated hydraulic conductivity cm/s
+  double h_min_cm;         // the minimum Geff calculated as per Morel-Seytoux and Khanji
   double theta_wp;         // water content at wilting point [-]
+
+  // hot: second cache line
+  struct soil_constants_ constants; // derived from the parameters above (see lgar_update_soil_constants)
+
+  // cold: third cache line
+  double bc_lambda;        // Brooks & Corey pore distribution index
+  double bc_psib_cm;       // Brooks & Corey bubbling pressure head (cm)
+  struct geff_table_ *geff_table; // table of the cumulative K(h) integral (NULL if the numeric Geff uses the quadrature)
+  struct vg_table_ *vg_table; // tables of the van Genuchten relations (NULL if the formulas are used)
+  char soil_name[MAX_SOIL_NAME_CHARS];  // string to hold the soil name
+  bool   use_closed_form_G; // the closed form Geff is within the Geff tolerance of the numeric integral for this soil
+  int    batch_isa;         // instruction set of the batch functions (enum soil_batch_isa_), the same for all soils of a model
 };
 
+// layout test: the hot parameters share one cache line, their derived constants the second, the cold part the third
+static_assert(alignof(struct soil_properties_) == 64, "soil_properties_ must be cache line aligned");
+static_assert(offsetof(struct soil_properties_, theta_wp) + sizeof(double) == 64, "hot soil parameters must fill the first cache line");
+static_assert(offsetof(struct soil_properties_, constants) == 64 && sizeof(struct soil_constants_) == 64,
+	      "soil constants must fill the second cache line");
+static_assert(offsetof(struct soil_properties_, bc_lambda) == 128, "cold soil parameters must start on the third cache line");
+static_assert(sizeof(struct soil_properties_) == 192, "soil_properties_ must span exactly three cache lines");
+
 
 // Define a struct for unit conversion
 struct unit_conversion
@@ -98,6 +257,20 @@ struct lgar_bmi_input_parameters
 };
 
 
+// tolerances and iteration caps of the solvers, set together by a precision profile (see lgar_set_precision_profile)
+struct precision_settings_
+{
+  int    profile;                     // enum precision_profile_
+  double mass_balance_tolerance_cm;   // mass error at which lgar_theta_mass_balance stops its psi search
+  int    mass_balance_max_iter;       // largest number of iterations of the psi search
+  double free_drainage_tolerance_cm;  // mass error at which the depth correction of the saturated free drainage front stops
+  int    free_drainage_max_iter;      // largest number of iterations of that correction
+  double geff_tolerance;              // relative tolerance of the Geff quadrature and tables, and of the closed form choice
+  double substep_mass_tolerance_cm;   // local (subtimestep) mass balance error beyond which a substep is rolled back
+  double local_mass_error_max_cm;     // local mass balance error beyond which the model stops (at the smallest substep)
+  double heun_tolerance_cm;           // front_integrator=heun: a predictor is corrected only if a front moves more than this
+};
+
 // Define a data structure for parameters accessed by the bmi and use or pass to lgar modules
 struct lgar_bmi_parameters
 {
@@ -115,7 +288,7 @@ struct lgar_bmi_parameters
   double timestep_h;               // model timestep in hours
   double forcing_resolution_h;     // forcing resolution in hours
   int    forcing_interval;         // = forcing_resolution_h/timestep_h
-  int    num_soil_types;           // number of soil types; must be less than or equal to MAX_NUM_SOIL_TYPES
+  int    num_soil_types;           // number of soil types (max_soil_types); the soil records are sized at run time
   double AET_cm;                   // actual evapotranspiration in cm
 
   //double *soil_moisture_layers;    // 1D array of thetas (mean soil moisture content) per layer; output option to other models if needed
@@ -127,21 +300,48 @@ struct lgar_bmi_parameters
   double *soil_temperature_z;            /* 1D array of soil discretization associated with temperature profile [m];
 					    depth from the surface in meters */
   double *frozen_factor;                 // frozen factor added to the hydraulic conductivity due to coupling to soil freeze-thaw
+  double *Ksat_eff_cm_per_h;             /* effective saturated hydraulic conductivity of each layer (Ksat * frozen factor);
+					    rebuilt by lgar_update_layer_table when frozen factor or soil parameters change */
+  double *cum_layer_resistance_h;        // cumulative sum of layer thickness/Ksat_eff from the surface to the bottom of each layer
+  double  max_storage_cm;                // amount of water the soil column holds at saturation (theta_e in all layers)
+  double *delta_thetas;                  // scratch of lgar_move_wetting_fronts (num_layers+1): theta of the front below, per layer
+  double *delta_thickness;               // scratch of lgar_move_wetting_fronts (num_layers+1): thickness of the front, per layer
+  double *dzdt_corrector_cm_per_h;       // dz/dt of the Heun corrector (MAX_NUM_WETTING_FRONTS+1, 1-indexed)
   double  wilting_point_psi_cm;          // wilting point (the amount of water not available for plants or not accessible by plants)
   double  field_capacity_psi_cm;          // field capacity represented as a capillary head. Note that both wilting point and field capacity are specified for the whole model domain with single values
   bool   use_closed_form_G = false;      /* true if closed form of capillary drive calculation is desired, false if numeric integral
 					    for capillary drive calculation is desired */
   double ponded_depth_cm;                // amount of water on the surface unavailable for surface runoff
   double ponded_depth_max_cm;            // maximum amount of water on the surface unavailable for surface runoff
+  double coalesce_theta_tolerance = 0.0;   // merge adjacent wetting fronts of a layer closer in theta than this (0 = off)
+  double coalesce_mass_tolerance_cm = 0.0; // merge a wetting front holding less water [cm] than this into the one above (0 = off)
   double precip_previous_timestep_cm;    // amount of rainfall (previous time step)
 
-  int    nint = 120;            // number of trapezoids used in integrating the Geff function
+  double geff_tolerance = 1.0E-6; // relative error tolerance of the adaptive quadrature of the Geff function
+  bool   is_geff_tolerance_set = false; // geff_tolerance given in the config file; prevails over the precision profile
+  bool   geff_table = true;      // true if the numeric Geff uses per soil tables of the cumulative K(h) integral
+  int    num_geff_tables = 0;    // number of Geff tables, one per soil type of the column (0 if geff_table is false)
+  struct geff_table_ *geff_tables; // storage of the Geff tables (NULL if geff_table is false)
+  bool   vg_table = false;       // true if the van Genuchten relations are interpolated from per soil tables
+  int    num_vg_tables = 0;      // number of van Genuchten tables, one per soil type of the column (0 if vg_table is false)
+  struct vg_table_ *vg_tables;   // storage of the van Genuchten tables (NULL if vg_table is false)
+  int    psi_search_candidates = 0; // trial heads per evaluation in the psi search of the mass balance (0 = one, sequential)
+  int    batch_kernels = SOIL_BATCH_SCALAR; // instruction set of the batch van Genuchten functions (enum soil_batch_isa_)
+  int    precision_profile = PRECISION_REFERENCE; // requested precision profile (enum precision_profile_; settable through bmi)
+  struct precision_settings_ precision; // tolerances and iteration caps of the precision profile in use
+  bool   adaptive_timestep = false;      // substeps grow beyond timestep_h while no rain, ponded water or fast front
+  double adaptive_front_move_cm = 1.0;   // largest distance [cm] a wetting front may move in a grown substep
+  long   substep_histogram[LGAR_SUBSTEP_BINS]; // accepted substeps; bin k: timestep_h*2^(k-LGAR_MAX_STEP_HALVINGS)
+  long   num_substep_rollbacks;          // substeps rolled back and retried with half the step
+  int    front_integrator = FRONT_INTEGRATOR_EULER; // integrator of the wetting front depths (enum front_integrator_)
+  long   num_heun_corrections;           // substeps taken with the Heun corrector (the others kept the Euler predictor)
   double time_s;                // current time [s] (this is the bmi output 'time')
   double endtime_s;             // simulation endtime in seconds (bmi output endtime)
   int    timesteps;             // number of timesteps until the current time 
   int    sft_coupled = 0;       // model coupling flag. if true, lasam is coupled to soil freeze thaw model; default is uncoupled version
   
   double *giuh_ordinates;       // geomorphological instantaneous unit hydrograph
+  double *giuh_runoff_queue;    // runoff queue of the giuh convolution integral
   int    num_giuh_ordinates;    // number of giuh ordinates
 
    int  calib_params_flag = 0;  // flag for calibratable parameters; if true, then calibratable params are updated otherwise not
@@ -181,6 +381,9 @@ struct lgar_mass_balance_variables
   double volQ_gw_cm;          // outgoing water from ground reservoir to stream channel
   double volchange_calib_cm;  // change in the amount of water due to calibratable parameters
   double local_mass_balance;  // local (per timestep) mass balance error
+  double local_mass_balance_max_cm;  // largest absolute local (subtimestep) mass balance error
+  double local_mass_balance_sum_cm;  // sum of the absolute local mass balance errors
+  long   num_local_mass_balance;     // number of subtimesteps in that sum
 };
 
 // Define a data structure for calibratable parameters
@@ -200,8 +403,9 @@ struct lgar_calib_parameters
 // nested structure of structures; main structure for the use in bmi
 struct model_state
 {
-  struct wetting_front*               head           = NULL; // head pointer to the current state
-  struct wetting_front*               state_previous = NULL; // head pointer to the previous state,
+  struct wetting_front_pool*          front_pool     = NULL; // storage for the wetting front lists of this instance
+  struct wetting_front_list*          fronts         = NULL; // wetting fronts of the current state
+  struct wetting_front_list*          state_previous = NULL; // wetting fronts of the previous state,
                                                              // used in computing derivatives and mass balance
   struct soil_properties_*            soil_properties;       // dynamic allocation
   struct lgar_bmi_parameters          lgar_bmi_params;
@@ -209,6 +413,7 @@ struct model_state
   struct unit_conversion              units;
   struct lgar_bmi_input_parameters*   lgar_bmi_input_params;
   struct lgar_calib_parameters        lgar_calib_params;
+  struct model_arena                  arena = {NULL, 0, NULL, 0}; // storage for the per-instance arrays
 };
 
 
@@ -217,7 +422,7 @@ struct model_state
 /* any time a function is called, it must contain the same number, order, and type of variables    */
 
 /*########################################*/
-/*   Linked list code function prototypes */
+/*   Front list code function prototypes  */
 /*########################################*/
 // 1st  entry extern means it lives in a different source file
 // 2nd entry is the type of variable it returns (void means that it returns nothing)
@@ -225,21 +430,24 @@ struct model_state
 // inside parentheses are the types of require arguments, names don't matter
 
 
-extern void                     listPrint(struct wetting_front* head);
-extern int                      listLength(struct wetting_front* head);
-extern bool                     listIsEmpty();
-extern struct wetting_front*    listDeleteFirst(struct wetting_front** head);
-extern struct wetting_front*    listFindFront(int i, struct wetting_front* head, struct wetting_front* head_old);
-extern struct wetting_front*    listDeleteFront(int i, struct wetting_front** head);
-extern void                     listSortFrontsByDepth(struct wetting_front *head);
-extern void                     listInsertFirst(double d, double t, int f, int l, bool b, struct wetting_front** head);
-extern struct wetting_front*    listInsertFront(double d, double t, int f, int l, bool b, struct wetting_front** head);
-extern struct wetting_front*    listInsertFrontAtDepth(int numlay, double *tvec,double d, double t, struct wetting_front* head);
-extern void                     listReverseOrder(struct wetting_front** head_ref);
-extern bool                     listFindLayer(struct wetting_front* link, int num_layers, double *cum_layer_thickness_cm,
-					      int *lives_in_layer, bool *extends_to_bottom_flag);
-extern struct wetting_front*    listCopy(struct wetting_front* current, struct wetting_front* state_previous=NULL);
-
+extern struct wetting_front_pool* listPoolCreate(int num_lists, int capacity, int num_layers);
+extern void                       listPoolFree(struct wetting_front_pool* pool);
+extern struct wetting_front_list* listCreate(struct wetting_front_pool* pool);
+extern void                       listFree(struct wetting_front_list* fronts);
+extern void                       listPrint(struct wetting_front_list* fronts);
+extern int                        listLength(struct wetting_front_list* fronts);
+extern bool                       listIsEmpty(struct wetting_front_list* fronts);
+extern void                       listDeleteFirst(struct wetting_front_list* fronts);
+extern void                       listDeleteFront(int i, struct wetting_front_list* fronts);
+extern void                       listSortFrontsByDepth(struct wetting_front_list* fronts);
+extern int                        listInsertFirst(double d, double t, int l, bool b, struct wetting_front_list* fronts);
+extern int                        listInsertFront(double d, double t, int f, int l, bool b, struct wetting_front_list* fronts);
+extern int                        listInsertFrontAtDepth(int numlay, double *tvec, double d, double t,
+							 struct wetting_front_list* fronts);
+extern void                       listReverseOrder(struct wetting_front_list* fronts);
+extern bool                       listFindLayer(double depth, int num_layers, double *cum_layer_thickness_cm,
+						int *lives_in_layer, bool *extends_to_bottom_flag);
+extern struct wetting_front_list* listCopy(struct wetting_front_list* fronts, struct wetting_front_list* state_previous=NULL);
 
 
 
@@ -252,75 +460,189 @@ extern double calc_K_from_Se(double Se,double Ks, double m);
 extern double calc_h_from_Se(double Se, double alpha, double m, double n);
 extern double calc_Se_from_h(double h, double alpha, double m, double n);
 extern double calc_theta_from_h(double h, double alpha, double m, double n, double theta_e, double theta_r);
+extern double calc_dtheta_dh(double h, double alpha, double m, double n, double theta_e, double theta_r);
 extern double calc_Se_from_theta(double theta,double effsat,double residual);
 extern double calc_Geff(bool use_closed_form_G, double theta1, double theta2, double theta_e, double theta_r,
-                        double alpha, double n, double m, double h_min, double Ks, int nint, double lambda, double bc_psib_cm);
+                        double alpha, double n, double m, double h_min, double Ks, double tolerance, double lambda,
+			double bc_psib_cm, const struct geff_table_ *geff_table);
+extern void calc_Geff_table(struct geff_table_ *table, double alpha, double n, double m);
+extern bool calc_vg_table(struct vg_table_ *table, double alpha, double n, double m, double tolerance);
+
+// the same functions for a soil, using its precomputed constants (see lgar_update_soil_constants); the van Genuchten
+// relations are interpolated from the tables of the soil if it has them, computed from the formulas otherwise
+extern double calc_theta_from_h(double h, const struct soil_properties_ *soil);
+extern double calc_dtheta_dh(double h, const struct soil_properties_ *soil);
+extern double calc_h_from_Se(double Se, const struct soil_properties_ *soil);
+extern double calc_K_from_Se(double Se, double Ksat, const struct soil_properties_ *soil);
+extern double calc_Se_from_theta(double theta, const struct soil_properties_ *soil);
+extern double calc_Geff(bool use_closed_form_G, double theta1, double theta2, const struct soil_properties_ *soil,
+			double Ksat, double tolerance);
+
+#ifdef GEFF_STATISTICS
+// counters of calc_Geff, compiled in the layer benchmark build only: number of calls and number of K(h) evaluations
+// of the numeric integral (process-wide, not thread-safe)
+struct geff_statistics
+{
+  unsigned long long calls;
+  unsigned long long K_evaluations;
+};
+extern struct geff_statistics geff_stats;
+#endif
+
+/*########################################*/
+/* batch van Genuchten prototypes         */
+/*########################################*/
+// the van Genuchten functions of a soil for arrays of n arguments, element i of soil soil_properties[soil_num[i]];
+// evaluated in the instruction set batch_isa of the soils (see soil_batch.cxx). The output may be the input array.
+// calc_K_from_Se_batch uses the saturated conductivity of the soil (Ksat_cm_per_h).
+extern void calc_theta_from_h_batch(int n, const double *h, const int *soil_num,
+				    const struct soil_properties_ *soil_properties, double *theta);
+extern void calc_Se_from_h_batch(int n, const double *h, const int *soil_num,
+				 const struct soil_properties_ *soil_properties, double *Se);
+extern void calc_dtheta_dh_batch(int n, const double *h, const int *soil_num,
+				 const struct soil_properties_ *soil_properties, double *dtheta_dh);
+// theta(h) and d(theta)/dh together, for the cost of little more than one of them; theta may be the argument array
+extern void calc_theta_dtheta_dh_batch(int n, const double *h, const int *soil_num,
+				       const struct soil_properties_ *soil_properties, double *theta, double *dtheta_dh);
+extern void calc_h_from_Se_batch(int n, const double *Se, const int *soil_num,
+				 const struct soil_properties_ *soil_properties, double *h);
+extern void calc_K_from_Se_batch(int n, const double *Se, const int *soil_num,
+				 const struct soil_properties_ *soil_properties, double *K);
+
+extern bool        soil_batch_supported(int isa);  // true if the build and the processor have the instruction set
+extern const char* soil_batch_name(int isa);
 
 /*########################################*/
 /* LGAR calculation function prototypes   */
 /*########################################*/
-// computed mass balance
-extern double lgar_calc_mass_bal(double *cum_layer_thickness, struct wetting_front* head);
+// computed mass balance; full traversal that also refreshes the per-front mass contributions and the running total
+extern double lgar_calc_mass_bal(double *cum_layer_thickness, struct wetting_front_list* fronts);
+
+// updates the mass contributions affected by a change of depth/theta of wetting front wf and returns the column mass
+extern double lgar_update_front_mass(int wf, double *cum_layer_thickness, struct wetting_front_list* fronts);
+
+// returns the column mass from the running total (cross-checked against lgar_calc_mass_bal if MASS_LEDGER_CHECK is set)
+extern double lgar_column_mass(double *cum_layer_thickness, struct wetting_front_list* fronts);
+
+// marks the cached Geff, layer resistances and psi projections of all wetting fronts dirty (e.g., after frozen factor
+// or calibration changes)
+extern void lgar_front_cache_invalidate(struct wetting_front_list* fronts);
+
+// projects psi of a wetting front into the overlying layers 1..num_layers_above (theta and K), reusing the cached values
+// when psi is unchanged; results are read from fronts->proj_theta/proj_K_cm_per_h
+extern void lgar_front_projection(int wf, int num_layers_above, int *soil_type, double *frozen_factor,
+				  struct wetting_front_list* fronts, struct soil_properties_ *soil_properties);
 
 // computes derivatives; called derivs() in Python code
-extern void lgar_dzdt_calc(bool use_closed_form_G, int nint, double h_p, int *soil_type, double *cum_layer_thickness,
-			   double *frozen_factor, struct wetting_front* head, struct soil_properties_ *soil_properties);
+extern void lgar_dzdt_calc(bool use_closed_form_G, double geff_tolerance, double h_p, int *soil_type, double *cum_layer_thickness,
+			   double *frozen_factor, struct wetting_front_list* fronts, struct soil_properties_ *soil_properties);
 
 // computes dry depth
-extern double lgar_calc_dry_depth(bool use_closed_form_G, int nint, double timestep_h, double *deltheta, int *soil_type,
+extern double lgar_calc_dry_depth(bool use_closed_form_G, double geff_tolerance, double timestep_h, double *deltheta, int *soil_type,
                                   double *cum_layer_thickness_cm, double *frozen_factor,
-				  struct wetting_front* head, struct soil_properties_ *soil_properties);
+				  struct wetting_front_list* fronts, struct soil_properties_ *soil_properties);
 
 // reads van Genuchten parameters from a file
 extern int lgar_read_vG_param_file(char const* vG_param_file_name, int num_soil_types, double wilting_point_psi_cm,
                                     struct soil_properties_ *soil_properties);
 
+// derives vg_m, the Brooks & Corey parameters, h_min_cm, theta_wp and the kernel constants of a soil from its van
+// Genuchten parameters and detaches its tables; called whenever the parameters change
+extern void lgar_update_soil_constants(struct soil_properties_ *soil, double wilting_point_psi_cm);
+
 // creates a surficial front (new top most wetting front)
 extern void lgar_create_surficial_front(int num_layers, double *ponded_depth_cm, double *volin, double dry_depth,
 					double theta1, int *soil_type, double *cum_layer_thickness_cm,
-					double *frozen_factor, struct wetting_front **head, struct soil_properties_ *soil_properties);
+					double *frozen_factor, struct wetting_front_list* fronts, struct soil_properties_ *soil_properties);
 
 // computes the infiltration capacity, fp, of the soil
-extern double lgar_insert_water(bool use_closed_form_G, int nint, double timestep_h, double AET_demand_cm, double *ponded_depth,
+extern double lgar_insert_water(bool use_closed_form_G, double geff_tolerance, double timestep_h, double AET_demand_cm, double *ponded_depth,
 				double *volin_this_timestep, double precip_timestep_cm, int wf_free_drainge_demand,
 				int num_layers, double ponded_depth_max_cm, int *soil_type, double *cum_layer_thickness_cm,
-				double *frozen_factor, struct wetting_front* head, struct soil_properties_ *soil_properties);
+				double *frozen_factor, double *cum_layer_resistance_h, double max_storage_cm,
+				struct wetting_front_list* fronts, struct soil_properties_ *soil_properties);
+
+// rebuilds the per-layer table (effective Ksat, cumulative layer resistance, max storage of the column); called at
+// initialization and whenever frozen factor or soil parameters change
+extern void lgar_update_layer_table(int num_layers, int *soil_type, double *cum_layer_thickness_cm, double *frozen_factor,
+				    struct soil_properties_ *soil_properties, double *Ksat_eff_cm_per_h,
+				    double *cum_layer_resistance_h, double *max_storage_cm);
+
+// sets for each soil of the column whether the closed form Geff is within the Geff tolerance (use_closed_form_G of the
+// soil) and attaches the tables of the numeric Geff; called at initialization and whenever soil parameters change
+extern void lgar_select_geff_method(int num_layers, int *soil_type, double geff_tolerance, struct geff_table_ *geff_tables,
+				    struct soil_properties_ *soil_properties);
+
+// checks the wetting fronts after a substep (FRONT_CHECK_OK, or the first problem found)
+extern int lgar_check_fronts(struct wetting_front_list* fronts);
+
+// largest substep, in units of 2^-LGAR_MAX_STEP_HALVINGS model timesteps (a power of two of at least one model
+// timestep and at most units_max), in which no wetting front moves more than max_front_move_cm at its current speed
+extern int lgar_adaptive_substep_units(double timestep_h, int units_max, double max_front_move_cm,
+				       struct wetting_front_list* fronts);
+
+// sets dzdt_cm_per_h of the Heun corrector to the mean of the dz/dt of the fronts at the start (state_previous) and at
+// the end (fronts) of the predictor and returns what to do with the predictor (enum heun_step_)
+extern int lgar_heun_dzdt(double timestep_h, double tolerance_cm, struct wetting_front_list* state_previous,
+			  struct wetting_front_list* fronts, double *dzdt_cm_per_h);
+
+// sets the tolerances and iteration caps of a precision profile (enum precision_profile_) into precision and
+// geff_tolerance; returns false, changing nothing, if the profile is unknown
+extern bool lgar_set_precision_profile(int profile, struct precision_settings_ *precision, double *geff_tolerance);
+extern const char* precision_profile_name(int profile);
+
+// builds the tables of the van Genuchten relations of each soil of the column (if vg_tables is not NULL); called at
+// initialization and whenever soil parameters change
+extern void lgar_build_vg_tables(int num_layers, int *soil_type, struct vg_table_ *vg_tables,
+				 struct soil_properties_ *soil_properties);
 
 // the subroutine moves wetting fronts, merges wetting fronts, and does the mass balance correction if needed
 extern void lgar_move_wetting_fronts(double timestep_h, double *ponded_depth_cm, int wf_free_drainage_demand,
 				     double old_mass, int number_of_layers, double *actual_ET_demand,
 				     double *cum_layer_thickness_cm, int *soil_type_by_layer, double *frozen_factor,
-				     struct wetting_front** head, struct wetting_front* state_previous, struct soil_properties_ *soil_properties);
+				     double *delta_thetas, double *delta_thickness, struct wetting_front_list* fronts,
+				     struct wetting_front_list* state_previous, struct soil_properties_ *soil_properties,
+				     int psi_search_candidates, const struct precision_settings_ *precision);
 
 // the subroutine merges the wetting fronts; called from lgar_move_wetting_fronts
-extern void lgar_merge_wetting_fronts(int *soil_type, double *frozen_factor, struct wetting_front** head,
-				      struct soil_properties_ *soil_properties);
+extern void lgar_merge_wetting_fronts(int *soil_type, double *frozen_factor, double *cum_layer_thickness_cm,
+				      struct wetting_front_list* fronts, struct soil_properties_ *soil_properties);
+
+// the subroutine merges adjacent wetting fronts of a layer that barely differ (optional, mass conserving); returns the number
+// of wetting fronts removed
+extern int lgar_coalesce_wetting_fronts(double theta_tolerance, double mass_tolerance_cm, double *cum_layer_thickness_cm,
+					struct wetting_front_list* fronts);
 
 // the subroutine lets wetting fronts cross soil layer boundaries; called from lgar_move_wetting_fronts
 extern void lgar_wetting_fronts_cross_layer_boundary(int num_layers, double* cum_layer_thickness_cm,
-						     int *soil_type, double *frozen_factor, struct wetting_front** head,
+						     int *soil_type, double *frozen_factor, struct wetting_front_list* fronts,
 						     struct soil_properties_ *soil_properties);
 
 /* the subroutine allows the deepest wetting front to partially leave the model through the lower boundary if necessary;
    called from lgar_move_wetting_fronts. Currently, fluxes from the lower boundary will always be 0 and this fraction of a
    wetting front will be dealth with in another way */
-extern double lgar_wetting_front_cross_domain_boundary(double domain_depth_cm, int *soil_type, double *frozen_factor,
-						       struct wetting_front** head, struct soil_properties_ *soil_properties);
+extern double lgar_wetting_front_cross_domain_boundary(double *cum_layer_thickness_cm, int num_layers, int *soil_type, double *frozen_factor,
+						       struct wetting_front_list* fronts, struct soil_properties_ *soil_properties);
 
 // subroutine to handle wet over dry wetting fronts condtions
 extern void lgar_fix_dry_over_wet_wetting_fronts(double *mass_change, double* cum_layer_thickness_cm, int *soil_type,
-						 struct wetting_front** head, struct soil_properties_ *soil_properties);
+						 struct wetting_front_list* fronts, struct soil_properties_ *soil_properties);
 
 // checks if dry over wet wetting front exists or not
-extern bool lgar_check_dry_over_wet_wetting_fronts(struct wetting_front* head);
+extern bool lgar_check_dry_over_wet_wetting_fronts(struct wetting_front_list* fronts);
+
+// returns the events (FRONT_EVENT_* flags) the post-move passes (dry over wet fix, merging, layer and domain boundary
+// crossing) would act on, found in a single sweep over the wetting fronts
+extern int lgar_scan_front_events(int num_layers, double *cum_layer_thickness_cm, struct wetting_front_list* fronts);
 
 // finds free drainage wetting front (the deepest wetting front with psi value closer to zero; saturated in terms of psi)
-extern int wetting_front_free_drainage(struct wetting_front* head);
+extern int wetting_front_free_drainage(struct wetting_front_list* fronts);
 
 // computes updated theta (soil moisture content) after moving down a wetting front; called for each wetting front to ensure mass is conserved
 extern double lgar_theta_mass_balance(int layer_num, int soil_num, double psi_cm, double new_mass,
 				      double prior_mass, double *AET_demand_cm, double *delta_theta, double *layer_thickness_cm,
-				      int *soil_type, struct soil_properties_ *soil_properties);
+				      int *soil_type, struct soil_properties_ *soil_properties, int num_candidates,
+				      double tolerance, int max_iter);
 
 /********************************************************************/
 // Bmi functions
@@ -328,16 +650,20 @@ extern double lgar_theta_mass_balance(int layer_num, int soil_num, double psi_cm
 // functions to initialize model's state at time zero from a config file
 extern void lgar_initialize(string config_file, struct model_state *state);
 extern void InitFromConfigFile(string config_file, struct model_state *state);
+extern void lgar_arena_create(struct model_state *state);
+extern void lgar_arena_free(struct model_state *state);
+extern void lgar_soil_temperature_alloc(struct model_state *state);
+extern size_t lgar_memory_footprint(struct model_state *state);
 extern vector<double> ReadVectorData(string key);
 extern void InitializeWettingFronts(int num_layers, double initial_psi_cm, int *layer_soil_type, double *cum_layer_thickness_cm,
-				    double *frozen_factor, struct wetting_front** head, struct soil_properties_ *soil_properties);
+				    double *frozen_factor, struct wetting_front_list* fronts, struct soil_properties_ *soil_properties);
 
 /********************************************************************/
 /*Other function prototypes for doing hydrology calculations, etc.  */
 /********************************************************************/
 
 extern double calc_aet(double PET_timestep_cm, double timestep_h, double wilting_point_psi_cm, double field_capacity_psi_cm, int *soil_type,
-		       double AET_thresh_Theta, double AET_expon, struct wetting_front* head, struct soil_properties_ *soil_props);
+		       double AET_thresh_Theta, double AET_expon, struct wetting_front_list* fronts, struct soil_properties_ *soil_props);
 
 /********************************************************************/
 /* Input/Output functions, etc.  */
@@ -347,7 +673,7 @@ extern double calc_aet(double PET_timestep_cm, double timestep_h, double wilting
 extern void lgar_global_mass_balance(struct model_state *state, double *giuh_runoff_queue);
 
 // writes full state of wetting fronts (depth, theta, no. of wetting front, no. of layer, dz/dt, psi) to a file at each time step
-extern void write_state(FILE *out, struct wetting_front* head);
+extern void write_state(FILE *out, struct wetting_front_list* fronts);
 
 
 /********************************************************************/
@@ -129,6 +129,7 @@ public:
   void global_mass_balance();
   double update_calibratable_parameters();
   struct model_state* get_model();
+  size_t GetMemoryFootprint();
   
 private:
   struct model_state* state;
@@ -0,0 +1,468 @@
+/*##################################################*/
+/*##################################################*/
+//  Vector kernels of the batch van Genuchten functions (see soil_batch.cxx), for one instruction set.
+//
+//  This file is not a header of its own: soil_batch.cxx includes it once per instruction set, in a namespace and
+//  under the target pragma of that set, after defining
+//    VD, VI, VU       vectors of W doubles, signed and unsigned 64 bit integers
+//    W                number of lanes
+//    MIN_N            smallest batch computed with the vector kernels (the scalar functions are faster below)
+//    HAS_FMA          true if mul_add is a fused multiply-add
+//    mul_add(a, b, c) a*b + c
+//  so that every function below is compiled for the instruction set, and inlined in the batch functions at its end.
+/*##################################################*/
+
+#define KERNEL static inline __attribute__((always_inline))
+
+// double-double number: hi + lo with |lo| <= ulp(hi)/2
+struct vdd
+{
+  VD hi, lo;
+};
+
+// vector with all lanes c
+KERNEL VD splat(double c)
+{
+  VD v = {};
+  return v + c;
+}
+
+KERNEL vdd dd(VD x)
+{
+  vdd r = {x, splat(0.0)};
+  return r;
+}
+
+// the lanes are gathered in arrays and moved to and from the vector registers at once; setting the lanes of a vector
+// one by one goes through memory at every lane
+KERNEL VD load(const double *a)
+{
+  VD v;
+  __builtin_memcpy(&v, a, sizeof(VD));
+  return v;
+}
+
+KERNEL void store(double *a, VD v)
+{
+  __builtin_memcpy(a, &v, sizeof(VD));
+}
+
+// ############################################################################################
+// error-free transformations
+// ############################################################################################
+
+// a + b = s + e exactly
+KERNEL vdd two_sum(VD a, VD b)
+{
+  vdd r;
+  r.hi = a + b;
+  VD b_virtual = r.hi - a;
+  r.lo = (a - (r.hi - b_virtual)) + (b - b_virtual);
+  return r;
+}
+
+// a + b = s + e exactly, for |a| >= |b|
+KERNEL vdd fast_two_sum(VD a, VD b)
+{
+  vdd r;
+  r.hi = a + b;
+  r.lo = b - (r.hi - a);
+  return r;
+}
+
+// a*b = p + e exactly (fused multiply-add, or Dekker's splitting); the product is not finite for infinite a or b,
+// its error is then set to zero
+KERNEL vdd two_prod(VD a, VD b)
+{
+  vdd r;
+  r.hi = a * b;
+
+  if (HAS_FMA)
+    r.lo = mul_add(a, b, -r.hi);
+  else {
+    const double split = 134217729.0;  // 2^27 + 1
+    VD c = split * a;
+    VD a_hi = c - (c - a);
+    VD a_lo = a - a_hi;
+    c = split * b;
+    VD b_hi = c - (c - b);
+    VD b_lo = b - b_hi;
+    r.lo = ((a_hi*b_hi - r.hi) + a_hi*b_lo + a_lo*b_hi) + a_lo*b_lo;
+  }
+
+  VI finite = (r.hi - r.hi) == 0.0;
+  r.lo = finite ? r.lo : 0.0;
+  return r;
+}
+
+// y*x for a double y and a double-double x
+KERNEL vdd mul_dd(VD y, vdd x)
+{
+  vdd p = two_prod(y, x.hi);
+  return fast_two_sum(p.hi, mul_add(y, x.lo, p.lo));
+}
+
+// ############################################################################################
+// log and exp; the polynomials are evaluated with Estrin's scheme, which is shorter in latency than Horner's
+// ############################################################################################
+
+// natural logarithm of the double-double x (x.hi > 0), as a double-double; log(0) = -inf
+// x = 2^e f with sqrt(1/2) <= f < sqrt(2), log(f) = 2 atanh(s) with s = (f-1)/(f+1), |s| < 0.172
+KERNEL vdd vlog(vdd x)
+{
+  VI subnormal = x.hi < DBL_MIN;
+  VD x_hi = subnormal ? x.hi * 18014398509481984.0 : x.hi;  // 2^54
+  VI bits = (VI) x_hi;
+  VI e = (VI) (((VU) bits >> 52) & 0x7ff) - (1023 + (subnormal & 54));
+  VD f = (VD) ((bits & 0x000fffffffffffffLL) | 0x3ff0000000000000LL);  // 1 <= f < 2
+
+  VI large = f > M_SQRT2;
+  f = large ? 0.5*f : f;
+  e = e - large;                                                        // large is -1 (true) or 0
+  VD e_d = (VD) (e + ROUNDING_BITS) - ROUNDING;                          // exact conversion of e
+
+  // s = (f-1)/(f+1) to double-double precision; f-1 and the rounding error of f+1 are exact
+  VD num = f - 1.0;
+  VD den = f + 1.0;
+  VD den_lo = f - (den - 1.0);
+  VD s = num / den;
+  VD inv_den = 1.0 / den;
+  vdd s_den = two_prod(s, den);
+  VD s_lo = ((num - s_den.hi) - s_den.lo - s*den_lo) * inv_den;
+
+  // 2 atanh(s) = 2s + s z q(z), q(z) = 2/3 + 2/5 z + ... + 2/23 z^10, z = s^2; truncation below 1e-17 relative
+  VD z = s*s;
+  VD z2 = z*z;
+  VD z4 = z2*z2;
+  VD q_01 = mul_add(mul_add(splat(2.0/9.0), z, splat(2.0/7.0)), z2, mul_add(splat(2.0/5.0), z, splat(2.0/3.0)));
+  VD q_23 = mul_add(mul_add(splat(2.0/17.0), z, splat(2.0/15.0)), z2, mul_add(splat(2.0/13.0), z, splat(2.0/11.0)));
+  VD q_45 = mul_add(splat(2.0/23.0), z2, mul_add(splat(2.0/21.0), z, splat(2.0/19.0)));
+  VD q = mul_add(mul_add(q_45, z4, q_23), z4, q_01);
+
+  vdd r = two_sum(e_d*LN2_HI, 2.0*s);
+  r = fast_two_sum(r.hi, r.lo + (e_d*LN2_LO + mul_add(s*z, q, 2.0*s_lo) + x.lo/x.hi));
+
+  VI zero = x.hi == 0.0;
+  VI special = (x.hi > DBL_MAX) | (x.hi != x.hi);  // log(inf) = inf, log(nan) = nan
+  r.hi = zero ? -HUGE_VAL : r.hi;
+  r.hi = special ? x.hi : r.hi;
+  r.lo = zero | special ? 0.0 : r.lo;
+  return r;
+}
+
+// exp(t) = scale*(1 + p) for the double-double t: scale = 2^k is returned in scale, p = expm1(r) with |r| <= ln(2)/2
+// is the return value; arguments beyond +-EXP_ARG_MAX are clamped, which keeps the overflow to inf and the underflow
+// to zero
+KERNEL VD vexp_parts(vdd t, VD *scale)
+{
+  VI clamped = (t.hi > EXP_ARG_MAX) | (t.hi < -EXP_ARG_MAX);
+  VD t_hi = t.hi > EXP_ARG_MAX ? EXP_ARG_MAX : t.hi;
+  t_hi = t_hi < -EXP_ARG_MAX ? -EXP_ARG_MAX : t_hi;
+  VD t_lo = clamped ? 0.0 : t.lo;
+
+  VD k_rounded = t_hi*INV_LN2 + ROUNDING;
+  VI k = (VI) k_rounded - ROUNDING_BITS;
+  VD k_d = k_rounded - ROUNDING;
+
+  VD r = (t_hi - k_d*LN2_HI) - k_d*LN2_LO + t_lo;  // t_hi - k*LN2_HI is exact
+
+  // expm1(r) = r + r^2 q(r), q(r) = 1/2! + r/3! + ... + r^11/13!; truncation below 1e-17 relative
+  VD r2 = r*r;
+  VD r4 = r2*r2;
+  VD q_01 = mul_add(mul_add(splat(1.0/120.0), r, splat(1.0/24.0)), r2, mul_add(splat(1.0/6.0), r, splat(1.0/2.0)));
+  VD q_23 = mul_add(mul_add(splat(1.0/362880.0), r, splat(1.0/40320.0)), r2,
+		    mul_add(splat(1.0/5040.0), r, splat(1.0/720.0)));
+  VD q_45 = mul_add(mul_add(splat(1.0/6227020800.0), r, splat(1.0/479001600.0)), r2,
+		    mul_add(splat(1.0/39916800.0), r, splat(1.0/3628800.0)));
+  VD q = mul_add(mul_add(q_45, r4, q_23), r4, q_01);
+
+  // 2^k in two factors, so that |k| up to 2*1010 stays within the exponent range of each
+  VI k_1 = (VI) ((VU) (k + 4096) >> 1) - 2048;
+  VI k_2 = k - k_1;
+  *scale = (VD) ((k_1 + 1023) << 52) * (VD) ((k_2 + 1023) << 52);
+
+  return mul_add(r2, q, r);
+}
+
+// scale*(1 + p), with the overflow of scale kept as inf (scale*p is nan for p = 0)
+KERNEL VD vexp(vdd t)
+{
+  VD scale;
+  VD p = vexp_parts(t, &scale);
+  VD y = mul_add(scale, p, scale);
+  return scale > DBL_MAX ? scale : y;
+}
+
+KERNEL VD vexpm1(vdd t)
+{
+  VD scale;
+  VD p = vexp_parts(t, &scale);
+  VD y = mul_add(scale, p, scale - 1.0);
+  return scale > DBL_MAX ? scale : y;
+}
+
+// ############################################################################################
+// van Genuchten relations; the arguments are positive and finite
+// ############################################################################################
+
+// ln(1 + (alpha*h)^n) and ln((alpha*h)^n) as double-doubles
+KERNEL vdd vg_ln_one_plus_ah_n(VD h, VD alpha, VD n, vdd *ln_ah_n)
+{
+  *ln_ah_n = mul_dd(n, vlog(two_prod(alpha, h)));
+  return vlog(two_sum(splat(1.0), vexp(*ln_ah_n)));
+}
+
+// Se(h) = (1 + (alpha*h)^n)^(-m)
+KERNEL VD vg_Se_from_h(VD h, VD alpha, VD n, VD m)
+{
+  vdd ln_ah_n;
+  vdd ln_one_plus = vg_ln_one_plus_ah_n(h, alpha, n, &ln_ah_n);
+  return vexp(mul_dd(-m, ln_one_plus));
+}
+
+// d(theta)/dh = -(theta_e - theta_r) m n (alpha*h)^n (1 + (alpha*h)^n)^(-m-1) / h, from the logarithms of
+// vg_ln_one_plus_ah_n
+KERNEL VD vg_dtheta_dh_from_logs(VD h, vdd ln_ah_n, vdd ln_one_plus, VD scale, VD exponent)
+{
+  vdd ln_power = mul_dd(exponent, ln_one_plus);
+  vdd t = two_sum(ln_ah_n.hi, ln_power.hi);
+  t = fast_two_sum(t.hi, t.lo + ln_ah_n.lo + ln_power.lo);
+  return -scale * vexp(t) / h;
+}
+
+KERNEL VD vg_dtheta_dh(VD h, VD alpha, VD n, VD scale, VD exponent)
+{
+  vdd ln_ah_n;
+  vdd ln_one_plus = vg_ln_one_plus_ah_n(h, alpha, n, &ln_ah_n);
+  return vg_dtheta_dh_from_logs(h, ln_ah_n, ln_one_plus, scale, exponent);
+}
+
+// Se(h) and d(theta)/dh together; they share the logarithms, half of the work of each
+KERNEL VD vg_Se_dtheta_dh(VD h, VD alpha, VD n, VD m, VD scale, VD exponent, VD *dtheta_dh)
+{
+  vdd ln_ah_n;
+  vdd ln_one_plus = vg_ln_one_plus_ah_n(h, alpha, n, &ln_ah_n);
+  *dtheta_dh = vg_dtheta_dh_from_logs(h, ln_ah_n, ln_one_plus, scale, exponent);
+  return vexp(mul_dd(-m, ln_one_plus));
+}
+
+// h(Se) = (1/alpha) (Se^(-1/m) - 1)^(1/n), with Se^(-1/m) - 1 = expm1(-ln(Se)/m)
+KERNEL VD vg_h_from_Se(VD Se, VD inv_alpha, VD inv_n, VD inv_m)
+{
+  VD x = vexpm1(mul_dd(-inv_m, vlog(dd(Se))));
+  return inv_alpha * vexp(mul_dd(inv_n, vlog(dd(x))));
+}
+
+// K(Se) = Ksat Se^(1/2) (1 - (1 - Se^(1/m))^m)^2; ln(1 - Se^(1/m)) is log1p(-Se^(1/m)) for Se^(1/m) < 1/2 and
+// ln(-expm1(ln(Se)/m)) otherwise, and 1 - (1 - Se^(1/m))^m = -expm1(m ln(1 - Se^(1/m)))
+KERNEL VD vg_K_from_Se(VD Se, VD Ksat, VD m, VD inv_m)
+{
+  vdd ln_Se = vlog(dd(Se));
+  VD scale;
+  VD p = vexp_parts(mul_dd(inv_m, ln_Se), &scale);
+  VD Se_1m = mul_add(scale, p, scale);                      // Se^(1/m)
+  VD Se_1m_minus_one = mul_add(scale, p, scale - 1.0);      // Se^(1/m) - 1
+
+  VI small = Se_1m < 0.5;
+  vdd one_minus = two_sum(splat(1.0), -Se_1m);
+  one_minus.hi = small ? one_minus.hi : -Se_1m_minus_one;
+  one_minus.lo = small ? one_minus.lo : 0.0;
+
+  VD x = -vexpm1(mul_dd(m, vlog(one_minus)));
+  vdd half_ln_Se = {0.5*ln_Se.hi, 0.5*ln_Se.lo};
+  return Ksat * vexp(half_ln_Se) * x * x;
+}
+
+// ############################################################################################
+// batch functions: gather the soil parameters of W elements, evaluate them at once, and store; the elements the vector
+// kernels do not cover are recomputed with the scalar functions. The output array may be the argument array.
+// ############################################################################################
+
+// true if argument x is in the domain of the vector kernels
+KERNEL bool in_domain(double x)
+{
+  return x > 0.0 && x <= DBL_MAX;
+}
+
+// true if the vector kernels cover argument x of the soil; the scalar functions of soils with tables interpolate
+KERNEL bool covers(double x, const struct soil_properties_ *soil)
+{
+  return soil->vg_table == NULL && in_domain(x);
+}
+
+static void theta_from_h(int n, const double *h, const int *soil_num, const struct soil_properties_ *soil_properties,
+			 double *theta)
+{
+  double x[W], alpha[W], vg_n[W], vg_m[W], range[W], theta_r[W], y[W];
+
+  for (int i = 0; i < n; i += W) {
+    int lanes = n - i < W ? n - i : W;
+
+    for (int l = 0; l < W; l++) {  // unused lanes repeat the last element
+      int j = i + (l < lanes ? l : lanes - 1);
+      const struct soil_properties_ *soil = &soil_properties[soil_num[j]];
+      x[l] = h[j];
+      alpha[l] = soil->vg_alpha_per_cm;
+      vg_n[l] = soil->vg_n;
+      vg_m[l] = soil->vg_m;
+      range[l] = soil->constants.theta_range;
+      theta_r[l] = soil->theta_r;
+    }
+
+    store(y, mul_add(vg_Se_from_h(load(x), load(alpha), load(vg_n), load(vg_m)), load(range), load(theta_r)));
+
+    for (int l = 0; l < lanes; l++) {
+      const struct soil_properties_ *soil = &soil_properties[soil_num[i+l]];
+      theta[i+l] = covers(x[l], soil) ? y[l] : calc_theta_from_h(x[l], soil);
+    }
+  }
+}
+
+static void Se_from_h(int n, const double *h, const int *soil_num, const struct soil_properties_ *soil_properties,
+		      double *Se)
+{
+  double x[W], alpha[W], vg_n[W], vg_m[W], y[W];
+
+  for (int i = 0; i < n; i += W) {
+    int lanes = n - i < W ? n - i : W;
+
+    for (int l = 0; l < W; l++) {
+      int j = i + (l < lanes ? l : lanes - 1);
+      const struct soil_properties_ *soil = &soil_properties[soil_num[j]];
+      x[l] = h[j];
+      alpha[l] = soil->vg_alpha_per_cm;
+      vg_n[l] = soil->vg_n;
+      vg_m[l] = soil->vg_m;
+    }
+
+    store(y, vg_Se_from_h(load(x), load(alpha), load(vg_n), load(vg_m)));
+
+    // calc_Se_from_h returns 1 for tiny heads and does not use the tables
+    for (int l = 0; l < lanes; l++) {
+      const struct soil_properties_ *soil = &soil_properties[soil_num[i+l]];
+      if (in_domain(x[l]) && !is_epsilon_less_than(x[l], 1.0e-01))
+	Se[i+l] = y[l];
+      else
+	Se[i+l] = calc_Se_from_h(x[l], soil->vg_alpha_per_cm, soil->vg_m, soil->vg_n);
+    }
+  }
+}
+
+static void dtheta_dh(int n, const double *h, const int *soil_num, const struct soil_properties_ *soil_properties,
+		      double *dtheta_dh)
+{
+  double x[W], alpha[W], vg_n[W], scale[W], exponent[W], y[W];
+
+  for (int i = 0; i < n; i += W) {
+    int lanes = n - i < W ? n - i : W;
+
+    for (int l = 0; l < W; l++) {
+      int j = i + (l < lanes ? l : lanes - 1);
+      const struct soil_properties_ *soil = &soil_properties[soil_num[j]];
+      x[l] = h[j];
+      alpha[l] = soil->vg_alpha_per_cm;
+      vg_n[l] = soil->vg_n;
+      scale[l] = soil->constants.dtheta_dh_scale;
+      exponent[l] = soil->constants.dtheta_dh_exponent;
+    }
+
+    store(y, vg_dtheta_dh(load(x), load(alpha), load(vg_n), load(scale), load(exponent)));
+
+    // the scalar function does not use the tables
+    for (int l = 0; l < lanes; l++) {
+      const struct soil_properties_ *soil = &soil_properties[soil_num[i+l]];
+      dtheta_dh[i+l] = in_domain(x[l]) ? y[l] : calc_dtheta_dh(x[l], soil);
+    }
+  }
+}
+
+static void theta_dtheta_dh(int n, const double *h, const int *soil_num,
+			    const struct soil_properties_ *soil_properties, double *theta, double *dtheta_dh)
+{
+  double x[W], alpha[W], vg_n[W], vg_m[W], range[W], theta_r[W], scale[W], exponent[W], y[W], dy[W];
+
+  for (int i = 0; i < n; i += W) {
+    int lanes = n - i < W ? n - i : W;
+
+    for (int l = 0; l < W; l++) {
+      int j = i + (l < lanes ? l : lanes - 1);
+      const struct soil_properties_ *soil = &soil_properties[soil_num[j]];
+      x[l] = h[j];
+      alpha[l] = soil->vg_alpha_per_cm;
+      vg_n[l] = soil->vg_n;
+      vg_m[l] = soil->vg_m;
+      range[l] = soil->constants.theta_range;
+      theta_r[l] = soil->theta_r;
+      scale[l] = soil->constants.dtheta_dh_scale;
+      exponent[l] = soil->constants.dtheta_dh_exponent;
+    }
+
+    VD dtheta;
+    VD Se = vg_Se_dtheta_dh(load(x), load(alpha), load(vg_n), load(vg_m), load(scale), load(exponent), &dtheta);
+    store(y, mul_add(Se, load(range), load(theta_r)));
+    store(dy, dtheta);
+
+    for (int l = 0; l < lanes; l++) {
+      const struct soil_properties_ *soil = &soil_properties[soil_num[i+l]];
+      theta[i+l] = covers(x[l], soil) ? y[l] : calc_theta_from_h(x[l], soil);
+      dtheta_dh[i+l] = in_domain(x[l]) ? dy[l] : calc_dtheta_dh(x[l], soil);
+    }
+  }
+}
+
+static void h_from_Se(int n, const double *Se, const int *soil_num, const struct soil_properties_ *soil_properties,
+		      double *h)
+{
+  double x[W], inv_alpha[W], inv_n[W], inv_m[W], y[W];
+
+  for (int i = 0; i < n; i += W) {
+    int lanes = n - i < W ? n - i : W;
+
+    for (int l = 0; l < W; l++) {
+      int j = i + (l < lanes ? l : lanes - 1);
+      const struct soil_properties_ *soil = &soil_properties[soil_num[j]];
+      x[l] = Se[j];
+      inv_alpha[l] = soil->constants.inv_vg_alpha;
+      inv_n[l] = soil->constants.inv_vg_n;
+      inv_m[l] = soil->constants.inv_vg_m;
+    }
+
+    store(y, vg_h_from_Se(load(x), load(inv_alpha), load(inv_n), load(inv_m)));
+
+    for (int l = 0; l < lanes; l++) {
+      const struct soil_properties_ *soil = &soil_properties[soil_num[i+l]];
+      h[i+l] = covers(x[l], soil) && x[l] < 1.0 ? y[l] : calc_h_from_Se(x[l], soil);
+    }
+  }
+}
+
+static void K_from_Se(int n, const double *Se, const int *soil_num, const struct soil_properties_ *soil_properties,
+		      double *K)
+{
+  double x[W], Ksat[W], vg_m[W], inv_m[W], y[W];
+
+  for (int i = 0; i < n; i += W) {
+    int lanes = n - i < W ? n - i : W;
+
+    for (int l = 0; l < W; l++) {
+      int j = i + (l < lanes ? l : lanes - 1);
+      const struct soil_properties_ *soil = &soil_properties[soil_num[j]];
+      x[l] = Se[j];
+      Ksat[l] = soil->Ksat_cm_per_h;
+      vg_m[l] = soil->vg_m;
+      inv_m[l] = soil->constants.inv_vg_m;
+    }
+
+    store(y, vg_K_from_Se(load(x), load(Ksat), load(vg_m), load(inv_m)));
+
+    for (int l = 0; l < lanes; l++) {
+      const struct soil_properties_ *soil = &soil_properties[soil_num[i+l]];
+      K[i+l] = covers(x[l], soil) && x[l] < 1.0 ? y[l] : calc_K_from_Se(x[l], soil->Ksat_cm_per_h, soil);
+    }
+  }
+}
+
+static const struct soil_batch_kernels kernels = {MIN_N, theta_from_h, Se_from_h, dtheta_dh, h_from_Se, K_from_Se,
+						  theta_dtheta_dh};
+
+#undef KERNEL
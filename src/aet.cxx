@@ -16,7 +16,7 @@
 
 extern double calc_aet(double PET_timestep_cm, double time_step_h, double wilting_point_psi_cm, double field_capacity_psi_cm,
 		       int *soil_type, double AET_thresh_Theta, double AET_expon,
-		       struct wetting_front* head, struct soil_properties_ *soil_properties)
+		       struct wetting_front_list* fronts, struct soil_properties_ *soil_properties)
 {
 
   if (verbosity.compare("high") == 0) {
@@ -25,38 +25,34 @@ extern double calc_aet(double PET_timestep_cm, double time_step_h, double wiltin
   }
   
   double actual_ET_demand = 0.0;
-  struct wetting_front *current;
   
   double theta_wp;
   
-  double Se,theta_e,theta_r;
-  double vg_a, vg_m, vg_n;
+  double Se;
   int layer_num, soil_num;
   
-  current = head;
 
-  layer_num = current->layer_num;
+  layer_num = fronts->layer_num[1];
   soil_num  = soil_type[layer_num];
-  theta_e   = soil_properties[soil_num].theta_e;
-  theta_r   = soil_properties[soil_num].theta_r;
-  vg_a      = soil_properties[soil_num].vg_alpha_per_cm;
-  vg_m      = soil_properties[soil_num].vg_m;
-  vg_n      = soil_properties[soil_num].vg_n;
 
   // compute theta field capacity
   double head_at_which_PET_equals_AET_cm = field_capacity_psi_cm; //340.9 is 0.33 atm, expressed in water depth, which is a good field capacity for most soils.
   //Coarser soils like sand will have a field capacity of 0.1 atm or so, which would be 103.3 cm.
-  double theta_fc = calc_theta_from_h(head_at_which_PET_equals_AET_cm, vg_a,vg_m, vg_n, theta_e, theta_r);
-  
-  double wp_head_theta = calc_theta_from_h(wilting_point_psi_cm, vg_a,vg_m, vg_n, theta_e, theta_r);
-  
+  // theta at field capacity and at the wilting point, evaluated together
+  double heads[2] = {head_at_which_PET_equals_AET_cm, wilting_point_psi_cm};
+  int soils[2] = {soil_num, soil_num};
+  double thetas[2];
+  calc_theta_from_h_batch(2, heads, soils, soil_properties, thetas);
+
+  double theta_fc = thetas[0];
+  double wp_head_theta = thetas[1];
   
   theta_wp = (theta_fc - wp_head_theta)*1/2 + wp_head_theta; // theta_50 in python
 
-  Se = calc_Se_from_theta(theta_wp,theta_e,theta_r);
-  double psi_wp_cm = calc_h_from_Se(Se, vg_a, vg_m, vg_n);
+  Se = calc_Se_from_theta(theta_wp, &soil_properties[soil_num]);
+  double psi_wp_cm = calc_h_from_Se(Se, &soil_properties[soil_num]);
 
-  double h_ratio = 1.0 + pow(current->psi_cm/psi_wp_cm, 3.0);
+  double h_ratio = 1.0 + pow(fronts->psi_cm[1]/psi_wp_cm, 3.0);
 
   actual_ET_demand = PET_timestep_cm * (1/h_ratio) * time_step_h;
 
@@ -18,15 +18,16 @@
 string verbosity="none";
 
 
-/* The `head` pointer stores the address in memory of the first member of the linked list containing
-   all the wetting fronts. The contents of struct wetting_front are defined in "all.h" */
+/* The `fronts` pointer stores the address in memory of the list (structure of arrays) containing
+   all the wetting fronts. The contents of struct wetting_front_list are defined in "all.h" */
 
 void BmiLGAR::
 Initialize (std::string config_file)
 {
   if (config_file.compare("") != 0 ) {
     this->state = new model_state;
-    state->head = NULL;
+    state->front_pool = NULL;
+    state->fronts = NULL;
     state->state_previous = NULL;
     lgar_initialize(config_file, state);
   }
@@ -34,24 +35,19 @@ Initialize (std::string config_file)
   num_giuh_ordinates = state->lgar_bmi_params.num_giuh_ordinates;
 
 
-  /* giuh ordinates are static and read in the lgar.cxx, and we need to have a copy of it to pass to
-     giuh.cxx, so allocating/copying here*/
-  
-  giuh_ordinates = new double[num_giuh_ordinates];
-  giuh_runoff_queue = new double[num_giuh_ordinates+1];
-
-  for (int i=0; i<num_giuh_ordinates;i++)
-    giuh_ordinates[i] = state->lgar_bmi_params.giuh_ordinates[i+1]; // note lgar uses 1-indexing
-
-  for (int i=0; i<=num_giuh_ordinates;i++)
-    giuh_runoff_queue[i] = 0.0;
+  /* giuh ordinates are static and read in the lgar.cxx; giuh.cxx uses 0-indexing, so point past the unused first
+     entry. The runoff queue lives in the model arena and is zero initially */
+  giuh_ordinates    = &state->lgar_bmi_params.giuh_ordinates[1];
+  giuh_runoff_queue = state->lgar_bmi_params.giuh_runoff_queue;
 
 }
 
 /*
   This is the main function calling lgar subroutines for creating, moving, and merging wetting fronts.
   Calls to AET and mass balance module are also happening here
-  If the model's timestep is smaller than the forcing's timestep then we take subtimesteps inside the subcycling loop
+  If the model's timestep is smaller than the forcing's timestep then we take subtimesteps inside the subcycling loop.
+  A subtimestep that fails (invalid wetting fronts or a local mass balance error above the precision profile's tolerance)
+  is rolled back and retried with half the step; with adaptive_timestep, calm periods take longer subtimesteps
 */
 void BmiLGAR::
 Update()
@@ -63,13 +59,53 @@ Update()
   }
  
   // if lasam is coupled to soil freeze-thaw, frozen fraction module is called
-  if (state->lgar_bmi_params.sft_coupled)
+  if (state->lgar_bmi_params.sft_coupled) {
     frozen_factor_hydraulic_conductivity(state->lgar_bmi_params);
+    lgar_front_cache_invalidate(state->fronts); // cached Geff, layer resistances and projections depend on frozen_factor
+    lgar_update_layer_table(state->lgar_bmi_params.num_layers, state->lgar_bmi_params.layer_soil_type,
+			    state->lgar_bmi_params.cum_layer_thickness_cm, state->lgar_bmi_params.frozen_factor,
+			    state->soil_properties, state->lgar_bmi_params.Ksat_eff_cm_per_h,
+			    state->lgar_bmi_params.cum_layer_resistance_h, &state->lgar_bmi_params.max_storage_cm);
+  }
+
+  // a precision profile set through bmi (precision_profile) replaces the one in use; a geff_tolerance given in the
+  // config file prevails, as at initialization
+  if (state->lgar_bmi_params.precision_profile != state->lgar_bmi_params.precision.profile) {
+    double geff_tolerance_set = state->lgar_bmi_params.geff_tolerance;
+
+    if (!lgar_set_precision_profile(state->lgar_bmi_params.precision_profile, &state->lgar_bmi_params.precision,
+				    &state->lgar_bmi_params.geff_tolerance)) {
+      int profile = state->lgar_bmi_params.precision_profile;
+      state->lgar_bmi_params.precision_profile = state->lgar_bmi_params.precision.profile; // the one in use is kept
+      std::stringstream errMsg;
+      errMsg << "precision_profile "<< profile <<" is not a precision profile "
+	     <<"(0 = reference, 1 = operational, 2 = screening)";
+      throw std::runtime_error(errMsg.str());
+    }
+
+    if (state->lgar_bmi_params.is_geff_tolerance_set) {
+      state->lgar_bmi_params.geff_tolerance           = geff_tolerance_set;
+      state->lgar_bmi_params.precision.geff_tolerance = geff_tolerance_set;
+    }
+
+    lgar_front_cache_invalidate(state->fronts); // cached Geff depend on the Geff tolerance
+    lgar_select_geff_method(state->lgar_bmi_params.num_layers, state->lgar_bmi_params.layer_soil_type,
+			    state->lgar_bmi_params.geff_tolerance, state->lgar_bmi_params.geff_tables, state->soil_properties);
+  }
 
   double volchange_calib_cm = 0.0;
 
   if(state->lgar_bmi_params.calib_params_flag) {
     volchange_calib_cm = update_calibratable_parameters(); // change in soil water volume due to calibratable parameters
+    lgar_front_cache_invalidate(state->fronts);
+    lgar_update_layer_table(state->lgar_bmi_params.num_layers, state->lgar_bmi_params.layer_soil_type,
+			    state->lgar_bmi_params.cum_layer_thickness_cm, state->lgar_bmi_params.frozen_factor,
+			    state->soil_properties, state->lgar_bmi_params.Ksat_eff_cm_per_h,
+			    state->lgar_bmi_params.cum_layer_resistance_h, &state->lgar_bmi_params.max_storage_cm);
+    lgar_select_geff_method(state->lgar_bmi_params.num_layers, state->lgar_bmi_params.layer_soil_type,
+			    state->lgar_bmi_params.geff_tolerance, state->lgar_bmi_params.geff_tables, state->soil_properties);
+    lgar_build_vg_tables(state->lgar_bmi_params.num_layers, state->lgar_bmi_params.layer_soil_type,
+			 state->lgar_bmi_params.vg_tables, state->soil_properties);
     state->lgar_bmi_params.calib_params_flag = false;
   }
 
@@ -84,7 +120,7 @@ Update()
   double precip_timestep_cm = 0.0;
   double PET_timestep_cm    = 0.0;
   double AET_timestep_cm    = 0.0;
-  double volend_timestep_cm = lgar_calc_mass_bal(state->lgar_bmi_params.cum_layer_thickness_cm, state->head); // this should not be reset to 0.0 in the for loop
+  double volend_timestep_cm = lgar_calc_mass_bal(state->lgar_bmi_params.cum_layer_thickness_cm, state->fronts); // this should not be reset to 0.0 in the for loop
   double volin_timestep_cm  = 0.0;
   double volon_timestep_cm  = state->lgar_mass_balance.volon_timestep_cm;
   double volrunoff_timestep_cm      = 0.0;
@@ -113,7 +149,7 @@ Update()
   double volQ_gw_subtimestep_cm = 0.0; // fix it for non-zero values after adding groundwater reservoir
   
   double subtimestep_h = state->lgar_bmi_params.timestep_h;
-  int nint = state->lgar_bmi_params.nint;
+  double geff_tolerance = state->lgar_bmi_params.geff_tolerance;
   double wilting_point_psi_cm = state->lgar_bmi_params.wilting_point_psi_cm;
   double field_capacity_psi_cm = state->lgar_bmi_params.field_capacity_psi_cm;
   bool use_closed_form_G = state->lgar_bmi_params.use_closed_form_G; 
@@ -132,23 +168,78 @@ Update()
   assert (state->lgar_bmi_input_params->precipitation_mm_per_h >= 0.0);
   assert(state->lgar_bmi_input_params->PET_mm_per_h >=0.0);
   
+  // ensure precip and PET are non-negative
+  state->lgar_bmi_input_params->precipitation_mm_per_h = fmax(state->lgar_bmi_input_params->precipitation_mm_per_h, 0.0);
+  state->lgar_bmi_input_params->PET_mm_per_h           = fmax(state->lgar_bmi_input_params->PET_mm_per_h, 0.0);
+
+  bool lasam_standalone = true;
+#ifdef NGEN
+  lasam_standalone = false;
+#endif
+
+  /* substeps are counted in units of 2^-LGAR_MAX_STEP_HALVINGS model timesteps, so that halved substeps (after a
+     rollback) and grown substeps (adaptive_timestep, calm periods) add up exactly to the forcing timestep. A substep
+     starts at a multiple of its own length; the GIUH runoff is routed once per completed model timestep */
+  const int units_per_step = 1 << LGAR_MAX_STEP_HALVINGS;
+  int units_total = subcycles * units_per_step;
+  int units_done  = 0;
+  int units_cap   = state->lgar_bmi_params.adaptive_timestep ? units_total : units_per_step;
+  int units_limit = units_cap;       // largest substep; halved on rollback and doubled back on success
+  double runoff_giuh_pending_cm = 0.0; // runoff of the substeps of a model timestep not yet routed through the GIUH
+  int    step_units = units_per_step;
+  double volend_previous_cm = volend_subtimestep_cm;
+  bool   heun_corrector = false;       // true while the substep is retaken as the corrector of front_integrator=heun
+  std::string local_error;             // error of a failed smallest substep, thrown once the accepted ones are accounted
+
   // subcycling loop (loop over model's timestep)
-  for (int cycle=1; cycle <= subcycles; cycle++) {
+  while (units_done < units_total) {
+
+    // the substep: a model timestep, or a longer one in a calm period (no rain, no ponded water); the corrector
+    // retakes the substep of its predictor
+    if (!heun_corrector)
+      step_units = units_per_step;
+
+    if (!heun_corrector && state->lgar_bmi_params.adaptive_timestep && state->lgar_bmi_input_params->precipitation_mm_per_h == 0.0
+	&& volon_timestep_cm <= 1.0E-12) {
+      int units_max = units_total - units_done;
+
+      // when running standalone, a grown substep does not go past the endtime
+      if (lasam_standalone) {
+	double steps_to_end = (state->lgar_bmi_params.endtime_s - state->lgar_bmi_params.time_s)
+	                      / (state->lgar_bmi_params.timestep_h * state->units.hr_to_sec);
+	units_max = std::min(units_max, units_per_step * (int) fmax(1.0, ceil(steps_to_end - 1.0E-9)));
+      }
+
+      step_units = lgar_adaptive_substep_units(state->lgar_bmi_params.timestep_h, units_max,
+					       state->lgar_bmi_params.adaptive_front_move_cm, state->fronts);
+    }
+
+    if (!heun_corrector) {
+      step_units = std::min(step_units, units_limit);
+      while (units_done % step_units != 0 || step_units > units_total - units_done)
+	step_units /= 2;
+    }
+
+    subtimestep_h = state->lgar_bmi_params.timestep_h * ((double) step_units / units_per_step);
+
+    // number of model timesteps this substep completes (0 for the first parts of a halved model timestep)
+    int steps_completed = (units_done + step_units) / units_per_step - units_done / units_per_step;
+    double time_start_s = this->state->lgar_bmi_params.time_s;
 
     this->state->lgar_bmi_params.time_s    += subtimestep_h * state->units.hr_to_sec;
-    this->state->lgar_bmi_params.timesteps ++;
+    this->state->lgar_bmi_params.timesteps += steps_completed;
     
     if (verbosity.compare("high") == 0 || verbosity.compare("low") == 0) {
       std::cerr<<"BMI Update |---------------------------------------------------------------|\n";
-      std::cerr<<"BMI Update |Timesteps = "<< state->lgar_bmi_params.timesteps<<", Time [h] = "<<this->state->lgar_bmi_params.time_s / 3600.<<", Subcycle = "<< cycle <<" of "<<subcycles<<std::endl;
+      std::cerr<<"BMI Update |Timesteps = "<< state->lgar_bmi_params.timesteps<<", Time [h] = "<<this->state->lgar_bmi_params.time_s / 3600.<<", Subcycle = "<< units_done / units_per_step + 1 <<" of "<<subcycles<<std::endl;
     }
 
-    state->state_previous = NULL;
-    state->state_previous = listCopy(state->head);
-
-    // ensure precip and PET are non-negative
-    state->lgar_bmi_input_params->precipitation_mm_per_h = fmax(state->lgar_bmi_input_params->precipitation_mm_per_h, 0.0);
-    state->lgar_bmi_input_params->PET_mm_per_h           = fmax(state->lgar_bmi_input_params->PET_mm_per_h, 0.0);
+    // the previous state is a preallocated mirror of the current state; refresh it with a flat copy
+    // (it is also the state a rolled back substep returns to, and the start of the Heun corrector)
+    if (!heun_corrector) {
+      listCopy(state->fronts, state->state_previous);
+      volend_previous_cm = volend_subtimestep_cm;
+    }
 
     /* Note unit conversion:
        Pr and PET are rates (fluxes) in mm/h
@@ -195,26 +286,22 @@ Update()
     if (PET_subtimestep_cm_per_h > 0.0) {
       AET_subtimestep_cm = calc_aet(PET_subtimestep_cm_per_h, subtimestep_h, wilting_point_psi_cm, field_capacity_psi_cm,
                                     state->lgar_bmi_params.layer_soil_type, AET_thresh_Theta, AET_expon,
-                                    state->head, state->soil_properties);
+                                    state->fronts, state->soil_properties);
     }
 
-
-    precip_timestep_cm += precip_subtimestep_cm;
-    PET_timestep_cm += fmax(PET_subtimestep_cm,0.0); // ensures non-negative PET
-
-    volstart_subtimestep_cm = lgar_calc_mass_bal(state->lgar_bmi_params.cum_layer_thickness_cm, state->head);
+    volstart_subtimestep_cm = lgar_calc_mass_bal(state->lgar_bmi_params.cum_layer_thickness_cm, state->fronts);
 
     //addressed machine precision issues where volon_timestep_error could be for example -1E-17 or 1.E-20 or smaller
     volon_timestep_cm = fmax(volon_timestep_cm,0.0);
     volon_timestep_cm = volon_timestep_cm > 1.0E-12 ? volon_timestep_cm : 0.0;
 
-    int wf_free_drainage_demand = wetting_front_free_drainage(state->head);
+    int wf_free_drainage_demand = wetting_front_free_drainage(state->fronts);
 
      /*----------------------------------------------------------------------*/
     // Should a new wetting front be created?
-    int soil_num = state->lgar_bmi_params.layer_soil_type[state->head->layer_num];
+    int soil_num = state->lgar_bmi_params.layer_soil_type[state->fronts->layer_num[1]];
     double theta_e = state->soil_properties[soil_num].theta_e;
-    bool is_top_wf_saturated = (state->head->theta+1.0E-12) >= theta_e ? true : false; //sometimes a machine precision error would erroneously create a new wetting front during saturated conditions. The + 1.0E-12 seems to prevent this.
+    bool is_top_wf_saturated = (state->fronts->theta[1]+1.0E-12) >= theta_e ? true : false; //sometimes a machine precision error would erroneously create a new wetting front during saturated conditions. The + 1.0E-12 seems to prevent this.
 
     // checks on creatign a new surficial front
     // 1. check current and previous timestep precipitation
@@ -243,41 +330,40 @@ Update()
       lgar_move_wetting_fronts(subtimestep_h, &temp_pd, wf_free_drainage_demand, volend_subtimestep_cm,
 			       num_layers, &AET_subtimestep_cm, state->lgar_bmi_params.cum_layer_thickness_cm,
 			       state->lgar_bmi_params.layer_soil_type, state->lgar_bmi_params.frozen_factor,
-			       &state->head, state->state_previous, state->soil_properties);
+			       state->lgar_bmi_params.delta_thetas, state->lgar_bmi_params.delta_thickness,
+			       state->fronts, state->state_previous, state->soil_properties,
+			       state->lgar_bmi_params.psi_search_candidates, &state->lgar_bmi_params.precision);
 
       if (temp_pd != 0.0){ //if temp_pd != 0.0, that means that some water left the model through the lower model bdy
         volrech_subtimestep_cm = temp_pd;
-        volrech_timestep_cm += volrech_subtimestep_cm;
         temp_pd = 0.0;
       }
       
       // depth of the surficial front to be created
-      dry_depth = lgar_calc_dry_depth(use_closed_form_G, nint, subtimestep_h, &delta_theta, state->lgar_bmi_params.layer_soil_type,
+      dry_depth = lgar_calc_dry_depth(use_closed_form_G, geff_tolerance, subtimestep_h, &delta_theta, state->lgar_bmi_params.layer_soil_type,
 				      state->lgar_bmi_params.cum_layer_thickness_cm, state->lgar_bmi_params.frozen_factor,
-				      state->head, state->soil_properties);
+				      state->fronts, state->soil_properties);
 
       if (verbosity.compare("high") == 0) {
         printf("State before moving creating new WF...\n");
-        listPrint(state->head);
+        listPrint(state->fronts);
       }
       
-      lgar_create_surficial_front(num_layers, &ponded_depth_subtimestep_cm, &volin_subtimestep_cm, dry_depth, state->head->theta,
+      lgar_create_surficial_front(num_layers, &ponded_depth_subtimestep_cm, &volin_subtimestep_cm, dry_depth, state->fronts->theta[1],
 				  state->lgar_bmi_params.layer_soil_type, state->lgar_bmi_params.cum_layer_thickness_cm,
-				  state->lgar_bmi_params.frozen_factor, &state->head, state->soil_properties);
+				  state->lgar_bmi_params.frozen_factor, state->fronts, state->soil_properties);
 
       if (verbosity.compare("high") == 0) {
         printf("State after moving creating new WF...\n");
-        listPrint(state->head);
+        listPrint(state->fronts);
       }
 
-      state->state_previous = NULL;
-      state->state_previous = listCopy(state->head);
-
-      volin_timestep_cm += volin_subtimestep_cm;
+      /* note: no need to refresh state_previous here; it is only used by lgar_move_wetting_fronts, which
+	 is not called again in this subcycle once a surficial wetting front is created */
 
       if (verbosity.compare("high") == 0) {
 	std::cerr<<"New wetting front created...\n";
-	listPrint(state->head);
+	listPrint(state->fronts);
       }
     }
 
@@ -287,32 +373,28 @@ Update()
 
     if (ponded_depth_subtimestep_cm > 0 && !create_surficial_front) {
 
-      volrunoff_subtimestep_cm = lgar_insert_water(use_closed_form_G, nint, subtimestep_h, AET_subtimestep_cm, &ponded_depth_subtimestep_cm,
+      volrunoff_subtimestep_cm = lgar_insert_water(use_closed_form_G, geff_tolerance, subtimestep_h, AET_subtimestep_cm, &ponded_depth_subtimestep_cm,
 						   &volin_subtimestep_cm, precip_subtimestep_cm_per_h,
 						   wf_free_drainage_demand, num_layers,
 						   ponded_depth_max_cm, state->lgar_bmi_params.layer_soil_type,
 						   state->lgar_bmi_params.cum_layer_thickness_cm,
-						   state->lgar_bmi_params.frozen_factor, state->head,
-						   state->soil_properties); 
+						   state->lgar_bmi_params.frozen_factor, state->lgar_bmi_params.cum_layer_resistance_h,
+						   state->lgar_bmi_params.max_storage_cm, state->fronts, state->soil_properties);
 
-      volin_timestep_cm += volin_subtimestep_cm;
-      volrunoff_timestep_cm += volrunoff_subtimestep_cm;
       volrech_subtimestep_cm = volin_subtimestep_cm; // this gets updated later, probably not needed here
 
       volon_subtimestep_cm = ponded_depth_subtimestep_cm;
-      if (volrunoff_subtimestep_cm < 0) abort();
+      // a negative runoff fails the substep (see the checks below)
     }
     else {
 
       if (ponded_depth_subtimestep_cm < ponded_depth_max_cm) {
-	volrunoff_timestep_cm += 0.0;
 	volon_subtimestep_cm = ponded_depth_subtimestep_cm;
 	ponded_depth_subtimestep_cm = 0.0;
 	volrunoff_subtimestep_cm = 0.0;
       }
       else {
 	volrunoff_subtimestep_cm = (ponded_depth_subtimestep_cm - ponded_depth_max_cm);
-	volrunoff_timestep_cm += (ponded_depth_subtimestep_cm - ponded_depth_max_cm);
 	volon_subtimestep_cm = ponded_depth_max_cm;
 	ponded_depth_subtimestep_cm = ponded_depth_max_cm;
       }
@@ -329,23 +411,28 @@ Update()
       lgar_move_wetting_fronts(subtimestep_h, &volin_subtimestep_cm, wf_free_drainage_demand, volend_subtimestep_cm,
 			       num_layers, &AET_subtimestep_cm, state->lgar_bmi_params.cum_layer_thickness_cm,
 			       state->lgar_bmi_params.layer_soil_type, state->lgar_bmi_params.frozen_factor,
-			       &state->head, state->state_previous, state->soil_properties);
+			       state->lgar_bmi_params.delta_thetas, state->lgar_bmi_params.delta_thickness,
+			       state->fronts, state->state_previous, state->soil_properties,
+			       state->lgar_bmi_params.psi_search_candidates, &state->lgar_bmi_params.precision);
 
       // this is the volume of water leaving through the bottom
       volrech_subtimestep_cm = volin_subtimestep_cm;
-      volrech_timestep_cm += volrech_subtimestep_cm;
 
       volin_subtimestep_cm = volin_subtimestep_cm_temp;
     }
+    /*----------------------------------------------------------------------*/
+    // optionally merge nearly identical wetting fronts (mass conserving) to bound the number of wetting fronts
+    lgar_coalesce_wetting_fronts(state->lgar_bmi_params.coalesce_theta_tolerance,
+				 state->lgar_bmi_params.coalesce_mass_tolerance_cm,
+				 state->lgar_bmi_params.cum_layer_thickness_cm, state->fronts);
+
     /*----------------------------------------------------------------------*/
     // calculate derivative (dz/dt) for all wetting fronts
-    lgar_dzdt_calc(use_closed_form_G, nint, ponded_depth_subtimestep_cm, state->lgar_bmi_params.layer_soil_type,
+    lgar_dzdt_calc(use_closed_form_G, geff_tolerance, ponded_depth_subtimestep_cm, state->lgar_bmi_params.layer_soil_type,
 		   state->lgar_bmi_params.cum_layer_thickness_cm, state->lgar_bmi_params.frozen_factor,
-		   state->head, state->soil_properties);
+		   state->fronts, state->soil_properties);
 
-    volend_subtimestep_cm = lgar_calc_mass_bal(state->lgar_bmi_params.cum_layer_thickness_cm, state->head);
-    volend_timestep_cm = volend_subtimestep_cm;
-    state->lgar_bmi_params.precip_previous_timestep_cm = precip_subtimestep_cm;
+    volend_subtimestep_cm = lgar_calc_mass_bal(state->lgar_bmi_params.cum_layer_thickness_cm, state->fronts);
 
     /*----------------------------------------------------------------------*/
     // mass balance at the subtimestep (local mass balance)
@@ -353,31 +440,60 @@ Update()
     double local_mb = volstart_subtimestep_cm + precip_subtimestep_cm + volon_timestep_cm - volrunoff_subtimestep_cm
                       - AET_subtimestep_cm - volon_subtimestep_cm - volrech_subtimestep_cm - volend_subtimestep_cm;
 
-    AET_timestep_cm += AET_subtimestep_cm;
-    volon_timestep_cm = volon_subtimestep_cm; // surface ponded water at the end of the timestep 
-
-
     /*----------------------------------------------------------------------*/
-    // compute giuh runoff for the subtimestep
-    surface_runoff_subtimestep_cm = volrunoff_subtimestep_cm;
-    volrunoff_giuh_subtimestep_cm = giuh_convolution_integral(volrunoff_subtimestep_cm, num_giuh_ordinates, giuh_ordinates, giuh_runoff_queue);
-
-    surface_runoff_timestep_cm += surface_runoff_subtimestep_cm ;
-    volrunoff_giuh_timestep_cm += volrunoff_giuh_subtimestep_cm;
-
-    // total mass of water leaving the system, at this time it is the giuh-only, but later will add groundwater component as well.
-
-    volQ_timestep_cm += volrunoff_giuh_subtimestep_cm;
+    /* a substep with invalid wetting fronts, a negative runoff or a local mass balance error above the tolerance of
+       the precision profile is rolled back to its start and retried with half the step; the smallest substep is
+       accepted unless its error exceeds local_mass_error_max_cm */
+    int front_check = lgar_check_fronts(state->fronts);
+    bool substep_failed = front_check != FRONT_CHECK_OK || volrunoff_subtimestep_cm < 0.0
+                          || !(fabs(local_mb) <= state->lgar_bmi_params.precision.substep_mass_tolerance_cm);
+
+    // front_integrator=heun: what to do with this (Euler) predictor, see lgar_heun_dzdt
+    int heun_step = HEUN_KEEP_EULER;
+    if (state->lgar_bmi_params.front_integrator == FRONT_INTEGRATOR_HEUN && !heun_corrector && !substep_failed)
+      heun_step = lgar_heun_dzdt(subtimestep_h, state->lgar_bmi_params.precision.heun_tolerance_cm, state->state_previous,
+				 state->fronts, state->lgar_bmi_params.dzdt_corrector_cm_per_h);
+
+    if ((substep_failed || heun_step == HEUN_HALVE) && step_units > 1) {
+      heun_corrector = false;
+      listCopy(state->state_previous, state->fronts);
+      volend_subtimestep_cm = volend_previous_cm;
+      this->state->lgar_bmi_params.time_s     = time_start_s;
+      this->state->lgar_bmi_params.timesteps -= steps_completed;
+
+      units_limit = step_units / 2;
+      state->lgar_bmi_params.num_substep_rollbacks++;
+
+      if (verbosity.compare("high") == 0 || verbosity.compare("low") == 0)
+	std::cerr<<"Substep of "<< subtimestep_h * state->units.hr_to_sec <<" sec rolled back (local mass balance = "
+		 << local_mb <<", front check = "<< front_check <<", Heun front event = "<< (heun_step == HEUN_HALVE)
+		 <<"), retrying with half the step \n";
+
+      continue;
+    }
 
-    // adding groundwater flux to stream channel (note: this will be updated/corrected after adding the groundwater reservoir)
-    volQ_gw_timestep_cm += volQ_gw_subtimestep_cm;
-    
-    if (verbosity.compare("high") == 0 || verbosity.compare("low") == 0) {
-      printf("Printing wetting fronts at this subtimestep... \n");
-      listPrint(state->head);
+    /* front_integrator=heun: the substep is retaken from its start with the mean of dz/dt at the start and at the end
+       of this (Euler) predictor; the corrector is checked as any substep, and its dz/dt at the end starts the next one */
+    if (heun_step == HEUN_CORRECT) {
+      listCopy(state->state_previous, state->fronts);
+      memcpy(&state->fronts->dzdt_cm_per_h[1], &state->lgar_bmi_params.dzdt_corrector_cm_per_h[1],
+	     sizeof(double)*listLength(state->fronts));
+      volend_subtimestep_cm = volend_previous_cm;
+      this->state->lgar_bmi_params.time_s     = time_start_s;
+      this->state->lgar_bmi_params.timesteps -= steps_completed;
+
+      heun_corrector = true;
+      continue;
     }
 
-    bool unexpected_local_error = fabs(local_mb) > 1.0E-4 ? true : false;
+    if (heun_corrector)
+      state->lgar_bmi_params.num_heun_corrections++;
+    heun_corrector = false;
+
+    /* the smallest substep failed: it is not kept, the model stays at the end of the last accepted substep, whose
+       volumes are added to the mass balance below before the error is thrown */
+    bool unexpected_local_error = front_check != FRONT_CHECK_OK || volrunoff_subtimestep_cm < 0.0
+                                  || !(fabs(local_mb) <= state->lgar_bmi_params.precision.local_mass_error_max_cm);
     
     if (verbosity.compare("high") == 0 || verbosity.compare("low") == 0 || unexpected_local_error) {
       printf("\nLocal mass balance at this timestep... \n\
@@ -392,25 +508,78 @@ Update()
       Final water   = %14.10f \n", local_mb, volstart_subtimestep_cm, precip_subtimestep_cm, volon_subtimestep_cm,
 	     volin_subtimestep_cm, volrunoff_subtimestep_cm, AET_subtimestep_cm, volrech_subtimestep_cm,
 	     volend_subtimestep_cm);
+    }
 
-      if (unexpected_local_error) {
-	printf("Local mass balance (in this timestep) is %14.10f, larger than expected, needs some debugging...\n ",local_mb);
-	abort();
-      }
+    if (unexpected_local_error) {
+      listCopy(state->state_previous, state->fronts);
+      this->state->lgar_bmi_params.time_s     = time_start_s;
+      this->state->lgar_bmi_params.timesteps -= steps_completed;
+
+      std::stringstream errMsg;
+      errMsg << "Local mass balance (in this timestep) is "<< local_mb <<" cm (front check = "<< front_check
+	     <<", runoff = "<< volrunoff_subtimestep_cm <<" cm) at the smallest substep ("
+	     << subtimestep_h * state->units.hr_to_sec <<" sec), larger than expected, needs some debugging...";
+      local_error = errMsg.str();
+      break;
+    }
+
+    volend_timestep_cm = volend_subtimestep_cm;
+    state->lgar_bmi_params.precip_previous_timestep_cm = precip_subtimestep_cm;
+
+    precip_timestep_cm += precip_subtimestep_cm;
+    PET_timestep_cm += fmax(PET_subtimestep_cm,0.0); // ensures non-negative PET
+    volin_timestep_cm += volin_subtimestep_cm;
+    volrunoff_timestep_cm += volrunoff_subtimestep_cm;
+    volrech_timestep_cm += volrech_subtimestep_cm;
+    AET_timestep_cm += AET_subtimestep_cm;
+    volon_timestep_cm = volon_subtimestep_cm; // surface ponded water at the end of the timestep 
+
+
+    /*----------------------------------------------------------------------*/
+    // compute giuh runoff for the completed model timesteps (runoff of shorter substeps is routed at the end of
+    // their model timestep)
+    surface_runoff_subtimestep_cm = volrunoff_subtimestep_cm;
+    runoff_giuh_pending_cm += volrunoff_subtimestep_cm;
+
+    surface_runoff_timestep_cm += surface_runoff_subtimestep_cm ;
+
+    for (int step = 0; step < steps_completed; step++) {
+      volrunoff_giuh_subtimestep_cm = giuh_convolution_integral(runoff_giuh_pending_cm, num_giuh_ordinates, giuh_ordinates, giuh_runoff_queue);
+      runoff_giuh_pending_cm = 0.0;
+
+      volrunoff_giuh_timestep_cm += volrunoff_giuh_subtimestep_cm;
+
+      // total mass of water leaving the system, at this time it is the giuh-only, but later will add groundwater component as well.
+      volQ_timestep_cm += volrunoff_giuh_subtimestep_cm;
+    }
 
+    // adding groundwater flux to stream channel (note: this will be updated/corrected after adding the groundwater reservoir)
+    volQ_gw_timestep_cm += volQ_gw_subtimestep_cm;
+    
+    if (verbosity.compare("high") == 0 || verbosity.compare("low") == 0) {
+      printf("Printing wetting fronts at this subtimestep... \n");
+      listPrint(state->fronts);
     }
 
-    // store local mass balance error to the struct
+    // store local mass balance error to the struct, and its statistics (realized error of the precision profile)
     state->lgar_mass_balance.local_mass_balance = local_mb;
+    state->lgar_mass_balance.local_mass_balance_max_cm = fmax(state->lgar_mass_balance.local_mass_balance_max_cm,
+							      fabs(local_mb));
+    state->lgar_mass_balance.local_mass_balance_sum_cm += fabs(local_mb);
+    state->lgar_mass_balance.num_local_mass_balance++;
 
-    assert (state->head->depth_cm > 0.0); // check on negative layer depth --> move this to somewhere else AJ (later)
+    // histogram of the accepted substeps, a bin per power of two (bin LGAR_MAX_STEP_HALVINGS: the model timestep)
+    int bin = 0;
+    while ((2 << bin) <= step_units && bin < LGAR_SUBSTEP_BINS-1)
+      bin++;
+    state->lgar_bmi_params.substep_histogram[bin]++;
+
+    units_done += step_units;
+    units_limit = std::min(2*units_limit, units_cap);
 
-    bool lasam_standalone = true;
-#ifdef NGEN
-    lasam_standalone = false;
-#endif
     // simuation time can't exceed the endtime when running standalone
-    if ( (this->state->lgar_bmi_params.time_s >= this->state->lgar_bmi_params.endtime_s) && lasam_standalone)
+    if ( (this->state->lgar_bmi_params.time_s >= this->state->lgar_bmi_params.endtime_s) && lasam_standalone
+	 && steps_completed > 0)
       break;
 
   } // end of subcycling
@@ -419,19 +588,14 @@ Update()
   // Everything related to lgar state is done at this point, now time to update some dynamic variables
 
   // update number of wetting fronts
-  state->lgar_bmi_params.num_wetting_fronts = listLength(state->head);
-
-  // allocate new memory based on updated wetting fronts; we could make it conditional i.e. create only if no. of wf are changed
-  state->lgar_bmi_params.soil_depth_wetting_fronts = new double[state->lgar_bmi_params.num_wetting_fronts];
-  state->lgar_bmi_params.soil_moisture_wetting_fronts = new double[state->lgar_bmi_params.num_wetting_fronts];
+  state->lgar_bmi_params.num_wetting_fronts = listLength(state->fronts);
 
-  // update thickness/depth and soil moisture of wetting fronts (used for state coupling)
-  struct wetting_front *current = state->head;
+  // update thickness/depth and soil moisture of wetting fronts (used for state coupling);
+  // the output arrays hold up to MAX_NUM_WETTING_FRONTS and are allocated in the model arena
+  struct wetting_front_list *fronts = state->fronts;
   for (int i=0; i<state->lgar_bmi_params.num_wetting_fronts; i++) {
-    assert (current != NULL);
-    state->lgar_bmi_params.soil_moisture_wetting_fronts[i] = current->theta;
-    state->lgar_bmi_params.soil_depth_wetting_fronts[i] = current->depth_cm * state->units.cm_to_m;
-    current = current->next;
+    state->lgar_bmi_params.soil_moisture_wetting_fronts[i] = fronts->theta[i+1];
+    state->lgar_bmi_params.soil_depth_wetting_fronts[i] = fronts->depth_cm[i+1] * state->units.cm_to_m;
     if (verbosity.compare("high") == 0)
       std::cerr<<"Wetting fronts (bmi outputs) (depth in meters, theta)= "
 	       <<state->lgar_bmi_params.soil_depth_wetting_fronts[i]
@@ -477,7 +641,10 @@ Update()
   bmi_unit_conv.volQ_gw_timestep_m    = volQ_gw_timestep_cm * state->units.cm_to_m;
   bmi_unit_conv.volPET_timestep_m     = PET_timestep_cm * state->units.cm_to_m;
   bmi_unit_conv.volrunoff_giuh_timestep_m = volrunoff_giuh_timestep_cm * state->units.cm_to_m;
-  
+
+  // a failed smallest substep stops the model, its accepted substeps accounted
+  if (!local_error.empty())
+    throw std::runtime_error(local_error);
 }
 
 
@@ -493,6 +660,16 @@ struct model_state* BmiLGAR::get_model()
   return state;
 }
 
+/*
+  Returns the number of bytes held by this instance (the bmi object, the model state and its arrays);
+  useful for sizing the number of catchments that fit on a node
+*/
+size_t BmiLGAR::
+GetMemoryFootprint()
+{
+  return sizeof(BmiLGAR) + lgar_memory_footprint(this->state);
+}
+
 void BmiLGAR::
 global_mass_balance()
 {
@@ -503,18 +680,16 @@ double BmiLGAR::
 update_calibratable_parameters()
 {
   int soil, layer_num;
-  struct wetting_front *current = state->head;
+  struct wetting_front_list *fronts = state->fronts;
 
   if (verbosity.compare("high") == 0)
-    listPrint(state->head);
+    listPrint(state->fronts);
   
-  double volstart_before = lgar_calc_mass_bal(state->lgar_bmi_params.cum_layer_thickness_cm, state->head);
+  double volstart_before = lgar_calc_mass_bal(state->lgar_bmi_params.cum_layer_thickness_cm, state->fronts);
 
-  for (int i=0; i<state->lgar_bmi_params.num_wetting_fronts; i++) {//first we update the parameters that depend on soil layer, for each layer
-    layer_num  = current->layer_num;
+  for (int wf=1; wf<=state->lgar_bmi_params.num_wetting_fronts; wf++) {//first we update the parameters that depend on soil layer, for each layer
+    layer_num  = fronts->layer_num[wf];
     soil = state->lgar_bmi_params.layer_soil_type[layer_num];
-    
-    assert (current != NULL);
 
     if (verbosity.compare("high") == 0 || verbosity.compare("low") == 0) {
       std::cerr<<"----------- Calibratable parameters depending on soil layer (initial values) ----------- \n";
@@ -524,19 +699,19 @@ update_calibratable_parameters()
 	       <<", vg_n = "     << state->soil_properties[soil].vg_n
 	       <<", vg_alpha = " << state->soil_properties[soil].vg_alpha_per_cm
 	       <<", Ksat = "     << state->soil_properties[soil].Ksat_cm_per_h
-	       <<", theta = "    << current->theta <<"\n";
+	       <<", theta = "    << fronts->theta[wf] <<"\n";
     }
     
     state->soil_properties[soil].theta_e = state->lgar_calib_params.theta_e[layer_num-1];
     state->soil_properties[soil].theta_r = state->lgar_calib_params.theta_r[layer_num-1];
     state->soil_properties[soil].vg_n    = state->lgar_calib_params.vg_n[layer_num-1];
-    state->soil_properties[soil].vg_m    = 1.0 - 1.0/state->soil_properties[soil].vg_n;
     state->soil_properties[soil].vg_alpha_per_cm = state->lgar_calib_params.vg_alpha[layer_num-1];
     state->soil_properties[soil].Ksat_cm_per_h   = state->lgar_calib_params.Ksat[layer_num-1];
+
+    // vg_m, Brooks & Corey parameters, h_min and the kernel constants follow the new parameters (tables are detached)
+    lgar_update_soil_constants(&state->soil_properties[soil], state->lgar_bmi_params.wilting_point_psi_cm);
     
-    current->theta = calc_theta_from_h(current->psi_cm, state->soil_properties[soil].vg_alpha_per_cm,
-				       state->soil_properties[soil].vg_m, state->soil_properties[soil].vg_n,
-				       state->soil_properties[soil].theta_e, state->soil_properties[soil].theta_r);
+    fronts->theta[wf] = calc_theta_from_h(fronts->psi_cm[wf], &state->soil_properties[soil]);
 
     if (verbosity.compare("high") == 0 || verbosity.compare("low") == 0) {
       std::cerr<<"----------- Calibratable parameters depending on soil layer (updated values) ----------- \n";
@@ -546,10 +721,8 @@ update_calibratable_parameters()
 	       <<", vg_n = "     << state->soil_properties[soil].vg_n
 	       <<", vg_alpha = " << state->soil_properties[soil].vg_alpha_per_cm
 	       <<", Ksat = "     << state->soil_properties[soil].Ksat_cm_per_h
-	       <<", theta = "    << current->theta <<"\n";
+	       <<", theta = "    << fronts->theta[wf] <<"\n";
     }
-    
-    current = current->next;
   }
 
   //next we update the parameters that apply to the whole model domain and do not depend on soil layer
@@ -569,9 +742,9 @@ update_calibratable_parameters()
   }
   
   if (verbosity.compare("high") == 0)
-    listPrint(state->head);
+    listPrint(state->fronts);
   
-  double volstart_after = lgar_calc_mass_bal(state->lgar_bmi_params.cum_layer_thickness_cm, state->head);
+  double volstart_after = lgar_calc_mass_bal(state->lgar_bmi_params.cum_layer_thickness_cm, state->fronts);
 
   if (verbosity.compare("high") == 0 || verbosity.compare("low") == 0)
     std::cerr<<"Mass of water (before and after) = "<< volstart_before<<", "<< volstart_after <<"\n";
@@ -583,13 +756,28 @@ void BmiLGAR::
 Finalize()
 {
   global_mass_balance();
+
+  // release the wetting front storage of this instance
+  listFree(state->state_previous);
+  listFree(state->fronts);
+  listPoolFree(state->front_pool);
+
+  state->state_previous = NULL;
+  state->fronts         = NULL;
+  state->front_pool     = NULL;
+
+  // release the per-instance arrays
+  lgar_arena_free(state);
+  giuh_ordinates    = NULL;
+  giuh_runoff_queue = NULL;
 }
 
 
 int BmiLGAR::
 GetVarGrid(std::string name)
 {
-  if (name.compare("soil_storage_model") == 0 || name.compare("soil_num_wetting_fronts") == 0)   // int
+  if (name.compare("soil_storage_model") == 0 || name.compare("soil_num_wetting_fronts") == 0
+      || name.compare("precision_profile") == 0)   // int
     return 0;
   else if (name.compare("precipitation_rate") == 0 || name.compare("precipitation") == 0)
     return 1;
@@ -817,8 +1005,11 @@ GetValuePtr (std::string name)
     return (void*)this->state->lgar_bmi_params.soil_depth_wetting_fronts;
   else if (name.compare("soil_num_wetting_fronts") == 0)
     return (void*)(&state->lgar_bmi_params.num_wetting_fronts);
-  else if (name.compare("soil_temperature_profile") == 0)
+  else if (name.compare("soil_temperature_profile") == 0) {
+    // allocated on first use when not coupled to soil freeze-thaw
+    lgar_soil_temperature_alloc(this->state);
     return (void*)this->state->lgar_bmi_params.soil_temperature;
+  }
   else if (name.compare("smcmax") == 0)
     return (void*)this->state->lgar_calib_params.theta_e;
   else if (name.compare("smcmin") == 0)
@@ -833,6 +1024,8 @@ GetValuePtr (std::string name)
     return (void*)&this->state->lgar_calib_params.ponded_depth_max;
   else if (name.compare("field_capacity") == 0)
     return (void*)&this->state->lgar_calib_params.field_capacity_psi;
+  else if (name.compare("precision_profile") == 0)
+    return (void*)&this->state->lgar_bmi_params.precision_profile;
   else {
     std::stringstream errMsg;
     errMsg << "variable "<< name << " does not exist";
@@ -154,7 +154,7 @@ int main(int argc, char *argv[])
 
       // write layers data to file
       fprintf(outlayer_fptr,"# Timestep = %d, %s \n", i, time[i].c_str());
-      write_state(outlayer_fptr, model_state.get_model()->head);
+      write_state(outlayer_fptr, model_state.get_model()->fronts);
     }
 
   }
@@ -261,18 +261,15 @@ ReadForcingData(std::string config_file, std::vector<std::string>& time, std::ve
 }
 
 
-extern void write_state(FILE *out, struct wetting_front* head){
-
-  struct wetting_front *current = head;
+extern void write_state(FILE *out, struct wetting_front_list* fronts){
 
   fprintf(out, "[");
-  while(current != NULL)
+  for (int wf = 1; wf <= listLength(fronts); wf++)
   {
-    if (current == head)
-      fprintf(out,"(%lf,%lf,%d,%d,%lf)",current->depth_cm*10., current->theta, current->layer_num,current->front_num, current->psi_cm*10.);
+    if (wf == 1)
+      fprintf(out,"(%lf,%lf,%d,%d,%lf)",fronts->depth_cm[wf]*10., fronts->theta[wf], fronts->layer_num[wf], wf, fronts->psi_cm[wf]*10.);
     else
-      fprintf(out,"|(%lf,%lf,%d,%d,%lf)",current->depth_cm*10., current->theta, current->layer_num,current->front_num, current->psi_cm*10.);
-  current = current->next;
+      fprintf(out,"|(%lf,%lf,%d,%d,%lf)",fronts->depth_cm[wf]*10., fronts->theta[wf], fronts->layer_num[wf], wf, fronts->psi_cm[wf]*10.);
   }
   fprintf(out, "]\n");
 
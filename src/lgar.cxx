@@ -79,38 +79,28 @@ extern void lgar_initialize(string config_file, struct model_state *state)
   state->lgar_bmi_params.shape[1] = state->lgar_bmi_params.num_wetting_fronts;
 
   // initial number of wetting fronts are same are number of layers
+  // (the wetting front output arrays and the calibratable parameter arrays are allocated in the arena)
   state->lgar_bmi_params.num_wetting_fronts           = state->lgar_bmi_params.num_layers;
-  state->lgar_bmi_params.soil_depth_wetting_fronts    = new double[state->lgar_bmi_params.num_wetting_fronts];
-  state->lgar_bmi_params.soil_moisture_wetting_fronts = new double[state->lgar_bmi_params.num_wetting_fronts];
-
-  // initialize array for holding calibratable parameters
-  state->lgar_calib_params.theta_e  = new double[state->lgar_bmi_params.num_layers];
-  state->lgar_calib_params.theta_r  = new double[state->lgar_bmi_params.num_layers];
-  state->lgar_calib_params.vg_n     = new double[state->lgar_bmi_params.num_layers];
-  state->lgar_calib_params.vg_alpha = new double[state->lgar_bmi_params.num_layers];
-  state->lgar_calib_params.Ksat     = new double[state->lgar_bmi_params.num_layers];
-  
+
   // initialize thickness/depth and soil moisture of wetting fronts (used for model coupling)
   // also initialize calibratable parameters
   state->lgar_calib_params.field_capacity_psi = state->lgar_bmi_params.field_capacity_psi_cm;
   state->lgar_calib_params.ponded_depth_max = state->lgar_bmi_params.ponded_depth_max_cm;
 
-  struct wetting_front *current = state->head;
+  struct wetting_front_list *fronts = state->fronts;
+  assert (listLength(fronts) == state->lgar_bmi_params.num_wetting_fronts);
+
   for (int i=0; i<state->lgar_bmi_params.num_wetting_fronts; i++) {
-    assert (current != NULL);
-    
     soil = state->lgar_bmi_params.layer_soil_type[i+1];
 
-    state->lgar_bmi_params.soil_moisture_wetting_fronts[i] = current->theta;
-    state->lgar_bmi_params.soil_depth_wetting_fronts[i]    = current->depth_cm * state->units.cm_to_m;
+    state->lgar_bmi_params.soil_moisture_wetting_fronts[i] = fronts->theta[i+1];
+    state->lgar_bmi_params.soil_depth_wetting_fronts[i]    = fronts->depth_cm[i+1] * state->units.cm_to_m;
 
     state->lgar_calib_params.theta_e[i]  = state->soil_properties[soil].theta_e;
     state->lgar_calib_params.theta_r[i]  = state->soil_properties[soil].theta_r;
     state->lgar_calib_params.vg_n[i]     = state->soil_properties[soil].vg_n;
     state->lgar_calib_params.vg_alpha[i] = state->soil_properties[soil].vg_alpha_per_cm;
     state->lgar_calib_params.Ksat[i]     = state->soil_properties[soil].Ksat_cm_per_h;
-    
-    current = current->next;
   }
 
 
@@ -136,6 +126,9 @@ extern void lgar_initialize(string config_file, struct model_state *state)
   state->lgar_mass_balance.volQ_gw_timestep_cm       = 0.0; /* setting flux from groundwater_reservoir_to_stream to zero,
 							       will be non-zero when groundwater reservoir is added/simulated */
   state->lgar_mass_balance.volchange_calib_cm        = 0.0;
+  state->lgar_mass_balance.local_mass_balance_max_cm = 0.0;
+  state->lgar_mass_balance.local_mass_balance_sum_cm = 0.0;
+  state->lgar_mass_balance.num_local_mass_balance    = 0;
 }
 
 
@@ -154,7 +147,7 @@ extern void lgar_initialize(string config_file, struct model_state *state)
   @param timestep_h             : model timestep in hours
   @param forcing_resolution_h   : forcing resolution in hours
   @param forcing_interval       : factor equals to forcing_resolution_h/timestep_h (used to determine model subtimestep's forcings)
-  @param num_soil_types         : number of soil types; must be less than or equal to MAX_NUM_SOIL_TYPES
+  @param num_soil_types         : number of soil types (max_soil_types); any number of soil types and layers is supported
   @param AET_cm                 : actual evapotranspiration in cm
   @param soil_temperature       : 1D (double) array of soil temperature [K]; bmi input for coupling lasam to soil freeze thaw model
   @param soil_temperature_z     : 1D (double) array of soil discretization associated with temperature profile [m];
@@ -165,7 +158,30 @@ extern void lgar_initialize(string config_file, struct model_state *state)
   @param field_capacity_psi_cm  : field capacity, represented with a capillary head (head above which drainage is much faster)
   @param ponded_depth_cm        : amount of water on the surface not available for surface drainage (initialized to zero)
   @param ponded_depth_max cm    : maximum amount of water on the surface not available for surface drainage (default is zero)
-  @param nint                   : number of trapezoids used in integrating the Geff function (set to 120)
+  @param coalesce_theta_tolerance   : optional; merge adjacent wetting fronts of a layer whose theta difference is below this value
+  @param coalesce_mass_tolerance_cm : optional; merge a wetting front into the one above if it holds less water [cm] than this value
+  @param geff_tolerance         : optional; relative error tolerance of the adaptive quadrature of the Geff function (default 1e-6);
+                                  soils whose closed form Geff agrees with the integral within this tolerance use the closed form
+  @param geff_table             : optional; if true (default), the numeric Geff interpolates per soil tables of the cumulative
+                                  K(h) integral, built at their first use, instead of integrating at every call where they
+                                  meet geff_tolerance
+  @param vg_table               : optional; if true, theta(h), h(Se) and K(Se) are interpolated from per soil tables instead of
+                                  evaluated from the van Genuchten formulas (default false); see calc_vg_table
+  @param psi_search_candidates  : optional; number of trial heads (2 to LGAR_MAX_PSI_CANDIDATES) evaluated at once with the
+                                  batch functions by the psi search of the mass balance (default 0, one at a time); see
+                                  lgar_theta_mass_balance
+  @param batch_kernels          : optional; instruction set of the batch van Genuchten functions, scalar (default), sse2, avx2 or
+                                  avx512; the vector kernels are faster but round differently from the scalar functions; see
+                                  soil_batch.cxx
+  @param adaptive_timestep      : optional; if true, substeps without rain or ponded water grow in powers of two up to the forcing
+                                  timestep while no wetting front moves more than adaptive_front_move_cm (default false); see
+                                  BmiLGAR::Update
+  @param front_integrator       : optional; integrator of the wetting front depths, euler (default) or heun (predictor-corrector,
+                                  allows longer model timesteps); see BmiLGAR::Update
+  @param adaptive_front_move_cm : optional; largest distance a wetting front may move in a grown substep [cm] (default 1)
+  @param precision_profile      : optional; reference (default), operational or screening: tolerances and iteration caps of
+                                  the mass balance, free drainage and Geff computations, and the local mass balance error
+                                  the model aborts at; see lgar_set_precision_profile (geff_tolerance, if given, prevails)
   @param time_s                 : current time [s] (initially set to zero)
   @param sft_coupled            : model coupling flag. if true, lasam is coupled to soil freeze thaw model; default is uncoupled version
   @param giuh_ordinates         : geomorphological instantaneous unit hydrograph
@@ -178,7 +194,7 @@ extern void InitFromConfigFile(string config_file, struct model_state *state)
 
   ifstream fp; //FILE *fp = fopen(config_file.c_str(),"r");
   fp.open(config_file);
-  //struct wetting_front* head = state->head;
+  //struct wetting_front_list* fronts = state->fronts;
   
   // loop over the variables in the file to see if verbosity is provided, if not default is "none" (prints nothing)
   while (fp) {
@@ -232,6 +248,11 @@ extern void InitFromConfigFile(string config_file, struct model_state *state)
 
   // a temporary array to store the original (hourly based) giuh values
   std::vector<double> giuh_ordinates_temp;
+
+  // temporary arrays for the layer and soil temperature data; copied into the instance arena once all sizes are known
+  std::vector<double> layer_thickness_temp;
+  std::vector<double> layer_soil_type_temp;
+  std::vector<double> soil_z_temp;
  
   while (fp) {
 
@@ -254,42 +275,15 @@ extern void InitFromConfigFile(string config_file, struct model_state *state)
     param_value = line.substr(loc_eq,loc_u - loc_eq);
     
     if (param_key == "layer_thickness") {
-      vector<double> vec = ReadVectorData(param_value);
+      layer_thickness_temp = ReadVectorData(param_value);
 
-      state->lgar_bmi_params.layer_thickness_cm = new double[vec.size()+1];
-      state->lgar_bmi_params.cum_layer_thickness_cm = new double[vec.size()+1];
-
-      state->lgar_bmi_params.layer_thickness_cm[0] = 0.0; // the value at index 0 is never used
-      // calculate the cumulative (absolute) depth from land surface to bottom of each soil layer
-      state->lgar_bmi_params.cum_layer_thickness_cm[0] = 0.0;
-
-      for (unsigned int layer=1; layer <= vec.size(); layer++) {
-      	state->lgar_bmi_params.layer_thickness_cm[layer] = vec[layer-1];
-	state->lgar_bmi_params.cum_layer_thickness_cm[layer] = state->lgar_bmi_params.cum_layer_thickness_cm[layer-1] + vec[layer-1];
-      }
-
-      state->lgar_bmi_params.num_layers = vec.size();
-
-      state->lgar_bmi_params.soil_depth_cm = state->lgar_bmi_params.cum_layer_thickness_cm[state->lgar_bmi_params.num_layers];
+      state->lgar_bmi_params.num_layers = layer_thickness_temp.size();
       is_layer_thickness_set = true;
 
-      if (verbosity.compare("high") == 0) {
-	std::cerr<<"Number of layers : "<<state->lgar_bmi_params.num_layers<<"\n";
-	for (int i=1; i<=state->lgar_bmi_params.num_layers; i++)
-	  std::cerr<<"Thickness, cum. depth : "<<state->lgar_bmi_params.layer_thickness_cm[i]<<" , "
-		   <<state->lgar_bmi_params.cum_layer_thickness_cm[i]<<"\n";
-	std::cerr<<"          *****         \n";
-      }
-
       continue;
     }
     else if (param_key == "layer_soil_type") {
-      vector<double> vec = ReadVectorData(param_value);
-
-      state->lgar_bmi_params.layer_soil_type = new int[vec.size()+1];
-
-      for (unsigned int layer=1; layer <= vec.size(); layer++)
-      	state->lgar_bmi_params.layer_soil_type[layer] = vec[layer-1];
+      layer_soil_type_temp = ReadVectorData(param_value);
 
       is_layer_soil_type_set = true;
 
@@ -315,20 +309,13 @@ extern void InitFromConfigFile(string config_file, struct model_state *state)
       continue;
     }
     else if (param_key == "soil_z") {
-      vector<double> vec = ReadVectorData(param_value);
-
-      state->lgar_bmi_params.soil_temperature_z = new double[vec.size()];
-
-      for (unsigned int i=0; i < vec.size(); i++)
-      	state->lgar_bmi_params.soil_temperature_z[i] = vec[i];
-
-      state->lgar_bmi_params.num_cells_temp = vec.size();
+      soil_z_temp = ReadVectorData(param_value);
 
       is_soil_z_set = true;
 
       if (verbosity.compare("high") == 0) {
-	for (int i=0; i<state->lgar_bmi_params.num_cells_temp; i++)
-	  std::cerr<<"Soil z (temperature resolution) : "<<state->lgar_bmi_params.soil_temperature_z[i]<<"\n";
+	for (unsigned int i=0; i < soil_z_temp.size(); i++)
+	  std::cerr<<"Soil z (temperature resolution) : "<<soil_z_temp[i]<<"\n";
 
 	std::cerr<<"          *****         \n";
       }
@@ -486,6 +473,190 @@ extern void InitFromConfigFile(string config_file, struct model_state *state)
 
       continue;
     }
+    else if (param_key == "coalesce_theta_tolerance") {
+      state->lgar_bmi_params.coalesce_theta_tolerance = fmax(stod(param_value), 0.0);
+
+      if (verbosity.compare("high") == 0) {
+	std::cerr<<"Coalescing wetting fronts, theta tolerance : "<<state->lgar_bmi_params.coalesce_theta_tolerance<<"\n";
+	std::cerr<<"          *****         \n";
+      }
+
+      continue;
+    }
+    else if (param_key == "coalesce_mass_tolerance") {
+      state->lgar_bmi_params.coalesce_mass_tolerance_cm = fmax(stod(param_value), 0.0);
+
+      if (param_unit == "[mm]")
+	state->lgar_bmi_params.coalesce_mass_tolerance_cm *= 0.1;
+
+      if (verbosity.compare("high") == 0) {
+	std::cerr<<"Coalescing wetting fronts, mass tolerance [cm] : "<<state->lgar_bmi_params.coalesce_mass_tolerance_cm<<"\n";
+	std::cerr<<"          *****         \n";
+      }
+
+      continue;
+    }
+    else if (param_key == "geff_tolerance") {
+      state->lgar_bmi_params.geff_tolerance = stod(param_value);
+
+      if (state->lgar_bmi_params.geff_tolerance <= 0.0) {
+	std::cerr<<"Invalid option: geff_tolerance must be greater than zero. \n";
+        abort();
+      }
+
+      state->lgar_bmi_params.is_geff_tolerance_set = true;
+
+      if (verbosity.compare("high") == 0) {
+	std::cerr<<"Geff quadrature tolerance : "<<state->lgar_bmi_params.geff_tolerance<<"\n";
+	std::cerr<<"          *****         \n";
+      }
+
+      continue;
+    }
+    else if (param_key == "geff_table") {
+      if (param_value == "true") {
+	state->lgar_bmi_params.geff_table = true;
+      }
+      else if (param_value == "false") {
+	state->lgar_bmi_params.geff_table = false;
+      }
+      else {
+	std::cerr<<"Invalid option: geff_table must be true or false. \n";
+        abort();
+      }
+
+      continue;
+    }
+    else if (param_key == "vg_table") {
+      if (param_value == "true") {
+	state->lgar_bmi_params.vg_table = true;
+      }
+      else if (param_value == "false") {
+	state->lgar_bmi_params.vg_table = false;
+      }
+      else {
+	std::cerr<<"Invalid option: vg_table must be true or false. \n";
+        abort();
+      }
+
+      continue;
+    }
+    else if (param_key == "psi_search_candidates") {
+      state->lgar_bmi_params.psi_search_candidates = stoi(param_value);
+
+      if (state->lgar_bmi_params.psi_search_candidates != 0 && (state->lgar_bmi_params.psi_search_candidates < 2
+	  || state->lgar_bmi_params.psi_search_candidates > LGAR_MAX_PSI_CANDIDATES)) {
+	std::cerr<<"Invalid option: psi_search_candidates must be 0 or between 2 and "<<LGAR_MAX_PSI_CANDIDATES<<". \n";
+        abort();
+      }
+
+      if (verbosity.compare("high") == 0) {
+	std::cerr<<"Trial heads per evaluation of the psi search : "<<state->lgar_bmi_params.psi_search_candidates<<"\n";
+	std::cerr<<"          *****         \n";
+      }
+
+      continue;
+    }
+    else if (param_key == "batch_kernels") {
+      if (param_value == "scalar") {
+	state->lgar_bmi_params.batch_kernels = SOIL_BATCH_SCALAR;
+      }
+      else if (param_value == "sse2") {
+	state->lgar_bmi_params.batch_kernels = SOIL_BATCH_SSE2;
+      }
+      else if (param_value == "avx2") {
+	state->lgar_bmi_params.batch_kernels = SOIL_BATCH_AVX2;
+      }
+      else if (param_value == "avx512") {
+	state->lgar_bmi_params.batch_kernels = SOIL_BATCH_AVX512;
+      }
+      else {
+	std::cerr<<"Invalid option: batch_kernels must be scalar, sse2, avx2 or avx512. \n";
+        abort();
+      }
+
+      if (!soil_batch_supported(state->lgar_bmi_params.batch_kernels)) {
+	std::cerr<<"Invalid option: batch_kernels "<<param_value<<" is not supported by this build or processor. \n";
+        abort();
+      }
+
+      if (verbosity.compare("high") == 0) {
+	std::cerr<<"Instruction set of the batch functions : "<<soil_batch_name(state->lgar_bmi_params.batch_kernels)<<"\n";
+	std::cerr<<"          *****         \n";
+      }
+
+      continue;
+    }
+    else if (param_key == "adaptive_timestep") {
+      if (param_value == "true") {
+	state->lgar_bmi_params.adaptive_timestep = true;
+      }
+      else if (param_value == "false") {
+	state->lgar_bmi_params.adaptive_timestep = false;
+      }
+      else {
+	std::cerr<<"Invalid option: adaptive_timestep must be true or false. \n";
+        abort();
+      }
+
+      continue;
+    }
+    else if (param_key == "front_integrator") {
+      if (param_value == "euler") {
+	state->lgar_bmi_params.front_integrator = FRONT_INTEGRATOR_EULER;
+      }
+      else if (param_value == "heun") {
+	state->lgar_bmi_params.front_integrator = FRONT_INTEGRATOR_HEUN;
+      }
+      else {
+	std::cerr<<"Invalid option: front_integrator must be euler or heun. \n";
+        abort();
+      }
+
+      if (verbosity.compare("high") == 0) {
+	std::cerr<<"Wetting front integrator : "<<param_value<<"\n";
+	std::cerr<<"          *****         \n";
+      }
+
+      continue;
+    }
+    else if (param_key == "adaptive_front_move_cm") {
+      state->lgar_bmi_params.adaptive_front_move_cm = stod(param_value);
+
+      if (!(state->lgar_bmi_params.adaptive_front_move_cm > 0.0)) {
+	std::cerr<<"Invalid option: adaptive_front_move_cm must be greater than zero. \n";
+        abort();
+      }
+
+      if (verbosity.compare("high") == 0) {
+	std::cerr<<"Largest front move in an adaptive substep [cm] : "<<state->lgar_bmi_params.adaptive_front_move_cm<<"\n";
+	std::cerr<<"          *****         \n";
+      }
+
+      continue;
+    }
+    else if (param_key == "precision_profile") {
+      if (param_value == "reference") {
+	state->lgar_bmi_params.precision_profile = PRECISION_REFERENCE;
+      }
+      else if (param_value == "operational") {
+	state->lgar_bmi_params.precision_profile = PRECISION_OPERATIONAL;
+      }
+      else if (param_value == "screening") {
+	state->lgar_bmi_params.precision_profile = PRECISION_SCREENING;
+      }
+      else {
+	std::cerr<<"Invalid option: precision_profile must be reference, operational or screening. \n";
+        abort();
+      }
+
+      if (verbosity.compare("high") == 0) {
+	std::cerr<<"Precision profile : "<<precision_profile_name(state->lgar_bmi_params.precision_profile)<<"\n";
+	std::cerr<<"          *****         \n";
+      }
+
+      continue;
+    }
     else if (param_key == "calib_params") {
       if (param_value == "true") {
 	state->lgar_bmi_params.calib_params_flag = 1;
@@ -530,39 +701,12 @@ extern void InitFromConfigFile(string config_file, struct model_state *state)
     throw runtime_error(errMsg.str());
   }
     
-  if(is_soil_params_file_set) {
-    //allocate memory to create an array of structures to hold the soils properties data.
-    //state->soil_properties = (struct soil_properties_*) malloc((state->lgar_bmi_params.num_layers+1)*sizeof(struct soil_properties_));
-
-
-    state->soil_properties = new soil_properties_[state->lgar_bmi_params.num_soil_types+1];
-    int num_soil_types = state->lgar_bmi_params.num_soil_types;
-    double wilting_point_psi_cm = state->lgar_bmi_params.wilting_point_psi_cm;
-    double field_capacity_psi_cm = state->lgar_bmi_params.field_capacity_psi_cm;
-    int max_num_soil_in_file = lgar_read_vG_param_file(soil_params_file.c_str(), num_soil_types,
-						       wilting_point_psi_cm, state->soil_properties);
-
-    // check if soil layers provided are within the range
-    for (int layer=1; layer <= state->lgar_bmi_params.num_layers; layer++) {
-      assert (state->lgar_bmi_params.layer_soil_type[layer] <= state->lgar_bmi_params.num_soil_types);
-      assert (state->lgar_bmi_params.layer_soil_type[layer] <= max_num_soil_in_file);
-    }
-
-    if (verbosity.compare("high") == 0) {
-      for (int layer=1; layer<=state->lgar_bmi_params.num_layers; layer++) {
-	int soil = state->lgar_bmi_params.layer_soil_type[layer];
-	std::cerr<<"Soil type/name : "<<state->lgar_bmi_params.layer_soil_type[layer]
-		 <<" "<<state->soil_properties[soil].soil_name<<"\n";
-      }
-      std::cerr<<"          *****         \n";
-    }
-  }
-  else {
+  if (!is_soil_params_file_set) {
     stringstream errMsg;
     errMsg << "The configuration file \'" << config_file <<"\' does not set soil_params_file. \n";
     throw runtime_error(errMsg.str());
   }
-  
+
   if (!is_layer_thickness_set) {
     stringstream errMsg;
     errMsg << "The configuration file \'" << config_file <<"\' does not set layer_thickness. \n";
@@ -606,46 +750,117 @@ extern void InitFromConfigFile(string config_file, struct model_state *state)
   }
 
 
-  if (is_giuh_ordinates_set) {
-    int factor = int(1.0/state->lgar_bmi_params.timestep_h);
-
-    state->lgar_bmi_params.num_giuh_ordinates = factor * (giuh_ordinates_temp.size() - 1);
-    state->lgar_bmi_params.giuh_ordinates = new double[state->lgar_bmi_params.num_giuh_ordinates+1];
-    
-    for (int i=0; i<giuh_ordinates_temp.size()-1; i++) {
-      for (int j=0; j<factor; j++) {
-	int index = j + i * factor + 1;
-	state->lgar_bmi_params.giuh_ordinates[index] = giuh_ordinates_temp[i+1]/double(factor);
-      }
-    }
-    
-    if (verbosity.compare("high") == 0) {
-      for (int i=1; i<=state->lgar_bmi_params.num_giuh_ordinates; i++)
-	std::cerr<<"GIUH ordinates (scaled) : "<<state->lgar_bmi_params.giuh_ordinates[i]<<"\n";
-      
-      std::cerr<<"          *****         \n";
-    }
-    
-    giuh_ordinates_temp.clear();
-  }
-  else if (!is_giuh_ordinates_set) {
+  if (!is_giuh_ordinates_set) {
     stringstream errMsg;
     errMsg << "The configuration file \'" << config_file <<"\' does not set giuh_ordinates. \n";
     throw runtime_error(errMsg.str());
   }
 
-  if (state->lgar_bmi_params.sft_coupled) {
-    state->lgar_bmi_params.soil_temperature = new double[state->lgar_bmi_params.num_cells_temp]();
-    if (!is_soil_z_set) {
-      stringstream errMsg;
-      errMsg << "The configuration file \'" << config_file <<"\' does not set soil_z. \n";
-      throw runtime_error(errMsg.str());
+  if (state->lgar_bmi_params.sft_coupled && !is_soil_z_set) {
+    stringstream errMsg;
+    errMsg << "The configuration file \'" << config_file <<"\' does not set soil_z. \n";
+    throw runtime_error(errMsg.str());
+  }
+
+  int giuh_factor = int(1.0/state->lgar_bmi_params.timestep_h);
+  state->lgar_bmi_params.num_giuh_ordinates = giuh_factor * (giuh_ordinates_temp.size() - 1);
+
+  // the soil temperature profile is only needed when coupled to soil freeze-thaw, otherwise it is allocated
+  // on first use (see lgar_soil_temperature_alloc)
+  state->lgar_bmi_params.num_cells_temp = state->lgar_bmi_params.sft_coupled ? soil_z_temp.size() : 1;
+
+  // one Geff table and one van Genuchten table per soil type of the column
+  int num_column_soils = 0;
+  for (unsigned int layer=0; layer < layer_soil_type_temp.size() && layer < (unsigned int)state->lgar_bmi_params.num_layers; layer++) {
+    bool soil_done = false;  // the soil of an overlying layer
+    for (unsigned int k=0; k < layer; k++)
+      soil_done = soil_done || layer_soil_type_temp[k] == layer_soil_type_temp[layer];
+    if (!soil_done)
+      num_column_soils++;
+  }
+
+  state->lgar_bmi_params.num_geff_tables = state->lgar_bmi_params.geff_table ? num_column_soils : 0;
+  state->lgar_bmi_params.num_vg_tables   = state->lgar_bmi_params.vg_table ? num_column_soils : 0;
+
+  // all sizes are known at this point; allocate the per-instance arrays in one block
+  lgar_arena_create(state);
+
+  // layer thicknesses and cumulative (absolute) depth from land surface to bottom of each soil layer
+  state->lgar_bmi_params.layer_thickness_cm[0]     = 0.0; // the value at index 0 is never used
+  state->lgar_bmi_params.cum_layer_thickness_cm[0] = 0.0;
+
+  for (int layer=1; layer <= state->lgar_bmi_params.num_layers; layer++) {
+    state->lgar_bmi_params.layer_thickness_cm[layer]     = layer_thickness_temp[layer-1];
+    state->lgar_bmi_params.cum_layer_thickness_cm[layer] = state->lgar_bmi_params.cum_layer_thickness_cm[layer-1] + layer_thickness_temp[layer-1];
+  }
+
+  state->lgar_bmi_params.soil_depth_cm = state->lgar_bmi_params.cum_layer_thickness_cm[state->lgar_bmi_params.num_layers];
+
+  if (verbosity.compare("high") == 0) {
+    std::cerr<<"Number of layers : "<<state->lgar_bmi_params.num_layers<<"\n";
+    for (int i=1; i<=state->lgar_bmi_params.num_layers; i++)
+      std::cerr<<"Thickness, cum. depth : "<<state->lgar_bmi_params.layer_thickness_cm[i]<<" , "
+	       <<state->lgar_bmi_params.cum_layer_thickness_cm[i]<<"\n";
+    std::cerr<<"          *****         \n";
+  }
+
+  for (unsigned int layer=1; layer <= layer_soil_type_temp.size() && layer <= (unsigned int)state->lgar_bmi_params.num_layers; layer++)
+    state->lgar_bmi_params.layer_soil_type[layer] = layer_soil_type_temp[layer-1];
+
+  // soil properties of all soil types
+  int num_soil_types = state->lgar_bmi_params.num_soil_types;
+  double wilting_point_psi_cm = state->lgar_bmi_params.wilting_point_psi_cm;
+  int max_num_soil_in_file = lgar_read_vG_param_file(soil_params_file.c_str(), num_soil_types,
+						     wilting_point_psi_cm, state->soil_properties);
+
+  // tolerances and iteration caps of the precision profile; a geff_tolerance given in the config file prevails
+  double geff_tolerance_set = state->lgar_bmi_params.geff_tolerance;
+  lgar_set_precision_profile(state->lgar_bmi_params.precision_profile, &state->lgar_bmi_params.precision,
+			     &state->lgar_bmi_params.geff_tolerance);
+
+  if (state->lgar_bmi_params.is_geff_tolerance_set) {
+    state->lgar_bmi_params.geff_tolerance           = geff_tolerance_set;
+    state->lgar_bmi_params.precision.geff_tolerance = geff_tolerance_set;
+  }
+
+  // all soils evaluate their batch functions in the instruction set of the model
+  for (int soil=1; soil <= num_soil_types; soil++)
+    state->soil_properties[soil].batch_isa = state->lgar_bmi_params.batch_kernels;
+
+  // check if soil layers provided are within the range
+  for (int layer=1; layer <= state->lgar_bmi_params.num_layers; layer++) {
+    assert (state->lgar_bmi_params.layer_soil_type[layer] <= state->lgar_bmi_params.num_soil_types);
+    assert (state->lgar_bmi_params.layer_soil_type[layer] <= max_num_soil_in_file);
+  }
+
+  if (verbosity.compare("high") == 0) {
+    for (int layer=1; layer<=state->lgar_bmi_params.num_layers; layer++) {
+      int soil = state->lgar_bmi_params.layer_soil_type[layer];
+      std::cerr<<"Soil type/name : "<<state->lgar_bmi_params.layer_soil_type[layer]
+	       <<" "<<state->soil_properties[soil].soil_name<<"\n";
     }
+    std::cerr<<"          *****         \n";
   }
-  else {
-    state->lgar_bmi_params.soil_temperature   = new double[1]();
-    state->lgar_bmi_params.soil_temperature_z = new double[1]();
-    state->lgar_bmi_params.num_cells_temp     = 1;
+
+  for (int i=0; i<giuh_ordinates_temp.size()-1; i++) {
+    for (int j=0; j<giuh_factor; j++) {
+      int index = j + i * giuh_factor + 1;
+      state->lgar_bmi_params.giuh_ordinates[index] = giuh_ordinates_temp[i+1]/double(giuh_factor);
+    }
+  }
+
+  if (verbosity.compare("high") == 0) {
+    for (int i=1; i<=state->lgar_bmi_params.num_giuh_ordinates; i++)
+      std::cerr<<"GIUH ordinates (scaled) : "<<state->lgar_bmi_params.giuh_ordinates[i]<<"\n";
+
+    std::cerr<<"          *****         \n";
+  }
+
+  giuh_ordinates_temp.clear();
+
+  if (state->lgar_bmi_params.sft_coupled) {
+    for (int i=0; i < state->lgar_bmi_params.num_cells_temp; i++)
+      state->lgar_bmi_params.soil_temperature_z[i] = soil_z_temp[i];  // soil_temperature is zero until set through bmi
   }
 
   if (!is_ponded_depth_max_cm_set)
@@ -655,38 +870,63 @@ extern void InitFromConfigFile(string config_file, struct model_state *state)
   state->lgar_bmi_params.forcing_interval = int(state->lgar_bmi_params.forcing_resolution_h/state->lgar_bmi_params.timestep_h+1.0e-08); // add 1.0e-08 to prevent truncation error
 
   // initialize frozen factor array to 1.
-  state->lgar_bmi_params.frozen_factor = new double[state->lgar_bmi_params.num_layers+1];
   for (int i=0; i <= state->lgar_bmi_params.num_layers; i++)
     state->lgar_bmi_params.frozen_factor[i] = 1.0;
 
+  // per-layer table of quantities that only change with frozen factor or soil parameters
+  lgar_update_layer_table(state->lgar_bmi_params.num_layers, state->lgar_bmi_params.layer_soil_type,
+			  state->lgar_bmi_params.cum_layer_thickness_cm, state->lgar_bmi_params.frozen_factor,
+			  state->soil_properties, state->lgar_bmi_params.Ksat_eff_cm_per_h,
+			  state->lgar_bmi_params.cum_layer_resistance_h, &state->lgar_bmi_params.max_storage_cm);
+
+  // numeric or closed form Geff, per soil
+  lgar_select_geff_method(state->lgar_bmi_params.num_layers, state->lgar_bmi_params.layer_soil_type,
+			  state->lgar_bmi_params.geff_tolerance, state->lgar_bmi_params.geff_tables, state->soil_properties);
+
+  // optional tables of the van Genuchten relations, per soil
+  lgar_build_vg_tables(state->lgar_bmi_params.num_layers, state->lgar_bmi_params.layer_soil_type,
+		       state->lgar_bmi_params.vg_tables, state->soil_properties);
+
+  // allocate storage for the wetting fronts; the pool holds two lists (current and previous state)
+  // of up to MAX_NUM_WETTING_FRONTS wetting fronts each, and is released in BmiLGAR::Finalize
+  state->front_pool = listPoolCreate(2, MAX_NUM_WETTING_FRONTS, state->lgar_bmi_params.num_layers);
+  state->fronts     = listCreate(state->front_pool);
+
+  // the previous state is kept in a preallocated mirror list, refreshed by a flat copy at every subcycle
+  state->state_previous = listCreate(state->front_pool);
+
   InitializeWettingFronts(state->lgar_bmi_params.num_layers, state->lgar_bmi_params.initial_psi_cm,
 			  state->lgar_bmi_params.layer_soil_type, state->lgar_bmi_params.cum_layer_thickness_cm,
-			  state->lgar_bmi_params.frozen_factor, &state->head, state->soil_properties);
+			  state->lgar_bmi_params.frozen_factor, state->fronts, state->soil_properties);
   
   if (verbosity.compare("none") != 0) {
     std::cerr<<"--- Initial state/conditions --- \n";
-    listPrint(state->head);
+    listPrint(state->fronts);
     std::cerr<<"          *****         \n";
   }
 
   // initial mass in the system
-  state->lgar_mass_balance.volstart_cm      = lgar_calc_mass_bal(state->lgar_bmi_params.cum_layer_thickness_cm, state->head);
+  state->lgar_mass_balance.volstart_cm      = lgar_calc_mass_bal(state->lgar_bmi_params.cum_layer_thickness_cm, state->fronts);
 
   state->lgar_bmi_params.ponded_depth_cm    = 0.0; // initially we start with a dry surface (no surface ponding)
-  state->lgar_bmi_params.nint               = 120; // hacked, not needed to be an input option
   state->lgar_bmi_params.num_wetting_fronts = state->lgar_bmi_params.num_layers;
 
-  assert (state->lgar_bmi_params.num_layers == listLength(state->head));
+  assert (state->lgar_bmi_params.num_layers == listLength(state->fronts));
 
   if (verbosity.compare("high") == 0) {
     std::cerr<<"Initial ponded depth is set to zero. \n";
-    std::cerr<<"No. of spatial intervals used in trapezoidal integration to compute G : "<<state->lgar_bmi_params.nint<<"\n";
+    std::cerr<<"Relative tolerance of the adaptive quadrature of G : "<<state->lgar_bmi_params.geff_tolerance<<"\n";
   }
 
   state->lgar_bmi_input_params     = new lgar_bmi_input_parameters;
   state->lgar_bmi_params.time_s    = 0.0;
   state->lgar_bmi_params.timesteps = 0.0;
 
+  for (int k=0; k < LGAR_SUBSTEP_BINS; k++)
+    state->lgar_bmi_params.substep_histogram[k] = 0;
+  state->lgar_bmi_params.num_substep_rollbacks = 0;
+  state->lgar_bmi_params.num_heun_corrections = 0;
+
   if (verbosity.compare("none") != 0) {
     std::cerr<<"------------- Initialization done! ---------------------- \n";
     std::cerr<<"--------------------------------------------------------- \n";
@@ -694,6 +934,197 @@ extern void InitFromConfigFile(string config_file, struct model_state *state)
 
 }
 
+// #############################################################################################################################
+/*
+  Allocate the per-instance arrays in a single block (arena); called from InitFromConfigFile once num_layers,
+  num_soil_types, num_giuh_ordinates, num_cells_temp and the number of Geff and van Genuchten tables are known. Each array gets a computed offset in the block,
+  padded to a multiple of 8 bytes; soil properties come first so that the 64-byte alignment of the block is also the
+  alignment of the soil records. The layer arrays are 1-indexed (index 0 unused) as in the rest of the code.
+  The block is zeroed and released in lgar_arena_free.
+*/
+// #############################################################################################################################
+static size_t lgar_arena_reserve(size_t *nbytes, size_t size)
+{
+  size_t offset = *nbytes;
+  *nbytes += (size + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+  return offset;
+}
+
+extern void lgar_arena_create(struct model_state *state)
+{
+  struct lgar_bmi_parameters *params = &state->lgar_bmi_params;
+  size_t num_layers = params->num_layers;
+  size_t nbytes = 0;
+
+  // offsets of the arrays in the block
+  size_t soil_properties_at   = lgar_arena_reserve(&nbytes, (params->num_soil_types+1)*sizeof(struct soil_properties_));
+  size_t layer_thickness_at   = lgar_arena_reserve(&nbytes, (num_layers+1)*sizeof(double));
+  size_t cum_thickness_at     = lgar_arena_reserve(&nbytes, (num_layers+1)*sizeof(double));
+  size_t frozen_factor_at     = lgar_arena_reserve(&nbytes, (num_layers+1)*sizeof(double));
+  size_t Ksat_eff_at          = lgar_arena_reserve(&nbytes, (num_layers+1)*sizeof(double));
+  size_t cum_resistance_at    = lgar_arena_reserve(&nbytes, (num_layers+1)*sizeof(double));
+  size_t layer_soil_type_at   = lgar_arena_reserve(&nbytes, (num_layers+1)*sizeof(int));
+  size_t calib_at             = lgar_arena_reserve(&nbytes, 5*num_layers*sizeof(double));
+  size_t wf_moisture_at       = lgar_arena_reserve(&nbytes, MAX_NUM_WETTING_FRONTS*sizeof(double));
+  size_t wf_depth_at          = lgar_arena_reserve(&nbytes, MAX_NUM_WETTING_FRONTS*sizeof(double));
+  size_t scratch_at           = lgar_arena_reserve(&nbytes, 2*(num_layers+1)*sizeof(double));
+  size_t dzdt_corrector_at    = lgar_arena_reserve(&nbytes, (MAX_NUM_WETTING_FRONTS+1)*sizeof(double));
+  size_t giuh_ordinates_at    = lgar_arena_reserve(&nbytes, (params->num_giuh_ordinates+1)*sizeof(double));
+  size_t giuh_queue_at        = lgar_arena_reserve(&nbytes, (params->num_giuh_ordinates+1)*sizeof(double));
+  size_t geff_tables_at       = 0;
+  size_t vg_tables_at         = 0;
+  size_t soil_temperature_at  = 0;
+
+  if (params->geff_table)
+    geff_tables_at = lgar_arena_reserve(&nbytes, params->num_geff_tables*sizeof(struct geff_table_));
+
+  if (params->vg_table)
+    vg_tables_at = lgar_arena_reserve(&nbytes, params->num_vg_tables*sizeof(struct vg_table_));
+
+  if (params->sft_coupled)
+    soil_temperature_at = lgar_arena_reserve(&nbytes, 2*params->num_cells_temp*sizeof(double));
+
+  void *block = NULL;
+  if (posix_memalign(&block, alignof(struct soil_properties_), nbytes) != 0) {
+    stringstream errMsg;
+    errMsg << "unable to allocate memory for the model arrays ("<< nbytes <<" bytes) \n";
+    throw runtime_error(errMsg.str());
+  }
+
+  memset(block, 0, nbytes);
+  state->arena.block  = block;
+  state->arena.nbytes = nbytes;
+
+  char *base = (char*) block;
+
+  state->soil_properties         = (struct soil_properties_*) (base + soil_properties_at);
+  params->layer_thickness_cm     = (double*) (base + layer_thickness_at);
+  params->cum_layer_thickness_cm = (double*) (base + cum_thickness_at);
+  params->frozen_factor          = (double*) (base + frozen_factor_at);
+  params->Ksat_eff_cm_per_h      = (double*) (base + Ksat_eff_at);
+  params->cum_layer_resistance_h = (double*) (base + cum_resistance_at);
+  params->layer_soil_type        = (int*)    (base + layer_soil_type_at);
+
+  double *calib = (double*) (base + calib_at);
+  state->lgar_calib_params.theta_e  = calib;
+  state->lgar_calib_params.theta_r  = calib + num_layers;
+  state->lgar_calib_params.vg_n     = calib + 2*num_layers;
+  state->lgar_calib_params.vg_alpha = calib + 3*num_layers;
+  state->lgar_calib_params.Ksat     = calib + 4*num_layers;
+
+  // the wetting front outputs are sized for the maximum number of wetting fronts, so Update never reallocates them
+  params->soil_moisture_wetting_fronts = (double*) (base + wf_moisture_at);
+  params->soil_depth_wetting_fronts    = (double*) (base + wf_depth_at);
+
+  params->delta_thetas    = (double*) (base + scratch_at);
+  params->delta_thickness = params->delta_thetas + num_layers + 1;
+  params->dzdt_corrector_cm_per_h = (double*) (base + dzdt_corrector_at);
+
+  params->giuh_ordinates    = (double*) (base + giuh_ordinates_at);
+  params->giuh_runoff_queue = (double*) (base + giuh_queue_at);
+
+  params->geff_tables = params->geff_table ? (struct geff_table_*) (base + geff_tables_at) : NULL;
+  params->vg_tables   = params->vg_table ? (struct vg_table_*) (base + vg_tables_at) : NULL;
+
+  if (params->sft_coupled) {
+    params->soil_temperature   = (double*) (base + soil_temperature_at);
+    params->soil_temperature_z = params->soil_temperature + params->num_cells_temp;
+  }
+  else {
+    params->soil_temperature   = NULL;
+    params->soil_temperature_z = NULL;
+  }
+
+  state->arena.sft_block  = NULL;
+  state->arena.sft_nbytes = 0;
+
+  if (verbosity.compare("high") == 0)
+    std::cerr<<"Model arrays (bytes) : "<<nbytes<<"\n";
+}
+
+
+// #############################################################################################################################
+/*
+  Allocate the soil temperature profile of an uncoupled model on first use (e.g., a bmi get/set of
+  soil_temperature_profile); the values are zero and the profile has num_cells_temp cells.
+*/
+// #############################################################################################################################
+extern void lgar_soil_temperature_alloc(struct model_state *state)
+{
+  struct lgar_bmi_parameters *params = &state->lgar_bmi_params;
+
+  if (params->soil_temperature != NULL)
+    return;
+
+  state->arena.sft_block  = new double[2*params->num_cells_temp]();
+  state->arena.sft_nbytes = 2*params->num_cells_temp*sizeof(double);
+
+  params->soil_temperature   = state->arena.sft_block;
+  params->soil_temperature_z = state->arena.sft_block + params->num_cells_temp;
+}
+
+
+// #############################################################################################################################
+/*
+  Release the arena and the lazily allocated soil temperature profile; the array pointers are reset to NULL.
+*/
+// #############################################################################################################################
+extern void lgar_arena_free(struct model_state *state)
+{
+  struct lgar_bmi_parameters *params = &state->lgar_bmi_params;
+
+  free(state->arena.block);
+  delete [] state->arena.sft_block;
+
+  state->arena.block      = NULL;
+  state->arena.nbytes     = 0;
+  state->arena.sft_block  = NULL;
+  state->arena.sft_nbytes = 0;
+
+  state->soil_properties               = NULL;
+  params->layer_thickness_cm           = NULL;
+  params->cum_layer_thickness_cm       = NULL;
+  params->frozen_factor                = NULL;
+  params->Ksat_eff_cm_per_h            = NULL;
+  params->cum_layer_resistance_h       = NULL;
+  params->layer_soil_type              = NULL;
+  params->soil_moisture_wetting_fronts = NULL;
+  params->soil_depth_wetting_fronts    = NULL;
+  params->delta_thetas                 = NULL;
+  params->delta_thickness              = NULL;
+  params->dzdt_corrector_cm_per_h      = NULL;
+  params->giuh_ordinates               = NULL;
+  params->giuh_runoff_queue            = NULL;
+  params->soil_temperature             = NULL;
+  params->soil_temperature_z           = NULL;
+
+  state->lgar_calib_params.theta_e  = NULL;
+  state->lgar_calib_params.theta_r  = NULL;
+  state->lgar_calib_params.vg_n     = NULL;
+  state->lgar_calib_params.vg_alpha = NULL;
+  state->lgar_calib_params.Ksat     = NULL;
+}
+
+
+// #############################################################################################################################
+/*
+  Number of bytes held by a model instance: the model state, the arena, the soil temperature profile,
+  the wetting front pool and the bmi input parameters
+*/
+// #############################################################################################################################
+extern size_t lgar_memory_footprint(struct model_state *state)
+{
+  size_t nbytes = sizeof(struct model_state) + state->arena.nbytes + state->arena.sft_nbytes;
+
+  if (state->front_pool != NULL)
+    nbytes += state->front_pool->nbytes;
+
+  if (state->lgar_bmi_input_params != NULL)
+    nbytes += sizeof(struct lgar_bmi_input_parameters);
+
+  return nbytes;
+}
+
 //##############################################################################
 /*
   calculates initial theta (soil moisture content) and hydraulic conductivity
@@ -701,22 +1132,20 @@ extern void InitFromConfigFile(string config_file, struct model_state *state)
 */
 // #############################################################################
 extern void InitializeWettingFronts(int num_layers, double initial_psi_cm, int *layer_soil_type, double *cum_layer_thickness_cm,
-				    double *frozen_factor, struct wetting_front** head, struct soil_properties_ *soil_properties)
+				    double *frozen_factor, struct wetting_front_list* fronts, struct soil_properties_ *soil_properties)
 {
   int soil;
   int front = 0;
   double Se, theta_init;
   bool bottom_flag;
   double Ksat_cm_per_h;
-  struct wetting_front *current;
+  int wf;
 
   for(int layer=1;layer<=num_layers;layer++) {
     front++;
 
     soil = layer_soil_type[layer];
-    theta_init = calc_theta_from_h(initial_psi_cm,soil_properties[soil].vg_alpha_per_cm,
-				   soil_properties[soil].vg_m,soil_properties[soil].vg_n,
-				   soil_properties[soil].theta_e,soil_properties[soil].theta_r);
+    theta_init = calc_theta_from_h(initial_psi_cm, &soil_properties[soil]);
 
     if (verbosity.compare("high") == 0) {
       printf("layer, theta, psi, alpha, m, n, theta_e, theta_r = %d, %6.6f, %6.6f, %6.6f, %6.6f, %6.6f, %6.6f, %6.6f \n",
@@ -728,13 +1157,13 @@ extern void InitializeWettingFronts(int num_layers, double initial_psi_cm, int *
     bottom_flag = true;  // all initial wetting fronts are in contact with the bottom of the layer they exist in
     // NOTE: The listInsertFront function does lots of stuff.
 
-    current = listInsertFront(cum_layer_thickness_cm[layer],theta_init,front,layer,bottom_flag, head);
+    wf = listInsertFront(cum_layer_thickness_cm[layer],theta_init,front,layer,bottom_flag, fronts);
 
-    current->psi_cm = initial_psi_cm;
-    Se = calc_Se_from_theta(current->theta,soil_properties[soil].theta_e,soil_properties[soil].theta_r);
+    fronts->psi_cm[wf] = initial_psi_cm;
+    Se = calc_Se_from_theta(fronts->theta[wf], &soil_properties[soil]);
 
     Ksat_cm_per_h = frozen_factor[layer] * soil_properties[soil].Ksat_cm_per_h;
-    current->K_cm_per_h = calc_K_from_Se(Se, Ksat_cm_per_h , soil_properties[soil].vg_m);  // cm/s
+    fronts->K_cm_per_h[wf] = calc_K_from_Se(Se, Ksat_cm_per_h, &soil_properties[soil]);  // cm/s
 
   }
 
@@ -782,6 +1211,187 @@ ReadVectorData(string key)
   return value;
 }
 
+// ############################################################################################
+/* builds the per-layer table used by the infiltration capacity: effective Ksat of each layer
+   (Ksat * frozen factor), the cumulative resistance sum(L_k/Ksat_eff_k) from the surface to the
+   bottom of each layer, and the amount of water the column holds at saturation. These only change
+   when the frozen factor or the soil parameters change, so the table is rebuilt only then */
+// ############################################################################################
+extern void lgar_update_layer_table(int num_layers, int *soil_type, double *cum_layer_thickness_cm, double *frozen_factor,
+				    struct soil_properties_ *soil_properties, double *Ksat_eff_cm_per_h,
+				    double *cum_layer_resistance_h, double *max_storage_cm)
+{
+  Ksat_eff_cm_per_h[0]      = 0.0;  // index 0 is unused (1-based layers)
+  cum_layer_resistance_h[0] = 0.0;
+  (*max_storage_cm)         = 0.0;
+
+  for (int layer = 1; layer <= num_layers; layer++) {
+    int soil = soil_type[layer];
+    double layer_thickness_cm = cum_layer_thickness_cm[layer] - cum_layer_thickness_cm[layer-1];
+
+    Ksat_eff_cm_per_h[layer]      = soil_properties[soil].Ksat_cm_per_h * frozen_factor[layer];
+    cum_layer_resistance_h[layer] = cum_layer_resistance_h[layer-1] + layer_thickness_cm / Ksat_eff_cm_per_h[layer];
+    (*max_storage_cm)            += soil_properties[soil].theta_e * layer_thickness_cm;
+  }
+
+  if (verbosity.compare("high") == 0) {
+    for (int layer = 1; layer <= num_layers; layer++)
+      std::cerr<<"layer "<< layer <<": Ksat_eff = "<< Ksat_eff_cm_per_h[layer] <<", cumulative resistance = "
+	       << cum_layer_resistance_h[layer] <<"\n";
+    std::cerr<<"max storage = "<< (*max_storage_cm) <<"\n";
+  }
+}
+
+// ############################################################################################
+/* tolerances and iteration caps of the precision profiles; reference holds those the model was developed with.
+   operational caps the iterations (the time per step of a forecast cycle is bounded) and screening loosens everything
+   for calibration screening; the mass errors the looser tolerances leave are reported by the global mass balance
+   (largest and mean local error). A mass balance search or free drainage correction stopped by its iteration cap
+   passes its remaining error to AET, as when the search reaches psi_max, and the local mass balance check of
+   BmiLGAR::Update bounds what is left: a substep whose error exceeds substep_mass_tolerance_cm is rolled back and
+   retried with half the step, and the model stops if the smallest substep still exceeds local_mass_error_max_cm. */
+// ############################################################################################
+extern bool lgar_set_precision_profile(int profile, struct precision_settings_ *precision, double *geff_tolerance)
+{
+  //                                          reference  operational  screening
+  const double mass_balance_tolerance_cm[] = {1.0E-12,   1.0E-10,     1.0E-8};
+  const int    mass_balance_max_iter[]     = {200,       40,          20};
+  const double free_drainage_tolerance_cm[] = {1.0E-10,  1.0E-9,      1.0E-7};
+  const int    free_drainage_max_iter[]    = {5,         3,           2};
+  const double geff_tolerances[]           = {1.0E-6,    1.0E-5,      1.0E-4};
+  const double substep_mass_tolerance_cm[] = {1.0E-8,    1.0E-7,      1.0E-6};
+  const double local_mass_error_max_cm[]   = {1.0E-4,    1.0E-4,      1.0E-3};
+  const double heun_tolerance_cm[]         = {1.0E-3,    1.0E-2,      1.0E-1};
+
+  if (profile < PRECISION_REFERENCE || profile > PRECISION_SCREENING)
+    return false;
+
+  precision->profile                    = profile;
+  precision->mass_balance_tolerance_cm  = mass_balance_tolerance_cm[profile];
+  precision->mass_balance_max_iter      = mass_balance_max_iter[profile];
+  precision->free_drainage_tolerance_cm = free_drainage_tolerance_cm[profile];
+  precision->free_drainage_max_iter     = free_drainage_max_iter[profile];
+  precision->geff_tolerance             = geff_tolerances[profile];
+  precision->substep_mass_tolerance_cm  = substep_mass_tolerance_cm[profile];
+  precision->local_mass_error_max_cm    = local_mass_error_max_cm[profile];
+  precision->heun_tolerance_cm          = heun_tolerance_cm[profile];
+  *geff_tolerance                       = geff_tolerances[profile];
+
+  if (verbosity.compare("high") == 0) {
+    std::cerr<<"Precision profile "<< precision_profile_name(profile) <<": mass balance tolerance = "
+	     << precision->mass_balance_tolerance_cm <<" cm ("<< precision->mass_balance_max_iter <<" iterations), "
+	     <<"free drainage tolerance = "<< precision->free_drainage_tolerance_cm <<" cm ("
+	     << precision->free_drainage_max_iter <<" iterations), Geff tolerance = "<< precision->geff_tolerance
+	     <<", substep rollback at = "<< precision->substep_mass_tolerance_cm <<" cm, local mass error limit = "
+	     << precision->local_mass_error_max_cm <<" cm, Heun correction above = "<< precision->heun_tolerance_cm <<" cm \n";
+  }
+
+  return true;
+}
+
+extern const char* precision_profile_name(int profile)
+{
+  switch (profile) {
+  case PRECISION_REFERENCE:   return "reference";
+  case PRECISION_OPERATIONAL: return "operational";
+  case PRECISION_SCREENING:   return "screening";
+  default:                    return "unknown";
+  }
+}
+
+// ############################################################################################
+/* prepares the Geff computation of each soil of the column:
+   - the table of the cumulative K(h) integral (see calc_Geff_table) is attached if tables are enabled (geff_tables not
+     NULL) and the soil uses the numeric integral, one per soil in the order the soils first appear from the top (as in
+     lgar_build_vg_tables). calc_Geff builds it at its first use, and rebuilds it only if the van Genuchten parameters
+     have changed since, so a calibration update that leaves them unchanged or a change of the Geff tolerance does not;
+     a soil whose table does not meet the Geff tolerance uses the quadrature
+   - the closed form (Brooks-Corey approximation, Ogden and Saghafian 1997) is used instead of the numeric integral if
+     it agrees with the integral within the Geff tolerance for pairs of moisture contents spanning the range of the soil
+     (wetting front at and below saturation, soil below the front from dry to wet). With the default tolerance this is
+     not the case for any of the standard soils; a loose tolerance trades the accuracy of the capillary drive for speed
+     on the soils where the approximation is good. */
+// ############################################################################################
+extern void lgar_select_geff_method(int num_layers, int *soil_type, double geff_tolerance, struct geff_table_ *geff_tables,
+				    struct soil_properties_ *soil_properties)
+{
+  const double Se_front[] = {1.0, 0.9};                   // effective saturation of the wetting front
+  const double Se_below[] = {0.01, 0.1, 0.3, 0.5, 0.7};   // effective saturation of the soil below the front
+
+  int num_tables = 0;
+
+  for (int layer = 1; layer <= num_layers; layer++) {
+    bool soil_done = false;  // the soil of an overlying layer
+    for (int k = 1; k < layer; k++)
+      soil_done = soil_done || soil_type[k] == soil_type[layer];
+
+    if (soil_done)
+      continue;
+
+    struct soil_properties_ *soil = &soil_properties[soil_type[layer]];
+
+    soil->geff_table = NULL;  // the closed form is compared with the quadrature
+    soil->use_closed_form_G = true;
+
+    for (int i = 0; i < 2 && soil->use_closed_form_G; i++) {
+      for (int j = 0; j < 5 && soil->use_closed_form_G; j++) {
+	double theta1 = soil->theta_r + Se_below[j] * (soil->theta_e - soil->theta_r);
+	double theta2 = soil->theta_r + Se_front[i] * (soil->theta_e - soil->theta_r);
+
+	double G_numeric = calc_Geff(false, theta1, theta2, soil, soil->Ksat_cm_per_h, geff_tolerance);
+	double G_closed  = calc_Geff(true, theta1, theta2, soil, soil->Ksat_cm_per_h, geff_tolerance);
+
+	if (fabs(G_closed - G_numeric) > geff_tolerance * G_numeric)
+	  soil->use_closed_form_G = false;
+      }
+    }
+
+    if (geff_tables != NULL) {
+      struct geff_table_ *table = &geff_tables[num_tables++];  // the slot of the soil, whether it is used or not
+      if (!soil->use_closed_form_G)
+	soil->geff_table = table;
+    }
+
+    if (verbosity.compare("high") == 0)
+      std::cerr<<"soil "<< soil_type[layer] <<": Geff is computed with the "
+	       << (soil->use_closed_form_G ? "closed form" : (soil->geff_table != NULL ? "table" : "numeric integral")) <<"\n";
+  }
+}
+
+// ############################################################################################
+/* builds the tables of the van Genuchten relations (see calc_vg_table) of each soil of the column, in the order the
+   soils first appear from the top (one table per soil, vg_tables holds num_vg_tables of them). A soil whose table does
+   not meet VG_TABLE_TOLERANCE, and every soil if tables are disabled (vg_tables NULL), uses the formulas. */
+// ############################################################################################
+extern void lgar_build_vg_tables(int num_layers, int *soil_type, struct vg_table_ *vg_tables,
+				 struct soil_properties_ *soil_properties)
+{
+  int num_tables = 0;
+
+  for (int layer = 1; layer <= num_layers; layer++) {
+    bool soil_done = false;  // the soil of an overlying layer
+    for (int k = 1; k < layer; k++)
+      soil_done = soil_done || soil_type[k] == soil_type[layer];
+
+    if (soil_done)
+      continue;
+
+    struct soil_properties_ *soil = &soil_properties[soil_type[layer]];
+
+    soil->vg_table = NULL;
+
+    if (vg_tables != NULL) {
+      struct vg_table_ *table = &vg_tables[num_tables++];
+      if (calc_vg_table(table, soil->vg_alpha_per_cm, soil->vg_n, soil->vg_m, VG_TABLE_TOLERANCE))
+	soil->vg_table = table;
+
+      if (verbosity.compare("high") == 0)
+	std::cerr<<"soil "<< soil_type[layer] <<": van Genuchten relations from "
+		 << (soil->vg_table != NULL ? "table" : "formulas") <<" (table error = "<< table->max_error <<")\n";
+    }
+  }
+}
+
 // ############################################################################################
 /*
   calculates frozen factor based on L. Wang et al. (www.hydrol-earth-syst-sci.net/14/557/2010/)
@@ -883,6 +1493,20 @@ extern void lgar_global_mass_balance(struct model_state *state, double *giuh_run
  printf("Total discharge (Q)       = %14.10f cm\n", total_Q_cm);
  printf("Vol change (calibration)  = %14.10f cm\n", volchange_calib_cm);
  printf("Global balance            =   %.6e cm\n", global_error_cm);
+ printf("Precision profile         = %s \n", precision_profile_name(state->lgar_bmi_params.precision.profile));
+ printf("Largest local balance     =   %.6e cm\n", state->lgar_mass_balance.local_mass_balance_max_cm);
+ printf("Mean local balance        =   %.6e cm\n", state->lgar_mass_balance.num_local_mass_balance > 0 ?
+	state->lgar_mass_balance.local_mass_balance_sum_cm / state->lgar_mass_balance.num_local_mass_balance : 0.0);
+ printf("------------------------ Substeps ----------------------- \n");
+ for (int k=0; k < LGAR_SUBSTEP_BINS; k++) {
+   if (state->lgar_bmi_params.substep_histogram[k] > 0)
+     printf("Substeps of %10.2f s     = %ld \n",
+	    state->lgar_bmi_params.timestep_h * state->units.hr_to_sec * ldexp(1.0, k - LGAR_MAX_STEP_HALVINGS),
+	    state->lgar_bmi_params.substep_histogram[k]);
+ }
+ printf("Substeps rolled back      = %ld \n", state->lgar_bmi_params.num_substep_rollbacks);
+ if (state->lgar_bmi_params.front_integrator == FRONT_INTEGRATOR_HEUN)
+   printf("Substeps Heun corrected   = %ld \n", state->lgar_bmi_params.num_heun_corrections);
 
 }
 
@@ -895,23 +1519,17 @@ extern void lgar_global_mass_balance(struct model_state *state, double *giuh_run
  Note: the free_drainage name came from its python version, which is probably not the correct name.
  */
 // ############################################################################################
-extern int wetting_front_free_drainage(struct wetting_front* head) {
+extern int wetting_front_free_drainage(struct wetting_front_list* fronts) {
 
   int wf_that_supplies_free_drainage_demand = 1;
-  struct wetting_front *current;
-
-  //current = head;
-  int number_of_wetting_fronts = listLength(head);
 
-  for(current = head; current != NULL; current = current->next)
-  {
-    if (current->next != NULL) {
-      if (current->layer_num == current->next->layer_num)
-	break;
-      else
-	wf_that_supplies_free_drainage_demand++;
+  int number_of_wetting_fronts = listLength(fronts);
 
-    }
+  for (int wf = 1; wf < number_of_wetting_fronts; wf++) {
+    if (fronts->layer_num[wf] == fronts->layer_num[wf+1])
+      break;
+    else
+      wf_that_supplies_free_drainage_demand++;
   }
 
   if (wf_that_supplies_free_drainage_demand > number_of_wetting_fronts)
@@ -927,44 +1545,37 @@ extern int wetting_front_free_drainage(struct wetting_front* head) {
 // #######################################################################################################
 /*
   the function moves wetting fronts, merge wetting fronts and does the mass balance correction when needed
-  @param current : wetting front pointing to the current node of the current state
-  @param next    : wetting front pointing to the next node of the current state
-  @param previous    : wetting front pointing to the previous node of the current state
-  @param current_old : wetting front pointing to the current node of the previous state
-  @param next_old    : wetting front pointing to the next node of the previous state
-  @param head : pointer to the first wetting front in the list of the current state
+  @param wf             : number (index) of the current wetting front; wf+1 and wf-1 are the next and previous wetting fronts
+  @param fronts         : wetting fronts of the current state
+  @param state_previous : wetting fronts of the previous state (same numbering as the current state at the start of the call)
+  @param delta_thetas, delta_thickness : per-instance scratch arrays of size num_layers+1 used in the mass balance of
+                                        wetting fronts spanning several layers
+  @param psi_search_candidates : trial heads evaluated at once by the psi search of the mass balance (see
+                                lgar_theta_mass_balance)
+  @param precision      : tolerances and iteration caps of the mass balance and free drainage corrections
 
   Note: '_old' denotes the wetting_front or variables at the previous timestep (or state)
 */
 // #######################################################################################################
 extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf_free_drainage_demand,
 				     double old_mass, int num_layers, double *AET_demand_cm, double *cum_layer_thickness_cm,
-				     int *soil_type, double *frozen_factor, struct wetting_front** head,
-				     struct wetting_front* state_previous, struct soil_properties_ *soil_properties)
+				     int *soil_type, double *frozen_factor, double *delta_thetas, double *delta_thickness,
+				     struct wetting_front_list* fronts, struct wetting_front_list* state_previous,
+				     struct soil_properties_ *soil_properties, int psi_search_candidates,
+				     const struct precision_settings_ *precision)
 {
 
   if (verbosity.compare("high") == 0) {
     printf("State before moving wetting fronts...\n");
-    listPrint(*head);
+    listPrint(fronts);
   }
 
-  struct wetting_front *current;
-  struct wetting_front *next;
-  struct wetting_front *previous;
-
-  struct wetting_front *current_old;
-  struct wetting_front *next_old;
-
   double column_depth = cum_layer_thickness_cm[num_layers];
 
-  previous = *head;
   double theta_e,theta_r;
-  double vg_a, vg_m, vg_n;
   int layer_num, soil_num;
 
-  int number_of_wetting_fronts = listLength(*head);
-
-  current = *head;
+  int number_of_wetting_fronts = listLength(fronts);
 
   int last_wetting_front_index = number_of_wetting_fronts;
   int layer_num_above, layer_num_below;
@@ -986,46 +1597,20 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
       printf("Moving |******** Wetting Front = %d *********| \n", wf);
     }
 
-    if (wf == 1 && number_of_wetting_fronts >0) {
-      current = listFindFront(wf, *head, NULL);
-      next = listFindFront(wf+1, *head, NULL);
-      previous = NULL;
-
-      current_old = listFindFront(wf, *head, state_previous);
-      next_old = listFindFront(wf+1, *head, state_previous);
-    }
-    else if (wf < number_of_wetting_fronts) {
-      current = listFindFront(wf, *head, NULL);
-      next = listFindFront(wf+1, *head, NULL);
-      previous = listFindFront(wf-1, *head, NULL);
-
-      current_old = listFindFront(wf, *head, state_previous);
-      next_old = listFindFront(wf+1, *head, state_previous);
-    }
-    else if (wf == number_of_wetting_fronts) {
-      current = listFindFront(wf, *head, NULL);
-      next = NULL;
-      previous = listFindFront(wf-1, *head, NULL);
+    bool front_deleted = false; // true if the current wetting front gets deleted (theta falls below theta_r)
 
-      current_old = listFindFront(wf, *head, state_previous);
-      next_old = NULL;
-    }
-
-    layer_num   = current->layer_num;
+    layer_num   = fronts->layer_num[wf];
     soil_num    = soil_type[layer_num];
     theta_e     = soil_properties[soil_num].theta_e;
     theta_r     = soil_properties[soil_num].theta_r;
-    vg_a        = soil_properties[soil_num].vg_alpha_per_cm;
-    vg_m        = soil_properties[soil_num].vg_m;
-    vg_n        = soil_properties[soil_num].vg_n;
 
     // find indices of above and below layers
-    layer_num_above = (wf == 1) ? layer_num : previous->layer_num;
-    layer_num_below = (wf == last_wetting_front_index) ? layer_num + 1 : next->layer_num;
+    layer_num_above = (wf == 1) ? layer_num : fronts->layer_num[wf-1];
+    layer_num_below = (wf == last_wetting_front_index) ? layer_num + 1 : fronts->layer_num[wf+1];
 
     if (verbosity.compare("high") == 0) {
        printf ("Layers (current, above, below) == %d %d %d \n", layer_num, layer_num_above, layer_num_below);
-       listPrint(*head);
+       listPrint(fronts);
     }
 
     double free_drainage_demand = 0.0;
@@ -1033,7 +1618,7 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
 
     // case to check if the wetting front is at the interface, i.e. deepest wetting front within a layer
     // psi of the layer below is already known/updated, so we that psi to compute the theta of the deepest current layer
-    // todo. this condition can be replace by current->to_depth = FALSE && l<last_wetting_front_index
+    // todo. this condition can be replace by fronts->to_depth[wf] = FALSE && l<last_wetting_front_index
     /*             _____________
        layer_above             |
                             ___|
@@ -1053,8 +1638,8 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
 	printf("case (deepest wetting front within layer) : layer_num (%d) != layer_num_below (%d) \n", layer_num, layer_num_below);
       }
 
-      current->theta = calc_theta_from_h(next->psi_cm, vg_a,vg_m, vg_n, theta_e, theta_r);
-      current->psi_cm = next->psi_cm;
+      fronts->theta[wf] = calc_theta_from_h(fronts->psi_cm[wf+1], &soil_properties[soil_num]);
+      fronts->psi_cm[wf] = fronts->psi_cm[wf+1];
     }
 
     // case to check if the number of wetting fronts are equal to the number of layers, i.e., one wetting front per layer
@@ -1077,43 +1662,32 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
 	printf("case (number_of_wetting_fronts equal to num_layers) : l (%d) == num_layers (%d) == num_wetting_fronts(%d) \n", wf, num_layers,number_of_wetting_fronts);
       }
 
-      // local variables
-      double vg_a_k, vg_m_k, vg_n_k;
-      double theta_e_k, theta_r_k;
-
-      current->depth_cm += current->dzdt_cm_per_h * timestep_h; // this is probably not needed, as dz/dt = 0 for the deepest wetting front
+      fronts->depth_cm[wf] += fronts->dzdt_cm_per_h[wf] * timestep_h; // this is probably not needed, as dz/dt = 0 for the deepest wetting front
 
-      double *delta_thetas = (double *) malloc(sizeof(double)*(layer_num+1));
-      double *delta_thickness = (double *) malloc(sizeof(double)*(layer_num+1));
+      double psi_cm = fronts->psi_cm[wf];
 
-      double psi_cm_old = current_old->psi_cm;
-      //double psi_cm_below_old = 0.0;
+      // mass = delta(depth) * delta(theta)
+      double prior_mass = (state_previous->depth_cm[wf] - cum_layer_thickness_cm[layer_num-1]) * (state_previous->theta[wf] - 0.0); // 0.0 = state_previous->theta[wf+1]
 
-      double psi_cm = current->psi_cm;
-      //double psi_cm_below = 0.0;
+      double new_mass = (fronts->depth_cm[wf] - cum_layer_thickness_cm[layer_num-1]) * (fronts->theta[wf] - 0.0); // 0.0 = fronts->theta[wf+1];
 
-      // mass = delta(depth) * delta(theta)
-      double prior_mass = (current_old->depth_cm - cum_layer_thickness_cm[layer_num-1]) * (current_old->theta - 0.0); // 0.0 = next_old->theta
+      // thetas of the old and current wetting front in the layers above (psi projected into those layers)
+      lgar_front_projection(wf, layer_num-1, soil_type, frozen_factor, state_previous, soil_properties);
+      lgar_front_projection(wf, layer_num-1, soil_type, frozen_factor, fronts, soil_properties);
 
-      double new_mass = (current->depth_cm - cum_layer_thickness_cm[layer_num-1]) * (current->theta - 0.0); // 0.0 = next->theta;
+      double *theta_proj_old = &state_previous->proj_theta[wf*state_previous->proj_stride];
+      double *theta_proj     = &fronts->proj_theta[wf*fronts->proj_stride];
 
       for (int k=1; k<layer_num; k++) {
-	int soil_num_k  = soil_type[k];
-	theta_e_k = soil_properties[soil_num_k].theta_e;
-	theta_r_k = soil_properties[soil_num_k].theta_r;
-	vg_a_k    = soil_properties[soil_num_k].vg_alpha_per_cm;
-	vg_m_k    = soil_properties[soil_num_k].vg_m;
-	vg_n_k    = soil_properties[soil_num_k].vg_n;
-
-	// using psi_cm_old for all layers because the psi is constant across layers in this particular case
-	double theta_old             = calc_theta_from_h(psi_cm_old, vg_a_k, vg_m_k, vg_n_k, theta_e_k,theta_r_k);
+	// using the old psi for all layers because the psi is constant across layers in this particular case
+	double theta_old             = theta_proj_old[k];
 	double theta_below_old       = 0.0;
 	double local_delta_theta_old = theta_old - theta_below_old;
 	double layer_thickness       = cum_layer_thickness_cm[k] - cum_layer_thickness_cm[k-1];
 
 	prior_mass += (layer_thickness * local_delta_theta_old);
 
-	double theta       = calc_theta_from_h(psi_cm, vg_a_k, vg_m_k, vg_n_k, theta_e_k, theta_r_k);
+	double theta       = theta_proj[k];
 	double theta_below = 0.0;
 
 	new_mass += layer_thickness * (theta - theta_below);
@@ -1122,7 +1696,7 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
       }
 
       delta_thetas[layer_num] = 0.0;
-      delta_thickness[layer_num] = current->depth_cm - cum_layer_thickness_cm[layer_num-1];
+      delta_thickness[layer_num] = fronts->depth_cm[wf] - cum_layer_thickness_cm[layer_num-1];
 
       double free_drainage_demand = 0;
 
@@ -1132,13 +1706,15 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
       // theta mass balance computes new theta that conserves the mass; new theta is assigned to the current wetting front
 
       double theta_new = lgar_theta_mass_balance(layer_num, soil_num, psi_cm, new_mass, prior_mass, AET_demand_cm,
-						 delta_thetas, delta_thickness, soil_type, soil_properties);
+						 delta_thetas, delta_thickness, soil_type, soil_properties,
+						 psi_search_candidates, precision->mass_balance_tolerance_cm,
+						 precision->mass_balance_max_iter);
       actual_ET_demand = *AET_demand_cm;
       
-      current->theta = fmax(theta_r, fmin(theta_new, theta_e));
+      fronts->theta[wf] = fmax(theta_r, fmin(theta_new, theta_e));
 
-      double Se = calc_Se_from_theta(current->theta,theta_e,theta_r);
-      current->psi_cm = calc_h_from_Se(Se, vg_a, vg_m, vg_n);
+      double Se = calc_Se_from_theta(fronts->theta[wf], &soil_properties[soil_num]);
+      fronts->psi_cm[wf] = calc_h_from_Se(Se, &soil_properties[soil_num]);
 
       /* note: theta and psi of the current wetting front are updated here based on the wetting front's mass balance,
 	 upper wetting fronts will be updated later in the lgar_merge_ module (the place where all state
@@ -1165,33 +1741,34 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
 
 	double free_drainage_demand = 0;
 	// prior mass = mass contained in the current old wetting front
-	double prior_mass = current_old->depth_cm * (current_old->theta -  next_old->theta);
+	double prior_mass = state_previous->depth_cm[wf] * (state_previous->theta[wf] -  state_previous->theta[wf+1]);
 
 	if (wf_free_drainage_demand == wf)
 	  prior_mass += precip_mass_to_add - (free_drainage_demand + actual_ET_demand);
 
-	current->depth_cm += current->dzdt_cm_per_h * timestep_h;
+	fronts->depth_cm[wf] += fronts->dzdt_cm_per_h[wf] * timestep_h;
 
 	/* condition to bound the wetting front depth, if depth of a wf, at this timestep,
 	   gets greater than the domain depth, it will be merge anyway as it is passing
 	   the layer depth */
-	current->depth_cm = fmin(current->depth_cm, column_depth);
+	fronts->depth_cm[wf] = fmin(fronts->depth_cm[wf], column_depth);
 
-  double theta_old = current->theta; //might not be necessary 
-	if (current->dzdt_cm_per_h == 0.0 && current->to_bottom == FALSE) // a new front was just created, so don't update it.
-	  current->theta = current->theta;
+  double theta_old = fronts->theta[wf]; //might not be necessary 
+	if (fronts->dzdt_cm_per_h[wf] == 0.0 && fronts->to_bottom[wf] == FALSE) // a new front was just created, so don't update it.
+	  fronts->theta[wf] = fronts->theta[wf];
 	else {
-      if ((prior_mass/current->depth_cm + next->theta)<theta_r){
+      if ((prior_mass/fronts->depth_cm[wf] + fronts->theta[wf+1])<theta_r){
         //the idea here is that in some cases, the reduction in theta via WF movement or AET will be intense enough such that theta goes below theta_r.
         //it requires a fairly unusual soil, which I encountered during random parameter sampling.
-        double mass_before_theta_went_below_theta_r = lgar_calc_mass_bal(cum_layer_thickness_cm, *head) - current->depth_cm*(current->theta - (prior_mass/current->depth_cm + next->theta));
-        listDeleteFront(current->front_num, head);
-        double mass_after_theta_went_below_theta_r = lgar_calc_mass_bal(cum_layer_thickness_cm, *head);
+        double mass_before_theta_went_below_theta_r = lgar_update_front_mass(wf, cum_layer_thickness_cm, fronts) - fronts->depth_cm[wf]*(fronts->theta[wf] - (prior_mass/fronts->depth_cm[wf] + fronts->theta[wf+1]));
+        listDeleteFront(wf, fronts);
+        front_deleted = true;
+        double mass_after_theta_went_below_theta_r = lgar_update_front_mass(wf, cum_layer_thickness_cm, fronts);
         *AET_demand_cm = *AET_demand_cm - fabs(mass_before_theta_went_below_theta_r - mass_after_theta_went_below_theta_r);
         actual_ET_demand = *AET_demand_cm;
       }
       else {//This is the case where theta>theta_r, which will be almost all of the time 
-	      current->theta = fmax(theta_r, fmin(theta_e, prior_mass/current->depth_cm + next->theta));
+	      fronts->theta[wf] = fmax(theta_r, fmin(theta_e, prior_mass/fronts->depth_cm[wf] + fronts->theta[wf+1]));
       }
     }
 
@@ -1213,39 +1790,32 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
 	  - LGAR paper (currently under review) has a better description, using diagrams, of the mass balance of wetting fronts
 	*/
 
-	double vg_a_k, vg_m_k, vg_n_k;
-	double theta_e_k, theta_r_k;
-
-	current->depth_cm += current->dzdt_cm_per_h * timestep_h;
+	fronts->depth_cm[wf] += fronts->dzdt_cm_per_h[wf] * timestep_h;
 
-	double *delta_thetas    = (double *)malloc(sizeof(double)*(layer_num+1));
-	double *delta_thickness = (double *)malloc(sizeof(double)*(layer_num+1));
 
-
-	double psi_cm_old = current_old->psi_cm;
-	double psi_cm_below_old = current_old->next->psi_cm;
-
-	double psi_cm = current->psi_cm;
-	double psi_cm_below = next->psi_cm;
+	double psi_cm = fronts->psi_cm[wf];
 
 	// mass = delta(depth) * delta(theta)
 	//      = difference in current and next wetting front thetas times depth of the current wetting front
-	double prior_mass = (current_old->depth_cm - cum_layer_thickness_cm[layer_num-1]) * (current_old->theta - next_old->theta);
-	double new_mass = (current->depth_cm - cum_layer_thickness_cm[layer_num-1]) * (current->theta - next->theta);
+	double prior_mass = (state_previous->depth_cm[wf] - cum_layer_thickness_cm[layer_num-1]) * (state_previous->theta[wf] - state_previous->theta[wf+1]);
+	double new_mass = (fronts->depth_cm[wf] - cum_layer_thickness_cm[layer_num-1]) * (fronts->theta[wf] - fronts->theta[wf+1]);
 
 	// compute mass in the layers above the current wetting front
 	// use the psi of the current wetting front and van Genuchten parameters of
 	// the respective layers to get the total mass above the current wetting front
+	lgar_front_projection(wf,   layer_num-1, soil_type, frozen_factor, state_previous, soil_properties);
+	lgar_front_projection(wf+1, layer_num-1, soil_type, frozen_factor, state_previous, soil_properties);
+	lgar_front_projection(wf,   layer_num-1, soil_type, frozen_factor, fronts, soil_properties);
+	lgar_front_projection(wf+1, layer_num-1, soil_type, frozen_factor, fronts, soil_properties);
+
+	double *theta_proj_old       = &state_previous->proj_theta[wf*state_previous->proj_stride];
+	double *theta_proj_below_old = &state_previous->proj_theta[(wf+1)*state_previous->proj_stride];
+	double *theta_proj           = &fronts->proj_theta[wf*fronts->proj_stride];
+	double *theta_proj_below     = &fronts->proj_theta[(wf+1)*fronts->proj_stride];
+
 	for (int k=1; k<layer_num; k++) {
-	  int soil_num_k  = soil_type[k];
-	  theta_e_k = soil_properties[soil_num_k].theta_e;
-	  theta_r_k = soil_properties[soil_num_k].theta_r;
-	  vg_a_k    = soil_properties[soil_num_k].vg_alpha_per_cm;
-	  vg_m_k    = soil_properties[soil_num_k].vg_m;
-	  vg_n_k    = soil_properties[soil_num_k].vg_n;
-
-	  double theta_old = calc_theta_from_h(psi_cm_old, vg_a_k, vg_m_k, vg_n_k, theta_e_k,theta_r_k);
-	  double theta_below_old = calc_theta_from_h(psi_cm_below_old, vg_a_k, vg_m_k, vg_n_k, theta_e_k, theta_r_k);
+	  double theta_old = theta_proj_old[k];
+	  double theta_below_old = theta_proj_below_old[k];
 	  double local_delta_theta_old = theta_old - theta_below_old;
 	  double layer_thickness = (cum_layer_thickness_cm[k] - cum_layer_thickness_cm[k-1]);
 
@@ -1253,9 +1823,9 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
 
 	  //-------------------------------------------
 	  // do the same for the current state
-	  double theta = calc_theta_from_h(psi_cm, vg_a_k, vg_m_k, vg_n_k, theta_e_k, theta_r_k);
+	  double theta = theta_proj[k];
 
-	  double theta_below = calc_theta_from_h(psi_cm_below, vg_a_k, vg_m_k, vg_n_k, theta_e_k, theta_r_k);
+	  double theta_below = theta_proj_below[k];
 
 	  new_mass += layer_thickness * (theta - theta_below);
 
@@ -1263,8 +1833,8 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
 	  delta_thickness[k] = layer_thickness;
 	}
 
-	delta_thetas[layer_num] = next->theta;
-	delta_thickness[layer_num] = current->depth_cm - cum_layer_thickness_cm[layer_num-1];
+	delta_thetas[layer_num] = fronts->theta[wf+1];
+	delta_thickness[layer_num] = fronts->depth_cm[wf] - cum_layer_thickness_cm[layer_num-1];
 
 	double free_drainage_demand = 0;
   
@@ -1274,17 +1844,26 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
   // theta mass balance computes new theta that conserves the mass; new theta is assigned to the current wetting front
 
 	double theta_new = lgar_theta_mass_balance(layer_num, soil_num, psi_cm, new_mass, prior_mass, AET_demand_cm,
-						   delta_thetas, delta_thickness, soil_type, soil_properties);
+						   delta_thetas, delta_thickness, soil_type, soil_properties,
+						   psi_search_candidates, precision->mass_balance_tolerance_cm,
+						   precision->mass_balance_max_iter);
   actual_ET_demand = *AET_demand_cm;
 
-	current->theta = fmax(theta_r, fmin(theta_new, theta_e));
+	fronts->theta[wf] = fmax(theta_r, fmin(theta_new, theta_e));
 
       }
 
-      double Se = calc_Se_from_theta(current->theta,theta_e,theta_r);
-      current->psi_cm = calc_h_from_Se(Se, vg_a, vg_m, vg_n);
+      // the deleted front's slot now holds the next wetting front, which must not be updated here
+      if (!front_deleted) {
+	double Se = calc_Se_from_theta(fronts->theta[wf], &soil_properties[soil_num]);
+	fronts->psi_cm[wf] = calc_h_from_Se(Se, &soil_properties[soil_num]);
+      }
 
     }
+
+    // the depth and/or theta of the current wetting front changed, so update the column mass
+    if (!front_deleted)
+      lgar_update_front_mass(wf, cum_layer_thickness_cm, fronts);
   
 
     // if f_p (predicted infiltration) causes theta > theta_e, mass correction is needed.
@@ -1294,89 +1873,74 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
     if (wf == 1) { 
       //first do a test layer bdy cross and then recalc wf_free_drainage_demand
       lgar_wetting_fronts_cross_layer_boundary(num_layers, cum_layer_thickness_cm, soil_type, frozen_factor,
-					   head, soil_properties); //replacing with more complete code that does merging and crossing as necessary
+					   fronts, soil_properties); //replacing with more complete code that does merging and crossing as necessary
 
-      wf_free_drainage_demand = wetting_front_free_drainage(*head);
-    // if ((wf == wf_free_drainage_demand) && (current->theta>=theta_e) ) {
+      wf_free_drainage_demand = wetting_front_free_drainage(fronts);
+    // if ((wf == wf_free_drainage_demand) && (fronts->theta[wf]>=theta_e) ) {
       int soil_num_k1  = soil_type[wf_free_drainage_demand];
       double theta_e_k1 = soil_properties[soil_num_k1].theta_e;
 
-      struct wetting_front *wf_free_drainage = listFindFront(wf_free_drainage_demand, *head, NULL);
+      int wf_free_drainage = wf_free_drainage_demand;
 
       double mass_timestep = (old_mass + precip_mass_to_add) - (actual_ET_demand + free_drainage_demand);
 
       assert (old_mass > 0.0);
       
-      if (fabs(wf_free_drainage->theta - theta_e_k1) < 1E-15) {
+      if (fabs(fronts->theta[wf_free_drainage] - theta_e_k1) < 1E-15) {
 	
-	double current_mass = lgar_calc_mass_bal(cum_layer_thickness_cm, *head);
-
-	double mass_balance_error = fabs(current_mass - mass_timestep); // mass error
-
-	double factor = 1.0;
-  if (wf_free_drainage->next!=NULL){
-    if (fabs(wf_free_drainage->theta - wf_free_drainage->next->theta)<0.01){// if two adjacent theta values are quite close, an initial factor of 1.0 might not make the mass balance close within 10000 iterations
-      factor = factor / fabs(wf_free_drainage->theta - wf_free_drainage->next->theta);
-    }
-  }
-
-  // double factor = fmax(1,current->psi_cm/100); speed optimization should look at optimal factor values 
-	bool switched = false;
-	double tolerance = 1e-10;
-
-	// check if the difference is less than the tolerance
-	if (mass_balance_error <= tolerance) {
-	  // return current_mass;
-	}
-
-	double depth_new = wf_free_drainage->depth_cm;
-
-	// loop to adjust the depth for mass balance
-  int iter = 0;
-  bool iter_aug_flag = FALSE;
-  bool break_flag = FALSE;
-	while (fabs(mass_balance_error - tolerance) > 1.E-10) {
-    iter++;
-    if (iter>1e4) {
-      break_flag = TRUE;
-      *AET_demand_cm = *AET_demand_cm + mass_balance_error;
-      actual_ET_demand = *AET_demand_cm;
-      break;
-    }
-
-    if ((iter>1e3) && (!iter_aug_flag)){
-      factor = factor * 100;
-      iter_aug_flag = TRUE;
-    }
-
-	  if (current_mass < mass_timestep) {
-	    depth_new += 0.01 * factor;
-	    switched = false;
+	double current_mass = lgar_column_mass(cum_layer_thickness_cm, fronts);
+
+	double mass_balance_error = current_mass - mass_timestep; // mass error
+
+	double tolerance = precision->free_drainage_tolerance_cm;
+
+	/* the free drainage wetting front is saturated, so its depth is corrected to close the mass balance.
+	   Only the contribution of this front to the column mass depends on its depth, and it is linear in the depth
+	   (slope = theta of this front minus theta of the front below it in the same layer, or theta if it is the
+	   deepest front of its layer), so the correction is computed directly. A few secant steps on the recomputed
+	   mass guard against roundoff. The front is not allowed to move if it is at the bottom of the domain; in that
+	   case (or if the slope vanishes) the residual is handled below as before. */
+	double depth_old = fronts->depth_cm[wf_free_drainage];
+	double slope = fronts->theta[wf_free_drainage];
+	if (wf_free_drainage < listLength(fronts) &&
+	    fronts->layer_num[wf_free_drainage+1] == fronts->layer_num[wf_free_drainage])
+	  slope -= fronts->theta[wf_free_drainage+1];
+
+	bool depth_fixed = (fronts->to_bottom[wf_free_drainage]==TRUE) && (fronts->layer_num[wf_free_drainage]==num_layers);
+	bool break_flag = FALSE;
+
+	for (int iter = 1; fabs(mass_balance_error) > tolerance; iter++) {
+	  if (depth_fixed || fabs(slope) < 1.E-15 || iter > precision->free_drainage_max_iter) {
+	    break_flag = TRUE;
+	    *AET_demand_cm = *AET_demand_cm + fabs(mass_balance_error);
+	    actual_ET_demand = *AET_demand_cm;
+	    break;
 	  }
-	  else {
-	    if (!switched) {
-	      switched = true;
-	      factor = factor * 0.001;
-	    }
-	    depth_new -= 0.01 * factor;
 
-	  }
+	  double depth_new = fronts->depth_cm[wf_free_drainage] - mass_balance_error / slope;
 
-    if ( (wf_free_drainage->to_bottom==TRUE) && (wf_free_drainage->layer_num==num_layers) ){
-      depth_new = cum_layer_thickness_cm[num_layers];
-    }
+	  fronts->depth_cm[wf_free_drainage] = depth_new;
+
+	  // only the free drainage wetting front moved, so update the column mass incrementally
+	  double mass_new = lgar_update_front_mass(wf_free_drainage, cum_layer_thickness_cm, fronts);
 
-	  wf_free_drainage->depth_cm = depth_new;
+	  // secant update of the slope from the last two iterates (exact if the mass is linear in depth)
+	  if (fabs(depth_new - depth_old) > 1.E-15 && fabs(mass_new - current_mass) > 0.0)
+	    slope = (mass_new - current_mass) / (depth_new - depth_old);
 
-	  current_mass = lgar_calc_mass_bal(cum_layer_thickness_cm, *head);
-	  mass_balance_error = fabs(current_mass - mass_timestep);
+	  depth_old = depth_new;
+	  current_mass = mass_new;
+	  mass_balance_error = current_mass - mass_timestep;
 
+	  if (verbosity.compare("high") == 0)
+	    printf("Free drainage front depth correction: iteration = %d, depth = %.14e, mass error = %.6e \n",
+		   iter, depth_new, mass_balance_error);
 	}
 
   //there is a general class of problem where a very small psi value that is greater than 0 (say 1e-3 or so) will for some but not all soils mathematically yield theta = theta_e, even though theta should be slightly less than theta_e.
   //in layered soils, this can cause a mass balance error. It is fairly rare and only seems to impact cases where the model domain is entirely saturated, which shouldn't happen when LGAR is applied in the correct environment / with sufficient layer thicknesses.
   if (break_flag) {
-    current_mass = lgar_calc_mass_bal(cum_layer_thickness_cm, *head);
+    current_mass = lgar_column_mass(cum_layer_thickness_cm, fronts);
     mass_timestep = (old_mass + precip_mass_to_add) - (actual_ET_demand + free_drainage_demand);
     mass_balance_error = mass_timestep - current_mass;
     bottom_boundary_flux_cm += mass_balance_error;
@@ -1394,7 +1958,7 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
 
   if (verbosity.compare("high") == 0) {
     printf("State after moving but before merging wetting fronts...\n");
-    listPrint(*head);
+    listPrint(fronts);
   }
 
   // ********************** MERGING AND CROSSING WETTING FRONT ****************************
@@ -1413,45 +1977,53 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
      due to unknown corner/rare cases */
 
   double mass_change = 0.0;
-  
-  // *************************** MERGE ************************************
-  // check if dry over wet wetting fronts exist before calling merge
-  bool is_dry_over_wet_wf = lgar_check_dry_over_wet_wetting_fronts(*head);
-  
-  if (is_dry_over_wet_wf)
-    lgar_fix_dry_over_wet_wetting_fronts(&mass_change, cum_layer_thickness_cm, soil_type, head, soil_properties);
 
+  /* a single sweep finds which of the events below (dry over wet, merging, layer and domain boundary crossing)
+     can occur. In the common case that no wetting front overtook its neighbor or a boundary, each of the passes
+     below would walk the list without changing anything, so they are skipped altogether */
+  int front_events = lgar_scan_front_events(num_layers, cum_layer_thickness_cm, fronts);
 
-  lgar_merge_wetting_fronts(soil_type, frozen_factor, head, soil_properties);
+  if (front_events != FRONT_EVENT_NONE) {
 
+    // *************************** MERGE ************************************
+    // check if dry over wet wetting fronts exist before calling merge
+    bool is_dry_over_wet_wf = (front_events & FRONT_EVENT_DRY_OVER_WET); // same as lgar_check_dry_over_wet_wetting_fronts
 
-  // ************************ CROSS LAYER *********************************
-  lgar_wetting_fronts_cross_layer_boundary(num_layers, cum_layer_thickness_cm, soil_type, frozen_factor,
-					   head, soil_properties);
+    if (is_dry_over_wet_wf)
+      lgar_fix_dry_over_wet_wetting_fronts(&mass_change, cum_layer_thickness_cm, soil_type, fronts, soil_properties);
 
 
-  // *************************** MERGE ************************************
-  // check if dry over wet wetting fronts exist before calling merge
-  is_dry_over_wet_wf = lgar_check_dry_over_wet_wetting_fronts(*head);
-  
-  if (is_dry_over_wet_wf)
-    lgar_fix_dry_over_wet_wetting_fronts(&mass_change, cum_layer_thickness_cm, soil_type, head, soil_properties);
+    lgar_merge_wetting_fronts(soil_type, frozen_factor, cum_layer_thickness_cm, fronts, soil_properties);
 
-  lgar_merge_wetting_fronts(soil_type, frozen_factor, head, soil_properties);
 
-  // ************************ CROSS BOUNDARY ********************************
-  
-  //lower bound
-  bottom_boundary_flux_cm += lgar_wetting_front_cross_domain_boundary(cum_layer_thickness_cm[num_layers], soil_type,
-								      frozen_factor, head, soil_properties);
+    // ************************ CROSS LAYER *********************************
+    lgar_wetting_fronts_cross_layer_boundary(num_layers, cum_layer_thickness_cm, soil_type, frozen_factor,
+					     fronts, soil_properties);
 
-  *volin_cm = bottom_boundary_flux_cm;
-  
-  // reset current to head to fix any mass balance issues and dry-over-wet wetting fronts conditions
-  is_dry_over_wet_wf = lgar_check_dry_over_wet_wetting_fronts(*head);
-  
-  if (is_dry_over_wet_wf)
-    lgar_fix_dry_over_wet_wetting_fronts(&mass_change, cum_layer_thickness_cm, soil_type, head, soil_properties);
+
+    // *************************** MERGE ************************************
+    // check if dry over wet wetting fronts exist before calling merge
+    is_dry_over_wet_wf = lgar_check_dry_over_wet_wetting_fronts(fronts);
+
+    if (is_dry_over_wet_wf)
+      lgar_fix_dry_over_wet_wetting_fronts(&mass_change, cum_layer_thickness_cm, soil_type, fronts, soil_properties);
+
+    lgar_merge_wetting_fronts(soil_type, frozen_factor, cum_layer_thickness_cm, fronts, soil_properties);
+
+    // ************************ CROSS BOUNDARY ********************************
+
+    //lower bound
+    bottom_boundary_flux_cm += lgar_wetting_front_cross_domain_boundary(cum_layer_thickness_cm, num_layers, soil_type,
+									frozen_factor, fronts, soil_properties);
+
+    // check all wetting fronts again to fix any mass balance issues and dry-over-wet wetting fronts conditions
+    is_dry_over_wet_wf = lgar_check_dry_over_wet_wetting_fronts(fronts);
+
+    if (is_dry_over_wet_wf)
+      lgar_fix_dry_over_wet_wetting_fronts(&mass_change, cum_layer_thickness_cm, soil_type, fronts, soil_properties);
+  }
+
+  *volin_cm = bottom_boundary_flux_cm;
 
   if (verbosity.compare("high") == 0) {
     printf ("mass change/adjustment (dry_over_wet case) = %lf \n", mass_change);
@@ -1475,27 +2047,33 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
   // While that is ok for this soil layer in particular, adjacent wetting fronts above this one with a less sensitive soil water retention curve will yield a non-theta_e value for the psi value that is slightly above 0.
   // A solution is to either not run the following code, or to not run it when the wetting front is very close to saturation with a very sensitive soil water retention curve. Adding code that runs the following only for psi>1. 
 
-  current = *head;
+  // the fronts are updated independently of each other, up to max_batch at a time with the batch functions
+  const int max_batch = 16;
+  int    batch_wf[max_batch], batch_soil[max_batch];
+  double batch_Se[max_batch], batch_psi[max_batch], batch_K[max_batch];
 
-  for (int wf=1; wf != listLength(*head); wf++) {
+  int num_fronts = listLength(fronts);
+  int wf_next = 1;
 
-    if (current->psi_cm>1.0){
-      int soil_num_k    = soil_type[current->layer_num];
+  while (wf_next < num_fronts) {
+    int n = 0;
 
-      double theta_e_k   = soil_properties[soil_num_k].theta_e;
-      double theta_r_k   = soil_properties[soil_num_k].theta_r;
-      double vg_a_k      = soil_properties[soil_num_k].vg_alpha_per_cm;
-      double vg_m_k      = soil_properties[soil_num_k].vg_m;
-      double vg_n_k      = soil_properties[soil_num_k].vg_n;
+    for (; wf_next < num_fronts && n < max_batch; wf_next++) {
+      if (fronts->psi_cm[wf_next]>1.0){
+	batch_wf[n]   = wf_next;
+	batch_soil[n] = soil_type[fronts->layer_num[wf_next]];
+	batch_Se[n]   = calc_Se_from_theta(fronts->theta[wf_next], &soil_properties[batch_soil[n]]);
+	n++;
+      }
+    }
 
-      double Ksat_cm_per_h_k  = frozen_factor[current->layer_num] * soil_properties[soil_num_k].Ksat_cm_per_h;
+    calc_h_from_Se_batch(n, batch_Se, batch_soil, soil_properties, batch_psi);
+    calc_K_from_Se_batch(n, batch_Se, batch_soil, soil_properties, batch_K);
 
-      double Se = calc_Se_from_theta(current->theta,theta_e_k,theta_r_k);
-      current->psi_cm = calc_h_from_Se(Se, vg_a_k, vg_m_k, vg_n_k); 
-      current->K_cm_per_h = calc_K_from_Se(Se, Ksat_cm_per_h_k, vg_m_k);
+    for (int i = 0; i < n; i++) {
+      fronts->psi_cm[batch_wf[i]]     = batch_psi[i];
+      fronts->K_cm_per_h[batch_wf[i]] = frozen_factor[fronts->layer_num[batch_wf[i]]] * batch_K[i];
     }
-    current = current->next;
-
   }
 
 
@@ -1505,9 +2083,10 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
 
   //Just a check to make sure that, when there is only 1 layer, than the existing wetting front is at the correct depth.
   //This might have been fixed with other debugging related to scenarios with just 1 layer where the wetting front is completely satruated. Not sure this is necessary.
-  if (listLength(*head)==1) {
-    if (current->depth_cm != cum_layer_thickness_cm[1]) {
-      current->depth_cm = cum_layer_thickness_cm[1];
+  if (listLength(fronts)==1) {
+    if (fronts->depth_cm[1] != cum_layer_thickness_cm[1]) {
+      fronts->depth_cm[1] = cum_layer_thickness_cm[1];
+      lgar_update_front_mass(1, cum_layer_thickness_cm, fronts);
     }
   }
 
@@ -1521,84 +2100,130 @@ extern void lgar_move_wetting_fronts(double timestep_h, double *volin_cm, int wf
 */
 // ############################################################################################
 
-extern void lgar_merge_wetting_fronts(int *soil_type, double *frozen_factor, struct wetting_front** head,
-				      struct soil_properties_ *soil_properties)
+extern void lgar_merge_wetting_fronts(int *soil_type, double *frozen_factor, double *cum_layer_thickness_cm,
+				      struct wetting_front_list* fronts, struct soil_properties_ *soil_properties)
 {
   
-  struct wetting_front *current;
-  struct wetting_front *next;
-  struct wetting_front *next_to_next;
-  current = *head;
 
   if (verbosity.compare("high") == 0) {
     printf("State before merging wetting fronts...\n");
-    listPrint(*head);
+    listPrint(fronts);
     printf("Merging wetting fronts... \n");
   }
 
   // local variables
-  double theta_e,theta_r;
-  double vg_a, vg_m, vg_n;
   double Se, Ksat_cm_per_h;
   int layer_num, soil_num;
     
-  for (int wf=1; wf != listLength(*head); wf++) {
+  for (int wf=1; wf != listLength(fronts); wf++) {
     
     if (verbosity.compare("high") == 0) {
       printf("Merge | ********* Wetting Front = %d *********\n", wf);
     }
 
-
-    next = current->next;
-    next_to_next = current->next->next;
-
     // case : wetting front passing another wetting front within a layer
     /**********************************************************/
-    // 'current->depth_cm > next->depth_cm' ensures that merging is needed
-    // 'current->layer_num == next->layer_num' ensures wetting fronts are in the same layer
-    // '!next->to_bottom' ensures that the next wetting front is not the deepest wetting front in the layer
-    if ( (current->depth_cm > next->depth_cm) && (current->layer_num == next->layer_num) && !next->to_bottom) {
+    // 'fronts->depth_cm[wf] > fronts->depth_cm[wf+1]' ensures that merging is needed
+    // 'fronts->layer_num[wf] == fronts->layer_num[wf+1]' ensures wetting fronts are in the same layer
+    // '!fronts->to_bottom[wf+1]' ensures that the next wetting front is not the deepest wetting front in the layer
+    if ( (fronts->depth_cm[wf] > fronts->depth_cm[wf+1]) && (fronts->layer_num[wf] == fronts->layer_num[wf+1]) && !fronts->to_bottom[wf+1]) {
       
-      double current_mass_this_layer = current->depth_cm * (current->theta - next->theta) + next->depth_cm*(next->theta - next_to_next->theta);
-      current->depth_cm = current_mass_this_layer / (current->theta - next_to_next->theta);
+      double current_mass_this_layer = fronts->depth_cm[wf] * (fronts->theta[wf] - fronts->theta[wf+1]) + fronts->depth_cm[wf+1]*(fronts->theta[wf+1] - fronts->theta[wf+2]);
+      fronts->depth_cm[wf] = current_mass_this_layer / (fronts->theta[wf] - fronts->theta[wf+2]);
 
-      assert (current->depth_cm > 0.0);
+      // a non-positive depth (failed merge) is caught by lgar_check_fronts after the substep, which is rolled back
 
-      layer_num = current->layer_num;
+      layer_num = fronts->layer_num[wf];
       soil_num  = soil_type[layer_num];
-      theta_e   = soil_properties[soil_num].theta_e;
-      theta_r   = soil_properties[soil_num].theta_r;
-      vg_a      = soil_properties[soil_num].vg_alpha_per_cm;
-      vg_m      = soil_properties[soil_num].vg_m;
-      vg_n      = soil_properties[soil_num].vg_n;
-      Se        = calc_Se_from_theta(current->theta,theta_e,theta_r);
+      Se        = calc_Se_from_theta(fronts->theta[wf], &soil_properties[soil_num]);
 
-      Ksat_cm_per_h  = soil_properties[soil_num].Ksat_cm_per_h * frozen_factor[current->layer_num];
+      Ksat_cm_per_h  = soil_properties[soil_num].Ksat_cm_per_h * frozen_factor[fronts->layer_num[wf]];
 
-      current->psi_cm     = calc_h_from_Se(Se, vg_a, vg_m, vg_n);
-      current->K_cm_per_h = calc_K_from_Se(Se, Ksat_cm_per_h, vg_m);
+      fronts->psi_cm[wf]     = calc_h_from_Se(Se, &soil_properties[soil_num]);
+      fronts->K_cm_per_h[wf] = calc_K_from_Se(Se, Ksat_cm_per_h, &soil_properties[soil_num]);
       
       if (verbosity.compare("high") == 0) {
         printf ("Deleting wetting front (before)... \n");
-        listPrint(*head);
+        listPrint(fronts);
       }
       
-      listDeleteFront(next->front_num, head);
+      listDeleteFront(wf+1, fronts);
+
+      // the merged front has a new depth and a new neighbor below it
+      lgar_update_front_mass(wf, cum_layer_thickness_cm, fronts);
       
       if (verbosity.compare("high") == 0) {
         printf ("Deleting wetting front (after) ... \n");
-        listPrint(*head);
+        listPrint(fronts);
       }
     }
-    
-    current = current->next;
   }
 
   if (verbosity.compare("high") == 0) {
     printf("State after merging wetting fronts...\n");
-    listPrint(*head);
+    listPrint(fronts);
+  }
+
+}
+
+// ############################################################################################
+/*
+  optional coalescing of wetting fronts (see coalesce_theta_tolerance and coalesce_mass_tolerance in the config file).
+  Intermittent rain leaves many nearly identical wetting fronts in a layer, and the cost of moving them grows with
+  their number. A wetting front wf+1 that differs from the wetting front above it (wf, same layer) by less than the
+  theta tolerance, or that holds less water than the mass tolerance, is merged into wf the same way as in
+  lgar_merge_wetting_fronts: wf keeps its theta (and psi) and its depth is set such that the water in the layer is
+  unchanged. Only wet over dry fronts not extending to the layer bottom are merged, so that the new depth lies between
+  the old depths of wf and wf+1 and head continuity across layer boundaries is not affected.
+*/
+// ############################################################################################
+extern int lgar_coalesce_wetting_fronts(double theta_tolerance, double mass_tolerance_cm, double *cum_layer_thickness_cm,
+					struct wetting_front_list* fronts)
+{
+  int num_coalesced = 0;
+
+  if (theta_tolerance <= 0.0 && mass_tolerance_cm <= 0.0)
+    return num_coalesced;
+
+  int wf = 1;
+
+  while (wf + 2 <= listLength(fronts)) {
+    int layer_num = fronts->layer_num[wf];
+
+    bool same_layer = (fronts->layer_num[wf+1] == layer_num && fronts->layer_num[wf+2] == layer_num
+		       && !fronts->to_bottom[wf] && !fronts->to_bottom[wf+1]);
+    bool wet_over_dry = (fronts->theta[wf] > fronts->theta[wf+1] && fronts->theta[wf+1] > fronts->theta[wf+2]);
+
+    if (!same_layer || !wet_over_dry) {
+      wf++;
+      continue;
+    }
+
+    double base_depth_cm = cum_layer_thickness_cm[layer_num-1];
+    double mass_wf_cm    = (fronts->depth_cm[wf]   - base_depth_cm) * (fronts->theta[wf]   - fronts->theta[wf+1]);
+    double mass_next_cm  = (fronts->depth_cm[wf+1] - base_depth_cm) * (fronts->theta[wf+1] - fronts->theta[wf+2]);
+
+    if (fronts->theta[wf] - fronts->theta[wf+1] >= theta_tolerance && mass_next_cm >= mass_tolerance_cm) {
+      wf++;
+      continue;
+    }
+
+    if (verbosity.compare("high") == 0)
+      printf("Coalescing wetting fronts %d and %d (theta = %lf, %lf; mass of the deeper front = %.6e cm) \n",
+	     wf, wf+1, fronts->theta[wf], fronts->theta[wf+1], mass_next_cm);
+
+    fronts->depth_cm[wf] = base_depth_cm + (mass_wf_cm + mass_next_cm) / (fronts->theta[wf] - fronts->theta[wf+2]);
+
+    listDeleteFront(wf+1, fronts);
+    lgar_update_front_mass(wf, cum_layer_thickness_cm, fronts);
+    num_coalesced++;
+    // wf is compared against its new neighbor below in the next pass
   }
 
+  if (num_coalesced > 0)
+    lgar_front_cache_invalidate(fronts);
+
+  return num_coalesced;
 }
 
 
@@ -1611,90 +2236,75 @@ extern void lgar_merge_wetting_fronts(int *soil_type, double *frozen_factor, str
 
 extern void lgar_wetting_fronts_cross_layer_boundary(int num_layers,
 						     double* cum_layer_thickness_cm, int *soil_type,
-						     double *frozen_factor, struct wetting_front** head,
+						     double *frozen_factor, struct wetting_front_list* fronts,
 						     struct soil_properties_ *soil_properties)
 {
-  struct wetting_front *current;
-  struct wetting_front *next;
-  struct wetting_front *next_to_next;
-  current = *head; 
 
   if (verbosity.compare("high") == 0) {
     printf("Layer boundary crossing... \n");
   }
 
-  for (int wf=1; wf != listLength(*head); wf++) {
+  for (int wf=1; wf != listLength(fronts); wf++) {
     
     if (verbosity.compare("high") == 0) {
       printf("Boundary Crossing | ******* Wetting Front = %d ****** \n", wf);
     }
     
     // local variables
-    double theta_e,theta_r;
-    double vg_a, vg_m, vg_n;
+    double theta_e;
     int layer_num, soil_num;
 
 
-    layer_num   = current->layer_num;
+    layer_num   = fronts->layer_num[wf];
     soil_num    = soil_type[layer_num];
     theta_e     = soil_properties[soil_num].theta_e;
-    theta_r     = soil_properties[soil_num].theta_r;
-    vg_a        = soil_properties[soil_num].vg_alpha_per_cm;
-    vg_m        = soil_properties[soil_num].vg_m;
-    vg_n        = soil_properties[soil_num].vg_n;
-    double Ksat_cm_per_h  = soil_properties[soil_num].Ksat_cm_per_h * frozen_factor[current->layer_num]; //PTL addition to make K_cm_per_h for this conditon to be correct
-    
-    next = current->next;
-    next_to_next = current->next->next;
+    double Ksat_cm_per_h  = soil_properties[soil_num].Ksat_cm_per_h * frozen_factor[fronts->layer_num[wf]]; //PTL addition to make K_cm_per_h for this conditon to be correct
 
-    if (current->depth_cm > cum_layer_thickness_cm[layer_num] && (next->depth_cm == cum_layer_thickness_cm[layer_num])
+    if (fronts->depth_cm[wf] > cum_layer_thickness_cm[layer_num] && (fronts->depth_cm[wf+1] == cum_layer_thickness_cm[layer_num])
 	&& (layer_num!=num_layers) ) {
       
-      double current_theta = fmin(theta_e, current->theta);
-      double overshot_depth = current->depth_cm - next->depth_cm;
+      double current_theta = fmin(theta_e, fronts->theta[wf]);
+      double overshot_depth = fronts->depth_cm[wf] - fronts->depth_cm[wf+1];
       int soil_num_next = soil_type[layer_num+1];
 
-      double next_theta_e   = soil_properties[soil_num_next].theta_e;
-      double next_theta_r   = soil_properties[soil_num_next].theta_r;
-      double next_vg_a      = soil_properties[soil_num_next].vg_alpha_per_cm;
-      double next_vg_m      = soil_properties[soil_num_next].vg_m;
-      double next_vg_n      = soil_properties[soil_num_next].vg_n;
-      //double next_Ksat_cm_per_h  = soil_properties[soil_num_next].Ksat_cm_per_h * frozen_factor[current->layer_num]; 
+      //double next_Ksat_cm_per_h  = soil_properties[soil_num_next].Ksat_cm_per_h * frozen_factor[fronts->layer_num[wf]]; 
 
-      double Se = calc_Se_from_theta(current->theta,theta_e, theta_r);
-      current->psi_cm = calc_h_from_Se(Se, vg_a, vg_m, vg_n);
+      double Se = calc_Se_from_theta(fronts->theta[wf], &soil_properties[soil_num]);
+      fronts->psi_cm[wf] = calc_h_from_Se(Se, &soil_properties[soil_num]);
 
-      current->K_cm_per_h = calc_K_from_Se(Se, Ksat_cm_per_h, vg_m);
+      fronts->K_cm_per_h[wf] = calc_K_from_Se(Se, Ksat_cm_per_h, &soil_properties[soil_num]);
       
       // current psi with van Gunechten properties of the next layer to get new theta
-      double theta_new = calc_theta_from_h(current->psi_cm, next_vg_a, next_vg_m, next_vg_n, next_theta_e, next_theta_r);
+      double theta_new = calc_theta_from_h(fronts->psi_cm[wf], &soil_properties[soil_num_next]);
 
-      double mbal_correction = overshot_depth * (current_theta - next->theta);
-      double mbal_Z_correction = mbal_correction / (theta_new - next_to_next->theta); // this is the new wetting front depth
+      double mbal_correction = overshot_depth * (current_theta - fronts->theta[wf+1]);
+      double mbal_Z_correction = mbal_correction / (theta_new - fronts->theta[wf+2]); // this is the new wetting front depth
       if (isinf(mbal_Z_correction)){//in some rare cases, due to (very) different shapes of soil water rentention curves in adjacent soil layers near saturation, the WF that crossed a layer bdy can yield a theta value identical to the one below it, resulting in division by 0 and an infinite WF depth. 
         mbal_Z_correction = cum_layer_thickness_cm[layer_num+1]/(1e3);
       }
 
       double depth_new = cum_layer_thickness_cm[layer_num] + mbal_Z_correction; // this is the new wetting front absolute depth
 
-      current->depth_cm = cum_layer_thickness_cm[layer_num];
+      fronts->depth_cm[wf] = cum_layer_thickness_cm[layer_num];
       
-      next->theta = theta_new;
-      next->psi_cm = current->psi_cm;
-      next->depth_cm = depth_new;
-      next->layer_num = layer_num + 1;
-      next->dzdt_cm_per_h = current->dzdt_cm_per_h;
-      current->dzdt_cm_per_h = 0;
-      current->to_bottom = TRUE;
-      next->to_bottom = FALSE;
+      fronts->theta[wf+1] = theta_new;
+      fronts->psi_cm[wf+1] = fronts->psi_cm[wf];
+      fronts->depth_cm[wf+1] = depth_new;
+      fronts->layer_num[wf+1] = layer_num + 1;
+      fronts->dzdt_cm_per_h[wf+1] = fronts->dzdt_cm_per_h[wf];
+      fronts->dzdt_cm_per_h[wf] = 0;
+      fronts->to_bottom[wf] = TRUE;
+      fronts->to_bottom[wf+1] = FALSE;
+
+      // the crossing front is now front wf+1; this updates the contributions of both fronts
+      lgar_update_front_mass(wf+1, cum_layer_thickness_cm, fronts);
       
     }
     
     if (verbosity.compare("high") == 0) {
       printf("States after wetting fronts cross layer boundary...\n");
-      listPrint(*head);
+      listPrint(fronts);
     }
-    current = current->next;
   }
   
 }
@@ -1706,24 +2316,19 @@ extern void lgar_wetting_fronts_cross_layer_boundary(int num_layers,
 */
 // ############################################################################################
 
-extern double lgar_wetting_front_cross_domain_boundary(double domain_depth_cm, int *soil_type,
-						       double *frozen_factor, struct wetting_front** head,
+extern double lgar_wetting_front_cross_domain_boundary(double *cum_layer_thickness_cm, int num_layers, int *soil_type,
+						       double *frozen_factor, struct wetting_front_list* fronts,
 						       struct soil_properties_ *soil_properties)
 {
-  struct wetting_front *current;
-  struct wetting_front *next;
-  struct wetting_front *next_to_next;
-  current = *head; 
   double bottom_flux_cm = 0.0;
-  int length = listLength(*head);
+  double domain_depth_cm = cum_layer_thickness_cm[num_layers];
+  int length = listLength(fronts);
   
   if (verbosity.compare("high") == 0) {
     printf("Domain boundary crossing (bottom flux calc.) \n");
   }
 
   // local variables
-  double theta_e,theta_r;
-  double vg_a, vg_m, vg_n;
   double bottom_flux_cm_temp;
   int layer_num, soil_num;
     
@@ -1734,39 +2339,30 @@ extern double lgar_wetting_front_cross_domain_boundary(double domain_depth_cm, i
     }
 
     // ensure that loop iterations never exceed the total number of wetting fronts after altering the list
-    if (wf >= listLength(*head))
+    if (wf >= listLength(fronts))
       break;
     
     bottom_flux_cm_temp = 0.0;
     
-    layer_num   = current->layer_num;
+    layer_num   = fronts->layer_num[wf];
     soil_num    = soil_type[layer_num];
     
-    next = current->next;
-    next_to_next = current->next->next;
-    
     // case : wetting front is the deepest one in the last layer (most deepested wetting front in the domain)
     /**********************************************************/
-    if (next_to_next == NULL && current->depth_cm >= domain_depth_cm) {
+    if (wf+1 == listLength(fronts) && fronts->depth_cm[wf] >= domain_depth_cm) {
       //  this is the water leaving the system through the bottom of the soil
-      bottom_flux_cm_temp = (current->theta - next->theta) *  (current->depth_cm - next->depth_cm);
-      theta_e   = soil_properties[soil_num].theta_e;
-      theta_r   = soil_properties[soil_num].theta_r;
-      vg_a      = soil_properties[soil_num].vg_alpha_per_cm;
-      vg_m      = soil_properties[soil_num].vg_m;
-      vg_n      = soil_properties[soil_num].vg_n;
-      double Ksat_cm_per_h  = soil_properties[soil_num].Ksat_cm_per_h * frozen_factor[current->layer_num];
-
-      next->theta = current->theta;
-      double Se_k = calc_Se_from_theta(current->theta,theta_e,theta_r);
-      next->psi_cm = calc_h_from_Se(Se_k, vg_a, vg_m, vg_n);
-      next->K_cm_per_h = calc_K_from_Se(Se_k, Ksat_cm_per_h, vg_m);
-      current = listDeleteFront(current->front_num, head);
+      bottom_flux_cm_temp = (fronts->theta[wf] - fronts->theta[wf+1]) *  (fronts->depth_cm[wf] - fronts->depth_cm[wf+1]);
+      double Ksat_cm_per_h  = soil_properties[soil_num].Ksat_cm_per_h * frozen_factor[fronts->layer_num[wf]];
+
+      fronts->theta[wf+1] = fronts->theta[wf];
+      double Se_k = calc_Se_from_theta(fronts->theta[wf], &soil_properties[soil_num]);
+      fronts->psi_cm[wf+1] = calc_h_from_Se(Se_k, &soil_properties[soil_num]);
+      fronts->K_cm_per_h[wf+1] = calc_K_from_Se(Se_k, Ksat_cm_per_h, &soil_properties[soil_num]);
+      listDeleteFront(wf, fronts);
+      lgar_update_front_mass(wf, cum_layer_thickness_cm, fronts);
       bottom_flux_cm += bottom_flux_cm_temp; 
       break;
     }
-    
-    current = current->next;
 
     if (bottom_flux_cm_temp!=0){//PTL: perhaps due to potential problems with precision error, this should just be replaces with a flag that gets toggled when bottom_boundary_flux_cm is changed from 0 to nonzero
       break;
@@ -1775,7 +2371,7 @@ extern double lgar_wetting_front_cross_domain_boundary(double domain_depth_cm, i
 
   if (verbosity.compare("high") == 0) {
     printf("State after lowest wetting front contributes to flux through the bottom boundary...\n");
-    listPrint(*head);
+    listPrint(fronts);
     printf("Bottom boundary flux = %lf \n",bottom_flux_cm);
   }
 
@@ -1790,64 +2386,52 @@ extern double lgar_wetting_front_cross_domain_boundary(double domain_depth_cm, i
   and the front gets drier than the lower wetting front */
 // ############################################################################################
 extern void lgar_fix_dry_over_wet_wetting_fronts(double *mass_change, double* cum_layer_thickness_cm, int *soil_type,
-					 struct wetting_front** head, struct soil_properties_ *soil_properties)
+					 struct wetting_front_list* fronts, struct soil_properties_ *soil_properties)
 {
   if (verbosity.compare("high") == 0) {
     printf("Fix Dry over Wet Wetting Front... \n");
   }
 
-  struct wetting_front *current;
-  struct wetting_front *next;
-  current = *head;
-  next = current->next;
-
-  for (int l=1; l <= listLength(*head); l++) {
-    if (next != NULL) {
+  for (int l=1; l <= listLength(fronts); l++) {
+    if (l < listLength(fronts)) {
       // this part fixes case of upper theta less than lower theta due to AET extraction
       // also handles the case when the current and next wetting fronts have the same theta
       // and are within the same layer
       /***************************************************/
 
-      if ( (current->theta <= next->theta) && (current->layer_num == next->layer_num) ) {
-	int layer_num_k = current->layer_num;
-	double mass_before = lgar_calc_mass_bal(cum_layer_thickness_cm, *head);
+      if ( (fronts->theta[l] <= fronts->theta[l+1]) && (fronts->layer_num[l] == fronts->layer_num[l+1]) ) {
+	int layer_num_k = fronts->layer_num[l];
+	double mass_before = lgar_column_mass(cum_layer_thickness_cm, fronts);
 
-	current = listDeleteFront(current->front_num, head);
+	listDeleteFront(l, fronts);
 	
 	// if the dry wetting front is the most surficial then simply track the mass change
 	// due to the deletion of the wetting front;
 	// this needs to be revised
 	if (layer_num_k > 1) {
-	  int soil_num_k    = soil_type[current->layer_num];
-	  double theta_e_k  = soil_properties[soil_num_k].theta_e;
-	  double theta_r_k  = soil_properties[soil_num_k].theta_r;
-	  double vg_a_k     = soil_properties[soil_num_k].vg_alpha_per_cm;
-	  double vg_m_k     = soil_properties[soil_num_k].vg_m;
-	  double vg_n_k     = soil_properties[soil_num_k].vg_n;
-	  double Se_k       = calc_Se_from_theta(current->theta,theta_e_k,theta_r_k);
+	  int soil_num_k    = soil_type[fronts->layer_num[l]];
+	  double Se_k       = calc_Se_from_theta(fronts->theta[l], &soil_properties[soil_num_k]);
 
 	  // now this is the wetting front that was below the dry wetting front
-	  current->psi_cm = calc_h_from_Se(Se_k, vg_a_k, vg_m_k, vg_n_k);
+	  fronts->psi_cm[l] = calc_h_from_Se(Se_k, &soil_properties[soil_num_k]);
 
-	  struct wetting_front *current_local = *head; //In LGARTO, should be the highest to_bottom WF above the one that got deleted before the next to_bottom==FALSE one, but *head is fine for LGAR 
+	  int wf_local = 1; //In LGARTO, should be the highest to_bottom WF above the one that got deleted before the next to_bottom==FALSE one, but the first front is fine for LGAR 
 
 	  // update psi and theta for all wetting fronts above the current wetting front
-	  while (current_local->layer_num < layer_num_k) {
-	    int soil_num_k1 = soil_type[current_local->layer_num];
-	    theta_e_k   = soil_properties[soil_num_k1].theta_e;
-	    theta_r_k   = soil_properties[soil_num_k1].theta_r;
-	    vg_a_k      = soil_properties[soil_num_k1].vg_alpha_per_cm;
-	    vg_m_k      = soil_properties[soil_num_k1].vg_m;
-	    vg_n_k      = soil_properties[soil_num_k1].vg_n;
-
-      current_local->psi_cm = current->psi_cm;
-
-      current_local->theta = calc_theta_from_h(current->psi_cm, vg_a_k, vg_m_k, vg_n_k,theta_e_k,theta_r_k);
-	    current_local = current_local->next;
+	  // (their mass contributions changed, so update the column mass as well)
+	  while (fronts->layer_num[wf_local] < layer_num_k) {
+	    int soil_num_k1 = soil_type[fronts->layer_num[wf_local]];
+
+      fronts->psi_cm[wf_local] = fronts->psi_cm[l];
+
+      fronts->theta[wf_local] = calc_theta_from_h(fronts->psi_cm[l], &soil_properties[soil_num_k1]);
+	    lgar_update_front_mass(wf_local, cum_layer_thickness_cm, fronts);
+	    wf_local++;
 	  }
 	}
 
-	double mass_after = lgar_calc_mass_bal(cum_layer_thickness_cm, *head);
+	// the front above the deleted one has a new neighbor below it
+	double mass_after = lgar_update_front_mass(l, cum_layer_thickness_cm, fronts);
 	*mass_change += fabs(mass_after - mass_before);
 
 	/* note: mass_before is less when we have wetter front over drier front condition,
@@ -1856,50 +2440,139 @@ extern void lgar_fix_dry_over_wet_wetting_fronts(double *mass_change, double* cu
 	   might be one option, but for now we are adding fabs to mass_change to make sure we added extra water
 	   back to AET after deleting the drier front */
 
+	/* note: the wetting front that was below the dry wetting front now sits at position l; like before,
+	   the check continues with the wetting front below it */
       }
-      
-      current = current->next;
-
-      if (current == NULL)
-	next = NULL;
-      else
-	next = current->next;
 
     }
   }
 
 }
 
+// ############################################################################################
+/* The function sweeps the wetting fronts once and returns the events (FRONT_EVENT_* flags) that
+   the post-move passes of lgar_move_wetting_fronts would act on: dry over wet fronts, a front
+   passing another front within a layer (merge), a front passing a layer boundary, and the deepest
+   front reaching the bottom of the domain. The conditions are the same as in those passes */
+// ############################################################################################
+extern int lgar_scan_front_events(int num_layers, double *cum_layer_thickness_cm, struct wetting_front_list* fronts)
+{
+  int events = FRONT_EVENT_NONE;
+  int length = listLength(fronts);
+
+  for (int wf=1; wf < length; wf++) {
+    int layer_num = fronts->layer_num[wf];
+
+    if ( (fronts->theta[wf] <= fronts->theta[wf+1]) && (layer_num == fronts->layer_num[wf+1]) )
+      events |= FRONT_EVENT_DRY_OVER_WET;
+
+    if ( (fronts->depth_cm[wf] > fronts->depth_cm[wf+1]) && (layer_num == fronts->layer_num[wf+1]) && !fronts->to_bottom[wf+1])
+      events |= FRONT_EVENT_MERGE;
+
+    if (fronts->depth_cm[wf] > cum_layer_thickness_cm[layer_num] && (fronts->depth_cm[wf+1] == cum_layer_thickness_cm[layer_num])
+	&& (layer_num != num_layers) )
+      events |= FRONT_EVENT_CROSS_LAYER;
+
+    if (wf+1 == length && fronts->depth_cm[wf] >= cum_layer_thickness_cm[num_layers])
+      events |= FRONT_EVENT_CROSS_DOMAIN;
+  }
+
+  return events;
+}
+
 // ############################################################################################
 /* The function handles situation of dry over wet wetting fronts
   mainly happen when AET extracts more water from the upper wetting front
   and the front gets drier than the lower wetting front */
 // ############################################################################################
-extern bool lgar_check_dry_over_wet_wetting_fronts(struct wetting_front* head)
+extern bool lgar_check_dry_over_wet_wetting_fronts(struct wetting_front_list* fronts)
 {
-  struct wetting_front *current = head;
-  struct wetting_front *next    = current->next;
-  int length = listLength(head);
+  int length = listLength(fronts);
   
-  for (int l=1; l <= length; l++) {
-    if (next != NULL) {
-      
-      if ( (current->theta <= next->theta) && (current->layer_num == next->layer_num) )
-	return true;
-      
-      current = current->next;
-      
-      if (current == NULL)
-	next = NULL;
-      else
-	next = current->next;
-      
-    }
-    
+  for (int l=1; l < length; l++) {
+    if ( (fronts->theta[l] <= fronts->theta[l+1]) && (fronts->layer_num[l] == fronts->layer_num[l+1]) )
+      return true;
   }
   
   return false;
 }
+
+// ############################################################################################
+/* The function checks the wetting fronts at the end of a substep: depths positive and finite, theta finite, and
+   fronts sorted by depth. A failed check rolls the substep back (see BmiLGAR::Update) */
+// ############################################################################################
+extern int lgar_check_fronts(struct wetting_front_list* fronts)
+{
+  int length = listLength(fronts);
+
+  for (int wf=1; wf <= length; wf++) {
+    if ( !(fronts->depth_cm[wf] > 0.0 && fronts->depth_cm[wf] <= DBL_MAX) || !isfinite(fronts->theta[wf]) )
+      return FRONT_CHECK_DEPTH;
+
+    if (wf < length && fronts->depth_cm[wf] > fronts->depth_cm[wf+1])
+      return FRONT_CHECK_ORDER;
+  }
+
+  return FRONT_CHECK_OK;
+}
+
+// ############################################################################################
+/* The function prepares the corrector of Heun's method: the wetting fronts are moved again from the start of the
+   substep with the mean of dz/dt at the start (state_previous) and at the end (fronts) of the Euler predictor. The
+   theta of the fronts follow from the mass balance of lgar_move_wetting_fronts, as for the predictor.
+   - a predictor that merged fronts or moved them across a layer or the domain boundary has no front by front match with
+     the start, and the step is retried with half the step (HEUN_HALVE), so that the event is placed in time; a
+     predictor that created a surficial front is kept, since the front depends on the substep
+   - a predictor whose correction would move no front by more than tolerance_cm is kept (HEUN_KEEP_EULER) */
+// ############################################################################################
+extern int lgar_heun_dzdt(double timestep_h, double tolerance_cm, struct wetting_front_list* state_previous,
+			  struct wetting_front_list* fronts, double *dzdt_cm_per_h)
+{
+  int length = listLength(fronts);
+
+  if (length > listLength(state_previous))
+    return HEUN_KEEP_EULER;
+
+  if (length < listLength(state_previous))
+    return HEUN_HALVE;
+
+  for (int wf=1; wf <= length; wf++) {
+    if (fronts->layer_num[wf] != state_previous->layer_num[wf] || fronts->to_bottom[wf] != state_previous->to_bottom[wf])
+      return HEUN_HALVE;
+  }
+
+  double correction_cm = 0.0; // largest change of the front depths by the corrector
+
+  for (int wf=1; wf <= length; wf++) {
+    dzdt_cm_per_h[wf] = 0.5 * (state_previous->dzdt_cm_per_h[wf] + fronts->dzdt_cm_per_h[wf]);
+    correction_cm = fmax(correction_cm, fabs(dzdt_cm_per_h[wf] - state_previous->dzdt_cm_per_h[wf]) * timestep_h);
+  }
+
+  return (correction_cm > tolerance_cm) ? HEUN_CORRECT : HEUN_KEEP_EULER;
+}
+
+// ############################################################################################
+/* The function returns the substep for a calm period (no rain, no ponded water), in units of
+   2^-LGAR_MAX_STEP_HALVINGS model timesteps: the model timestep doubled while the substep stays within units_max
+   and no wetting front, at its current dz/dt, would move more than max_front_move_cm */
+// ############################################################################################
+extern int lgar_adaptive_substep_units(double timestep_h, int units_max, double max_front_move_cm,
+				       struct wetting_front_list* fronts)
+{
+  const int units_per_step = 1 << LGAR_MAX_STEP_HALVINGS;
+  int length = listLength(fronts);
+  double max_dzdt_cm_per_h = 0.0;
+
+  for (int wf=1; wf <= length; wf++)
+    max_dzdt_cm_per_h = fmax(max_dzdt_cm_per_h, fabs(fronts->dzdt_cm_per_h[wf]));
+
+  int units = units_per_step;
+
+  while (2*units <= units_max && max_dzdt_cm_per_h * timestep_h * (2*units) / units_per_step <= max_front_move_cm)
+    units *= 2;
+
+  return units;
+}
       
 // ############################################################################################
 /* The module computes the potential infiltration capacity, fp (in the lgar manuscript),
@@ -1909,37 +2582,32 @@ extern bool lgar_check_dry_over_wet_wetting_fronts(struct wetting_front* head)
    in the current timestep, that is precipitation in the current and previous
    timesteps was greater than zero */
 // ############################################################################################
-extern double lgar_insert_water(bool use_closed_form_G, int nint, double timestep_h, double AET_demand_cm, double *ponded_depth_cm,
+extern double lgar_insert_water(bool use_closed_form_G, double geff_tolerance, double timestep_h, double AET_demand_cm, double *ponded_depth_cm,
 				double *volin_this_timestep, double precip_timestep_cm, int wf_free_drainage_demand,
 			        int num_layers, double ponded_depth_max_cm, int *soil_type,
-				double *cum_layer_thickness_cm, double *frozen_factor,
-				struct wetting_front* head, struct soil_properties_ *soil_properties)
+				double *cum_layer_thickness_cm, double *frozen_factor, double *cum_layer_resistance_h,
+				double max_storage_cm, struct wetting_front_list* fronts, struct soil_properties_ *soil_properties)
 {
   // note ponded_depth_cm is a pointer.   Access its value as (*ponded_depth_cm).
 
   int wf_that_supplies_free_drainage_demand = wf_free_drainage_demand;
 
   // local vars
-  double theta_e, theta_r;
-  double vg_a, vg_m, vg_n,Ksat_cm_per_h;
-  double h_min_cm;
-  struct wetting_front *current;
-  struct wetting_front *current_free_drainage;
-  struct wetting_front *current_free_drainage_next;
+  double theta_e;
+  double Ksat_cm_per_h;
+  int wf_free_drainage; // the wetting front that supplies free drainage demand (the free drainage wetting front)
   int soil_num;
   double f_p = 0.0;
   double runoff = 0.0;
 
   double h_p = fmax(*ponded_depth_cm - precip_timestep_cm * timestep_h, 0.0); // water ponded on the surface
 
-  current = head;
-  current_free_drainage      = listFindFront(wf_that_supplies_free_drainage_demand, head, NULL);
-  current_free_drainage_next = listFindFront(wf_that_supplies_free_drainage_demand+1, head, NULL);
+  wf_free_drainage = wf_that_supplies_free_drainage_demand;
 
-  int number_of_wetting_fronts = listLength(head);
+  int number_of_wetting_fronts = listLength(fronts);
 
   //int last_wetting_front_index = number_of_wetting_fronts;
-  int layer_num_fp = current_free_drainage->layer_num;
+  int layer_num_fp = fronts->layer_num[wf_free_drainage];
 
 
   double Geff;
@@ -1947,71 +2615,55 @@ extern double lgar_insert_water(bool use_closed_form_G, int nint, double timeste
   if (number_of_wetting_fronts == num_layers) {
     Geff = 0.0; // i.e., case of no capillary suction, dz/dt is also zero for all wetting fronts
     soil_num = soil_type[layer_num_fp];
-    Ksat_cm_per_h = soil_properties[soil_num].Ksat_cm_per_h * frozen_factor[current->layer_num]; //23 feb 2024
+    Ksat_cm_per_h = soil_properties[soil_num].Ksat_cm_per_h * frozen_factor[fronts->layer_num[1]]; //23 feb 2024
   }
   else {
 
-    //double theta = current_free_drainage->theta;
-    double theta_below = current_free_drainage_next->theta;
+    //double theta = fronts->theta[wf_free_drainage];
+    double theta_below = fronts->theta[wf_free_drainage+1];
 
     soil_num = soil_type[layer_num_fp];
 
     theta_e = soil_properties[soil_num].theta_e;  // rhs of the new front, assumes theta_e as per Peter
-    theta_r = soil_properties[soil_num].theta_r;
-    h_min_cm = soil_properties[soil_num].h_min_cm;
-    vg_a     = soil_properties[soil_num].vg_alpha_per_cm;
-    vg_m     = soil_properties[soil_num].vg_m;
-    vg_n     = soil_properties[soil_num].vg_n;
-    double lambda = soil_properties[soil_num].bc_lambda;
-    double bc_psib_cm = soil_properties[soil_num].bc_psib_cm;
-    Ksat_cm_per_h = soil_properties[soil_num].Ksat_cm_per_h * frozen_factor[current->layer_num];
+    Ksat_cm_per_h = soil_properties[soil_num].Ksat_cm_per_h * frozen_factor[fronts->layer_num[1]];
 
     // Se = calc_Se_from_theta(theta,theta_e,theta_r);
     // psi_cm = calc_h_from_Se(Se, vg_a, vg_m, vg_n);
 
-    Geff = calc_Geff(use_closed_form_G, theta_below, theta_e, theta_e, theta_r, vg_a, vg_n, vg_m, h_min_cm, Ksat_cm_per_h, nint, lambda, bc_psib_cm); 
+    Geff = calc_Geff(use_closed_form_G || soil_properties[soil_num].use_closed_form_G, theta_below, theta_e, &soil_properties[soil_num], Ksat_cm_per_h,
+		     geff_tolerance);
 
   }
 
   // if the free_drainage wetting front is the top most, then the potential infiltration capacity has the following simple form
   if (layer_num_fp == 1) {
-      f_p = Ksat_cm_per_h * (1 + (Geff + h_p)/current_free_drainage->depth_cm);
+      f_p = Ksat_cm_per_h * (1 + (Geff + h_p)/fronts->depth_cm[wf_free_drainage]);
   }
   else {
     // point here to the equation in lgar paper once published
-    double bottom_sum = (current_free_drainage->depth_cm - cum_layer_thickness_cm[layer_num_fp-1])/Ksat_cm_per_h;
-
-    for (int k = 1; k < layer_num_fp; k++) {
-      int soil_num_k = soil_type[layer_num_fp-k];
-      double Ksat_cm_per_h_k = soil_properties[soil_num_k].Ksat_cm_per_h * frozen_factor[layer_num_fp - k];
+    // resistance of the free drainage front's own layer down to the front, plus that of all layers above it
+    double bottom_sum = (fronts->depth_cm[wf_free_drainage] - cum_layer_thickness_cm[layer_num_fp-1])/Ksat_cm_per_h;
 
-      bottom_sum += (cum_layer_thickness_cm[layer_num_fp - k] - cum_layer_thickness_cm[layer_num_fp - (k+1)])/ Ksat_cm_per_h_k;
-    }
+    bottom_sum += cum_layer_resistance_h[layer_num_fp-1];
 
-    f_p = (current_free_drainage->depth_cm / bottom_sum) + ((Geff + h_p)*Ksat_cm_per_h/(current_free_drainage->depth_cm)); //Geff + h_p
+    f_p = (fronts->depth_cm[wf_free_drainage] / bottom_sum) + ((Geff + h_p)*Ksat_cm_per_h/(fronts->depth_cm[wf_free_drainage])); //Geff + h_p
 
   }
 
   // checkpoint # AJ
-  int soil_num_k = soil_type[head->layer_num];
+  int soil_num_k = soil_type[fronts->layer_num[1]];
   double theta_e1 = soil_properties[soil_num_k].theta_e; // saturated theta of top layer
 
   // if free drainge has to be included, which currently we don't, then the following will be set to hydraulic conductivity
   // of the deeepest layer
-  if ((layer_num_fp == num_layers) && (current_free_drainage->theta == theta_e1) && (num_layers == number_of_wetting_fronts))
+  if ((layer_num_fp == num_layers) && (fronts->theta[wf_free_drainage] == theta_e1) && (num_layers == number_of_wetting_fronts))
     f_p = fmin(f_p, AET_demand_cm/timestep_h); //the idea here is that, if the soil is completely saturated, a little bit of water can still enter if AET is sufficiently large 
 
   //this code checks if there is enough storage available for infiltrating water. That is, f_p can only be as big as there is room for water. 
-  double current_mass = lgar_calc_mass_bal(cum_layer_thickness_cm, head);
-  double max_storage = 0.0;
-  for (int k = 1; k < num_layers+1; k++) {
-    int layer_num = k;
-    soil_num = soil_type[layer_num];
-    max_storage += soil_properties[soil_num].theta_e * (cum_layer_thickness_cm[k]-cum_layer_thickness_cm[k-1]);
-  }// would be more efficient to make max_storage a vairable that is not computed every time lgar_insert_water is called
+  double current_mass = lgar_column_mass(cum_layer_thickness_cm, fronts); // fronts are unchanged since the start of the subcycle
 
-  if (f_p > (max_storage - current_mass)/timestep_h){
-    f_p = (max_storage - current_mass)/timestep_h;
+  if (f_p > (max_storage_cm - current_mass)/timestep_h){
+    f_p = (max_storage_cm - current_mass)/timestep_h;
   }
 
   // if ( (current_mass)/max_storage > 0.99 ){
@@ -2068,27 +2720,23 @@ extern double lgar_insert_water(bool use_closed_form_G, int nint, double timeste
 // ######################################################################################
 extern void lgar_create_surficial_front(int num_layers, double *ponded_depth_cm, double *volin, double dry_depth,
 					double theta1, int *soil_type, double *cum_layer_thickness_cm,
-					double *frozen_factor, struct wetting_front** head, struct soil_properties_ *soil_properties)
+					double *frozen_factor, struct wetting_front_list* fronts, struct soil_properties_ *soil_properties)
 {
   // into the soil.  Note ponded_depth_cm is a pointer.   Access its value as (*ponded_depth_cm).
 
   // local vars
-  double theta_e,Se,theta_r;
+  double theta_e,Se;
   double delta_theta;
-  double vg_alpha_per_cm, vg_m, vg_n, Ksat_cm_per_h;
+  double Ksat_cm_per_h;
 
   bool to_bottom = FALSE;
-  struct wetting_front *current;
   int layer_num,soil_num,front_num;
 
-  current = *head;
-
   layer_num = 1;   // we only create new surfacial fronts in the first layer
   soil_num = soil_type[layer_num];
   front_num = 1;   // we are creating a new surfacial front, which by definition must be front #1
 
   theta_e = soil_properties[soil_num].theta_e;  // rhs of the new front, assumes theta_e as per Peter
-  theta_r = soil_properties[soil_num].theta_r;
   delta_theta =  theta_e - theta1;
 
   double theta_new;
@@ -2097,7 +2745,7 @@ extern void lgar_create_surficial_front(int num_layers, double *ponded_depth_cm,
     {
       *volin = *ponded_depth_cm;
       theta_new = fmin(theta1 + (*ponded_depth_cm) /dry_depth, theta_e);
-      listInsertFirst(dry_depth, theta_new, front_num, layer_num, to_bottom, head);
+      listInsertFront(dry_depth, theta_new, front_num, layer_num, to_bottom, fronts);
       *ponded_depth_cm = 0.0;
       //hp_cm =0.0;
     }
@@ -2107,33 +2755,32 @@ extern void lgar_create_surficial_front(int num_layers, double *ponded_depth_cm,
       *ponded_depth_cm -= dry_depth * delta_theta;
       theta_new = theta_e; //fmin(theta1 + (*ponded_depth_cm) /dry_depth, theta_e);
       if (dry_depth < cum_layer_thickness_cm[1])
-	listInsertFirst(dry_depth, theta_e, front_num, layer_num, to_bottom, head);
+	listInsertFront(dry_depth, theta_e, front_num, layer_num, to_bottom, fronts);
       else
-	// listInsertFirst(dry_depth, theta_e, front_num, layer_num, 1, head);
-  listInsertFirst(dry_depth, theta_e, front_num, layer_num, to_bottom, head); //the idea here is that a new WF should never have to_bottom as 1 -- if it needs to merge with the one below it, it will
+	// listInsertFront(dry_depth, theta_e, front_num, layer_num, 1, fronts);
+  listInsertFront(dry_depth, theta_e, front_num, layer_num, to_bottom, fronts); //the idea here is that a new WF should never have to_bottom as 1 -- if it needs to merge with the one below it, it will
       //hp_cm = *ponded_depth_cm;
     }
 
-  current = *head;  // must do this again because listInsertFirst() created a new *head
-  vg_alpha_per_cm    = soil_properties[soil_num].vg_alpha_per_cm;
-  vg_m               = soil_properties[soil_num].vg_m;
-  vg_n               = soil_properties[soil_num].vg_n;
+  // the new front holds the water that entered the soil
+  lgar_update_front_mass(front_num, cum_layer_thickness_cm, fronts);
+
   Ksat_cm_per_h      = soil_properties[soil_num].Ksat_cm_per_h * frozen_factor[layer_num];
 
-  Se = calc_Se_from_theta(theta_new,theta_e,theta_r);
-  current->psi_cm = calc_h_from_Se(Se, vg_alpha_per_cm , vg_m, vg_n);
+  Se = calc_Se_from_theta(theta_new, &soil_properties[soil_num]);
+  fronts->psi_cm[front_num] = calc_h_from_Se(Se, &soil_properties[soil_num]);
 
-  current->K_cm_per_h = calc_K_from_Se(Se, Ksat_cm_per_h, vg_m) * frozen_factor[layer_num]; // AJ - K_temp in python version for 1st layer
+  fronts->K_cm_per_h[front_num] = calc_K_from_Se(Se, Ksat_cm_per_h, &soil_properties[soil_num]) * frozen_factor[layer_num]; // AJ - K_temp in python version for 1st layer
 
-  current->dzdt_cm_per_h = 0.0; //for now assign 0 to dzdt as it will be computed/updated in lgar_dzdt_calc function
+  fronts->dzdt_cm_per_h[front_num] = 0.0; //for now assign 0 to dzdt as it will be computed/updated in lgar_dzdt_calc function
 
-  if (current->next!=NULL){// sometimes a new WF immediately has to merge with another WF or cross a layer bdy
-    if (current->depth_cm>current->next->depth_cm){
+  if (listLength(fronts) > front_num){// sometimes a new WF immediately has to merge with another WF or cross a layer bdy
+    if (fronts->depth_cm[front_num]>fronts->depth_cm[front_num+1]){
       //do a merge cross merge
       // I'm thinking it might not be necessary -- this should happen later. Leaving in for now however,
-      lgar_merge_wetting_fronts(soil_type, frozen_factor, head, soil_properties);
+      lgar_merge_wetting_fronts(soil_type, frozen_factor, cum_layer_thickness_cm, fronts, soil_properties);
       lgar_wetting_fronts_cross_layer_boundary(num_layers, cum_layer_thickness_cm, soil_type, frozen_factor,
-                head, soil_properties);
+                fronts, soil_properties);
     }
   }
 
@@ -2148,46 +2795,37 @@ extern void lgar_create_surficial_front(int num_layers, double *ponded_depth_cm,
    described in the 2015 GARTO paper (Lai et al., An efficient and guaranteed stable numerical method ffor
    continuous modeling of infiltration and redistribution with a shallow dynamic water table). */
 // ############################################################################################
-extern double lgar_calc_dry_depth(bool use_closed_form_G, int nint, double timestep_h, double *delta_theta, int *soil_type,
+extern double lgar_calc_dry_depth(bool use_closed_form_G, double geff_tolerance, double timestep_h, double *delta_theta, int *soil_type,
 				  double *cum_layer_thickness_cm, double *frozen_factor,
-				  struct wetting_front* head, struct soil_properties_ *soil_properties)
+				  struct wetting_front_list* fronts, struct soil_properties_ *soil_properties)
 {
 
   // local variables
-  struct wetting_front *current;
-  double theta1,theta2,theta_e,theta_r;
-  double vg_alpha_per_cm,vg_n,vg_m,Ksat_cm_per_h,h_min_cm;
+  double theta1,theta2,theta_e;
+  double Ksat_cm_per_h;
   double tau;
   double Geff;
   double dry_depth;
   int    soil_num;
   int    layer_num;
 
-  current=head;
-
-  layer_num  = current->layer_num;
+  layer_num  = fronts->layer_num[1];
   soil_num   = soil_type[layer_num];
 
   // copy values of soil properties into shorter variable names to improve readability
-  theta_r         = soil_properties[soil_num].theta_r;
-  vg_alpha_per_cm = soil_properties[soil_num].vg_alpha_per_cm;
-  vg_m            = soil_properties[soil_num].vg_m;
-  vg_n            = soil_properties[soil_num].vg_n;
   Ksat_cm_per_h   = soil_properties[soil_num].Ksat_cm_per_h * frozen_factor[layer_num];
-  h_min_cm        = soil_properties[soil_num].h_min_cm;
-  double lambda = soil_properties[soil_num].bc_lambda;
-  double bc_psib_cm = soil_properties[soil_num].bc_psib_cm;
 
   // these are the limits of integration
-  theta1   = current->theta;                 // water content of the first (most surficial) existing wetting front
+  theta1   = fronts->theta[1];                 // water content of the first (most surficial) existing wetting front
   theta_e  = soil_properties[soil_num].theta_e;
   theta2 = theta_e;
 
-  *delta_theta = theta_e - current->theta;  // return the delta_theta value to the calling function
+  *delta_theta = theta_e - fronts->theta[1];  // return the delta_theta value to the calling function
 
-  tau  = timestep_h * Ksat_cm_per_h/(theta_e-current->theta); //3600
+  tau  = timestep_h * Ksat_cm_per_h/(theta_e-fronts->theta[1]); //3600
 
-  Geff = calc_Geff(use_closed_form_G, theta1, theta2, theta_e, theta_r, vg_alpha_per_cm, vg_n, vg_m, h_min_cm, Ksat_cm_per_h, nint, lambda, bc_psib_cm); 
+  Geff = calc_Geff(use_closed_form_G || soil_properties[soil_num].use_closed_form_G, theta1, theta2, &soil_properties[soil_num], Ksat_cm_per_h,
+		   geff_tolerance);
 
   // note that dry depth originally has a factor of 0.5 in front
   dry_depth = 0.5 * (tau + sqrt( tau*tau + 4.0*tau*Geff) );
@@ -2200,47 +2838,107 @@ extern double lgar_calc_dry_depth(bool use_closed_form_G, int nint, double times
 }
 
 // ###########################################################################
-/* function to calculate the amount of soil moisture (total mass of water)
-   in the profile (cm) */
+/* function to calculate the amount of soil moisture held by wetting front wf,
+   i.e., its contribution to the total mass of water in the profile (cm) */
 // ###########################################################################
-double lgar_calc_mass_bal(double *cum_layer_thickness, struct wetting_front* head)
+static double lgar_front_mass(int wf, double *cum_layer_thickness, struct wetting_front_list* fronts)
 {
+  int layer = fronts->layer_num[wf];
+  double base_depth = cum_layer_thickness[layer-1];   // note cum_layer_thickness[0]=0.0;
+
+  if(wf < fronts->num_fronts) {            // this is not the last entry in the list
+    if(fronts->layer_num[wf+1] == layer)
+      return (fronts->depth_cm[wf] - base_depth) * (fronts->theta[wf] - fronts->theta[wf+1]); // note no need for fabs() here otherwise we get more mass for the case dry-over-wet front within a layer
+    else
+      return (fronts->depth_cm[wf] - base_depth) * fronts->theta[wf];
+  }
+  else { // this is the last entry in the list.  This must be the deepest front in the final layer
+    return fronts->theta[wf] * (fronts->depth_cm[wf] - base_depth);
+  }
+}
 
-  struct wetting_front* current;
-  struct wetting_front* next;     // Beware, might get a little confusing, because there exists a next->next
+#ifdef MASS_LEDGER_CHECK
+// ###########################################################################
+/* debug mode: cross-checks the running total of the column mass against a full
+   recomputation and stops the model if they disagree */
+// ###########################################################################
+static void lgar_check_mass_ledger(double *cum_layer_thickness, struct wetting_front_list* fronts, const char* caller)
+{
+  double sum = 0.0;
+  for (int wf = 1; wf <= listLength(fronts); wf++)
+    sum += lgar_front_mass(wf, cum_layer_thickness, fronts);
 
-  double sum=0.0;
-  double base_depth;
-  int layer;
+  if (fabs(sum - fronts->mass_total_cm) > 1.0E-10) {
+    printf("Mass ledger check failed in %s: running total = %.14e, recomputed = %.14e, difference = %.6e \n",
+	   caller, fronts->mass_total_cm, sum, fronts->mass_total_cm - sum);
+    listPrint(fronts);
+    abort();
+  }
+}
+#endif
 
-  if(head == NULL) return 0.0;
+// ###########################################################################
+/* function to calculate the amount of soil moisture (total mass of water)
+   in the profile (cm); full traversal of the wetting fronts that also refreshes
+   the per-front mass contributions and the running total */
+// ###########################################################################
+double lgar_calc_mass_bal(double *cum_layer_thickness, struct wetting_front_list* fronts)
+{
 
-  current=head;
+  double sum=0.0;
 
-  do
-    {
-      layer=current->layer_num;
-      base_depth=cum_layer_thickness[layer-1];   // note cum_layer_thickness[0]=0.0;
+  if(listIsEmpty(fronts)) return 0.0;
 
-      if(current->next != NULL) {            // this is not the last entry in the list
-	next=current->next;
-	if(next->layer_num == current->layer_num)
-	  sum += (current->depth_cm - base_depth) * (current->theta - next->theta); // note no need for fabs() here otherwise we get more mass for the case dry-over-wet front within a layer
-	else
-	  sum += (current->depth_cm - base_depth) * current->theta;
-      }
-      else { // this is the last entry in the list.  This must be the deepest front in the final layer
-	layer=current->layer_num;
-	sum+=current->theta * (current->depth_cm - base_depth);
-      }
+  int number_of_wetting_fronts = listLength(fronts);
 
-      current=current->next;
+  for (int wf = 1; wf <= number_of_wetting_fronts; wf++) {
+    fronts->mass_cm[wf] = lgar_front_mass(wf, cum_layer_thickness, fronts);
+    sum += fronts->mass_cm[wf];
+  }
 
-    } while(current != NULL );   // putting conditional at end of do looop makes sure it executes once.
+  fronts->mass_total_cm = sum;
 
   return sum;
 }
 
+// ###########################################################################
+/* function to update the column mass after the depth or theta of wetting front wf
+   has changed; only the contributions of fronts wf-1 and wf depend on it, so this
+   is O(1) instead of a full traversal. Requires that the running total was valid
+   before the change (i.e., refreshed by lgar_calc_mass_bal and kept up to date). */
+// ###########################################################################
+extern double lgar_update_front_mass(int wf, double *cum_layer_thickness, struct wetting_front_list* fronts)
+{
+  for (int k = wf-1; k <= wf; k++) {
+    if (k < 1 || k > listLength(fronts))
+      continue;
+
+    double mass_cm = lgar_front_mass(k, cum_layer_thickness, fronts);
+    fronts->mass_total_cm += mass_cm - fronts->mass_cm[k];
+    fronts->mass_cm[k] = mass_cm;
+  }
+
+#ifdef MASS_LEDGER_CHECK
+  lgar_check_mass_ledger(cum_layer_thickness, fronts, "lgar_update_front_mass");
+#endif
+
+  return fronts->mass_total_cm;
+}
+
+// ###########################################################################
+/* function to get the column mass (cm) from the running total */
+// ###########################################################################
+extern double lgar_column_mass(double *cum_layer_thickness, struct wetting_front_list* fronts)
+{
+#ifdef MASS_LEDGER_CHECK
+  lgar_check_mass_ledger(cum_layer_thickness, fronts, "lgar_column_mass");
+#else
+  (void)cum_layer_thickness;
+#endif
+
+  return fronts->mass_total_cm;
+}
+
 // ############################################################################################
 /* The module reads the soil parameters.
    Open file to read in the van Genuchten parameters for standard soil types*/
@@ -2261,8 +2959,7 @@ extern int lgar_read_vG_param_file(char const* vG_param_file_name, int num_soil_
   int length;
   int num_soils_in_file = 0;             // soil counter
   int soil = 1;
-  double theta_e,theta_r,vg_n,vg_m,vg_alpha_per_cm,Ksat_cm_per_h;  // shorthand variable names
-  double m,p,lambda;
+  double theta_e,theta_r,vg_n,vg_alpha_per_cm,Ksat_cm_per_h;  // shorthand variable names
 
   // open the file
   if((in_vG_params_fptr=fopen(vG_param_file_name,"r"))==NULL) {
@@ -2289,30 +2986,10 @@ extern int lgar_read_vG_param_file(char const* vG_param_file_name, int num_soil_
     soil_properties[soil].theta_e         = theta_e;
     soil_properties[soil].vg_alpha_per_cm = vg_alpha_per_cm; // cm^(-1)
     soil_properties[soil].vg_n            = vg_n;
-    soil_properties[soil].vg_m            = 1-1/vg_n;
     soil_properties[soil].Ksat_cm_per_h   = Ksat_cm_per_h;
-    soil_properties[soil].theta_wp = calc_theta_from_h(wilting_point_psi_cm, vg_alpha_per_cm,
-						       vg_m, vg_n, theta_e, theta_r);
-
-    // Given van Genuchten parameters calculate estimates of Brooks & Corey bc_lambda and bc_psib
-    if (1.0 < vg_n) {
-      m = 1.0 - 1.0 / vg_n;
-      p = 1.0 + 2.0 / m;
-      soil_properties[soil].bc_lambda  = 2.0 / (p - 3.0);
-      soil_properties[soil].bc_psib_cm = (p + 3.0) * (147.8 + 8.1 * p + 0.092 * p * p) /
-	(2.0 * vg_alpha_per_cm * p * (p - 1.0) * (55.6 + 7.4 * p + p * p));
-      assert(0.0 < soil_properties[soil].bc_psib_cm);
-    }
-    else {
-      fprintf(stderr, "ERROR: van Genuchten parameter n must be greater than 1\n");
-      //error = TRUE;  // TODO FIXME - what todo in this ccase?
-    }
 
-    /* this is the effective capillary drive after */
-    /* Morel-Seytoux et al. (1996) eqn. 13 or 15 */
-    /* psi should not be less than this value.  */
-    lambda=soil_properties[soil].bc_lambda;
-    soil_properties[soil].h_min_cm = soil_properties[soil].bc_psib_cm*(2.0+3.0/lambda)/(1.0+3.0/lambda);
+    lgar_update_soil_constants(&soil_properties[soil], wilting_point_psi_cm);
+
     num_soils_in_file++;
     soil++;
 
@@ -2326,25 +3003,160 @@ extern int lgar_read_vG_param_file(char const* vG_param_file_name, int num_soil_
   return num_soils_in_file;
 }
 
+// ############################################################################################
+/* derives everything else of a soil record from its van Genuchten parameters (theta_r, theta_e, vg_alpha_per_cm,
+   vg_n): vg_m, the Brooks & Corey estimates bc_lambda and bc_psib_cm, h_min_cm, theta_wp and the constants of the
+   soil kernels. It must be called whenever the parameters change (soil parameters file, calibration), so that none of
+   them is stale; the constants are computed first and stored together. The tables of the soil belong to the old
+   parameters and are detached; lgar_select_geff_method reattaches the Geff table (rebuilt at its next use if the
+   parameters differ) and lgar_build_vg_tables rebuilds the van Genuchten tables. */
+// ############################################################################################
+extern void lgar_update_soil_constants(struct soil_properties_ *soil, double wilting_point_psi_cm)
+{
+  double vg_n  = soil->vg_n;
+  double vg_m  = 1.0 - 1.0/vg_n;
+  double bc_lambda  = soil->bc_lambda;
+  double bc_psib_cm = soil->bc_psib_cm;
+
+  // Given van Genuchten parameters calculate estimates of Brooks & Corey bc_lambda and bc_psib
+  if (1.0 < vg_n) {
+    double p = 1.0 + 2.0 / vg_m;
+    bc_lambda  = 2.0 / (p - 3.0);
+    bc_psib_cm = (p + 3.0) * (147.8 + 8.1 * p + 0.092 * p * p) /
+      (2.0 * soil->vg_alpha_per_cm * p * (p - 1.0) * (55.6 + 7.4 * p + p * p));
+    assert(0.0 < bc_psib_cm);
+  }
+  else {
+    fprintf(stderr, "ERROR: van Genuchten parameter n must be greater than 1\n");
+  }
+
+  struct soil_constants_ constants;
+  constants.theta_range        = soil->theta_e - soil->theta_r;
+  constants.inv_vg_alpha       = 1.0/soil->vg_alpha_per_cm;
+  constants.inv_vg_n           = 1.0/vg_n;
+  constants.inv_vg_m           = 1.0/vg_m;
+  constants.dtheta_dh_scale    = constants.theta_range*vg_m*vg_n;
+  constants.dtheta_dh_exponent = -(vg_m + 1.0);
+  constants.bc_exponent        = 3.0 + 1.0/bc_lambda;
+  constants.bc_Hc_cm           = bc_psib_cm*((2.0 + 3.0*bc_lambda)/(1.0 + 3.0*bc_lambda)); // Green ampt capillary drive parameter, which can be used in the approximation of G with the Brooks-Corey model (See Ogden and Saghafian, 1997)
+
+  soil->vg_m       = vg_m;
+  soil->bc_lambda  = bc_lambda;
+  soil->bc_psib_cm = bc_psib_cm;
+  soil->constants  = constants;
+  soil->geff_table = NULL;
+  soil->vg_table   = NULL;
+
+  /* this is the effective capillary drive after */
+  /* Morel-Seytoux et al. (1996) eqn. 13 or 15 */
+  /* psi should not be less than this value.  */
+  soil->h_min_cm = bc_psib_cm*(2.0+3.0/bc_lambda)/(1.0+3.0/bc_lambda);
+  soil->theta_wp = calc_theta_from_h(wilting_point_psi_cm, soil);
+}
+
+// ############################################################################################
+/* marks the cached Geff, overlying-layer resistance and psi projections of all fronts as stale; must
+   be called whenever something the caches are not keyed on changes, i.e. frozen_factor or soil parameters */
+// ############################################################################################
+extern void lgar_front_cache_invalidate(struct wetting_front_list* fronts)
+{
+  for (int wf = 1; wf <= fronts->num_fronts; wf++) {
+    fronts->Geff_layer_num[wf]       = 0;
+    fronts->resistance_layer_num[wf] = 0;
+    fronts->proj_num_layers[wf]      = 0;
+  }
+}
+
+// ############################################################################################
+/* splits layers *k..last_layer into runs of consecutive layers of the same soil, at most max_runs of them: run r
+   has soil run_soil[r] and spans layers run_first_layer[r]..run_first_layer[r+1]-1. Returns the number of runs and
+   advances *k past the layers covered, so that a loop calls it until *k > last_layer */
+// ############################################################################################
+static int lgar_soil_runs(int *k, int last_layer, int *soil_type, int max_runs, int *run_soil, int *run_first_layer)
+{
+  int runs = 0;
+
+  for (; *k <= last_layer; (*k)++) {
+    if (runs == 0 || soil_type[*k] != run_soil[runs-1]) {
+      if (runs == max_runs)
+	break;
+      run_soil[runs]        = soil_type[*k];
+      run_first_layer[runs] = *k;
+      runs++;
+    }
+  }
+  run_first_layer[runs] = *k;
+
+  return runs;
+}
+
+// ############################################################################################
+/* a wetting front in a deeper layer extends to the surface in terms of psi; this function computes
+   theta and K the front would have in layers 1..num_layers_above (van Genuchten parameters of the
+   respective layers) and caches them per front, so the multi-layer mass balance in lgar_move and the
+   dz/dt denominator evaluate them once per psi value instead of at every use */
+// ############################################################################################
+extern void lgar_front_projection(int wf, int num_layers_above, int *soil_type, double *frozen_factor,
+				  struct wetting_front_list* fronts, struct soil_properties_ *soil_properties)
+{
+  int first_layer = 1;
+
+  if (fronts->proj_num_layers[wf] > 0 && fronts->proj_psi_cm[wf] == fronts->psi_cm[wf]) {
+    if (fronts->proj_num_layers[wf] >= num_layers_above)
+      return;                                        // everything needed is cached
+    first_layer = fronts->proj_num_layers[wf] + 1;   // only the deeper layers are missing
+  }
+
+  double psi_cm       = fronts->psi_cm[wf];
+  double *theta_proj  = &fronts->proj_theta[wf*fronts->proj_stride];
+  double *K_proj      = &fronts->proj_K_cm_per_h[wf*fronts->proj_stride];
+
+  // finely layered profiles repeat the same soil over consecutive layers (a run), which then share theta and K (up
+  // to the frozen factor); the runs are evaluated together with the batch functions, up to max_runs at a time
+  const int max_runs = 16;
+  int    run_soil[max_runs];
+  int    run_first_layer[max_runs+1];  // run r spans layers run_first_layer[r]..run_first_layer[r+1]-1
+  double run_theta[max_runs], run_K[max_runs];
+
+  int k = first_layer;
+  while (k <= num_layers_above) {
+    int runs = lgar_soil_runs(&k, num_layers_above, soil_type, max_runs, run_soil, run_first_layer);
+
+    for (int r = 0; r < runs; r++)
+      run_theta[r] = psi_cm;
+    calc_theta_from_h_batch(runs, run_theta, run_soil, soil_properties, run_theta);
+
+    for (int r = 0; r < runs; r++)
+      run_K[r] = calc_Se_from_theta(run_theta[r], &soil_properties[run_soil[r]]);
+    calc_K_from_Se_batch(runs, run_K, run_soil, soil_properties, run_K);
+
+    for (int r = 0; r < runs; r++) {
+      for (int j = run_first_layer[r]; j < run_first_layer[r+1]; j++) {
+	theta_proj[j] = run_theta[r];
+	K_proj[j]     = run_K[r] * frozen_factor[j];
+      }
+    }
+  }
+
+  fronts->proj_psi_cm[wf]     = psi_cm;
+  fronts->proj_num_layers[wf] = num_layers_above;
+}
+
 // ############################################################################################
 /* code to calculate velocity of fronts
    equations with full description are provided in the lgar paper (currently under review) */
 // ############################################################################################
-extern void lgar_dzdt_calc(bool use_closed_form_G, int nint, double h_p, int *soil_type, double *cum_layer_thickness_cm,
-			   double *frozen_factor, struct wetting_front* head, struct soil_properties_ *soil_properties)
+extern void lgar_dzdt_calc(bool use_closed_form_G, double geff_tolerance, double h_p, int *soil_type, double *cum_layer_thickness_cm,
+			   double *frozen_factor, struct wetting_front_list* fronts, struct soil_properties_ *soil_properties)
 {
   if (verbosity.compare("high") == 0) {
     std::cerr<<"Calculating dz/dt .... \n";
   }
 
-  struct wetting_front* current;
-  struct wetting_front* next;
-
-  double vg_alpha_per_cm,vg_n,vg_m,Ksat_cm_per_h,theta_e,theta_r;  // local variables to make things clearer
+  double Ksat_cm_per_h;  // local variables to make things clearer
   double delta_theta;
   double Geff;
   double depth_cm;    // the absolute depth down to a wetting front from the surface
-  double h_min_cm;
   double K_cm_per_h;  // unsaturated hydraulic conductivity K(theta) at the RHS of the current wetting front (cm/h)
   double theta1, theta2;  // limits of integration on Geff from theta1 to theta2
   double bottom_sum;  // store a running sum of L_n/K(theta_n) n increasing from 1 to N-1, as we go down in layers N
@@ -2352,7 +3164,7 @@ extern void lgar_dzdt_calc(bool use_closed_form_G, int nint, double h_p, int *so
   int    soil_num, layer_num;
 
 
-  if(head == NULL) {
+  if(listIsEmpty(fronts)) {
     stringstream errMsg;
     errMsg << "lgar derivative function called for empty list (no wetting front exists) \n";
     throw runtime_error(errMsg.str());
@@ -2360,59 +3172,49 @@ extern void lgar_dzdt_calc(bool use_closed_form_G, int nint, double h_p, int *so
 
   // make sure to use previous state values as current state is updated during the timestep (that's how it is done is Peter's python version)
 
-  current = head;
+  int number_of_wetting_fronts = listLength(fronts);
 
-  do {  // loop through the wetting fronts
+  for (int wf = 1; wf <= number_of_wetting_fronts; wf++) {  // loop through the wetting fronts
     dzdt = 0.0;
 
     // copy structure elements into shorter variables names to increase readability
     // WETTING FRONT PROPERTIES
-    layer_num    = current->layer_num;    // what layer the front is in
-    K_cm_per_h   = current->K_cm_per_h;   // K(theta)
+    layer_num    = fronts->layer_num[wf];    // what layer the front is in
+    K_cm_per_h   = fronts->K_cm_per_h[wf];   // K(theta)
 
     if (K_cm_per_h < 0) {
-      printf("K is negative (layer_num, wf_num, K): %d %d %lf \n", layer_num, current->front_num, K_cm_per_h);
-      listPrint(head);
+      printf("K is negative (layer_num, wf_num, K): %d %d %lf \n", layer_num, wf, K_cm_per_h);
+      listPrint(fronts);
       printf("Is your n value very close to 1? Very small n values can cause K to become 0. \n");
       //The parameter n must physically attain a value greater than 1. However, when n is small, and apparently less than 1.02, sometimes n can make K evaluate to 0, for larger values of psi.
       //So, checking for K_cm_per_h <= 0 has been replaced by checking if K_cm_per_h is negative. K_cm_per_h should never be negative (although perhaps machine precision could make this occur, although we haven't seen it yet), but mathematically can be 0 in some rare cases. 
       abort();
     }
 
-    depth_cm = current->depth_cm;     // absolute Z to this wetting front measured down from land surface
+    depth_cm = fronts->depth_cm[wf];     // absolute Z to this wetting front measured down from land surface
 
     // SOIL PROPERTIES
     soil_num        = soil_type[layer_num];
-    vg_alpha_per_cm = soil_properties[soil_num].vg_alpha_per_cm;
-    vg_n            = soil_properties[soil_num].vg_n;
-    vg_m            = soil_properties[soil_num].vg_m;
-    theta_e         = soil_properties[soil_num].theta_e;
-    theta_r         = soil_properties[soil_num].theta_r;
-    h_min_cm        = soil_properties[soil_num].h_min_cm;
-    Ksat_cm_per_h   = soil_properties[soil_num].Ksat_cm_per_h * frozen_factor[current->layer_num];
-    double lambda = soil_properties[soil_num].bc_lambda;
-    double bc_psib_cm = soil_properties[soil_num].bc_psib_cm;
+    Ksat_cm_per_h   = soil_properties[soil_num].Ksat_cm_per_h * frozen_factor[fronts->layer_num[wf]];
 
-    next = current->next;    // the next element in the linked list
-    if (next == NULL) break; // we're done calculating dZ/dt's because we're at the end of the list
+    if (wf == number_of_wetting_fronts) break; // we're done calculating dZ/dt's because we're at the end of the list
 
-    theta1 = next->theta;
-    theta2 = current->theta;
+    theta1 = fronts->theta[wf+1];
+    theta2 = fronts->theta[wf];
 
 
     bottom_sum = 0.0;  // needed ffor multi-layered dz/dt equation.  Equal to sum from n=1 to N-1 of (L_n/K_n(theta_n))
 
-    if(current->to_bottom == TRUE) {
+    if(fronts->to_bottom[wf] == TRUE) {
       if(layer_num > 1)
-	current->dzdt_cm_per_h = 0.0;
+	fronts->dzdt_cm_per_h[wf] = 0.0;
       else
-	current->dzdt_cm_per_h = 0.0;
+	fronts->dzdt_cm_per_h[wf] = 0.0;
 
-      current = current->next;  // point to the next link
       continue;                 // go to next front, this one fully penetrates the layer
     }
     else if(layer_num > 1) {
-      bottom_sum += (current->depth_cm-cum_layer_thickness_cm[layer_num-1])/K_cm_per_h;
+      bottom_sum += (fronts->depth_cm[wf]-cum_layer_thickness_cm[layer_num-1])/K_cm_per_h;
     }
 
     if(theta1 > theta2) {
@@ -2420,35 +3222,45 @@ extern void lgar_dzdt_calc(bool use_closed_form_G, int nint, double h_p, int *so
       exit(0);
     }
 
-    Geff = calc_Geff(use_closed_form_G, theta1, theta2, theta_e, theta_r, vg_alpha_per_cm, vg_n, vg_m, h_min_cm, Ksat_cm_per_h, nint, lambda, bc_psib_cm); 
-    delta_theta = current->theta - next->theta;
+    // Geff only depends on the layer and the thetas bounding the front; reuse it when none of them moved
+    if (fronts->Geff_layer_num[wf] == layer_num && fronts->Geff_theta1[wf] == theta1 && fronts->Geff_theta2[wf] == theta2) {
+      Geff = fronts->Geff_cm[wf];
+    }
+    else {
+      Geff = calc_Geff(use_closed_form_G || soil_properties[soil_num].use_closed_form_G, theta1, theta2, &soil_properties[soil_num], Ksat_cm_per_h,
+		   geff_tolerance);
+      fronts->Geff_cm[wf]        = Geff;
+      fronts->Geff_theta1[wf]    = theta1;
+      fronts->Geff_theta2[wf]    = theta2;
+      fronts->Geff_layer_num[wf] = layer_num;
+    }
+
+    delta_theta = fronts->theta[wf] - fronts->theta[wf+1];
 
-    if(current->layer_num == 1) { // this front is in the upper layer
+    if(fronts->layer_num[wf] == 1) { // this front is in the upper layer
       if (delta_theta > 0){
-	dzdt = 1.0/delta_theta*(Ksat_cm_per_h*(Geff+h_p)/current->depth_cm+current->K_cm_per_h);}
+	dzdt = 1.0/delta_theta*(Ksat_cm_per_h*(Geff+h_p)/fronts->depth_cm[wf]+fronts->K_cm_per_h[wf]);}
       else{
 	dzdt = 0.0;}
     }
     else {  // we are in the second or greater layer
-      double denominator = bottom_sum;
+      // resistance of the overlying layers, sum of L_k/K_k(psi), only depends on psi of this front
+      if (fronts->resistance_layer_num[wf] != layer_num || fronts->resistance_psi_cm[wf] != fronts->psi_cm[wf]) {
+	double resistance = 0.0;
 
-      for (int k = 1; k < layer_num; k++) {
-	int soil_num_loc = soil_type[layer_num-k]; // _loc denotes the soil_num is local to this loop
-	double theta_prev_loc = calc_theta_from_h(current->psi_cm, soil_properties[soil_num_loc].vg_alpha_per_cm,
-						  soil_properties[soil_num_loc].vg_m,
-						  soil_properties[soil_num_loc].vg_n,soil_properties[soil_num_loc].theta_e,
-						  soil_properties[soil_num_loc].theta_r);
+	lgar_front_projection(wf, layer_num-1, soil_type, frozen_factor, fronts, soil_properties);
+	double *K_proj = &fronts->proj_K_cm_per_h[wf*fronts->proj_stride]; // K(psi) of this front in layers above
 
+	for (int k = 1; k < layer_num; k++)
+	  resistance += (cum_layer_thickness_cm[k] - cum_layer_thickness_cm[k-1])/ K_proj[layer_num-k];
 
-	double Se_prev_loc = calc_Se_from_theta(theta_prev_loc,soil_properties[soil_num_loc].theta_e,soil_properties[soil_num_loc].theta_r);
-
-	double K_cm_per_h_prev_loc = calc_K_from_Se(Se_prev_loc,soil_properties[soil_num_loc].Ksat_cm_per_h * frozen_factor[layer_num-k],
-						    soil_properties[soil_num_loc].vg_m);
-
-	denominator += (cum_layer_thickness_cm[k] - cum_layer_thickness_cm[k-1])/ K_cm_per_h_prev_loc;
-
+	fronts->resistance_h[wf]         = resistance;
+	fronts->resistance_psi_cm[wf]    = fronts->psi_cm[wf];
+	fronts->resistance_layer_num[wf] = layer_num;
       }
 
+      double denominator = bottom_sum + fronts->resistance_h[wf];
+
       double numerator = depth_cm;// + (Geff +h_p)* Ksat_cm_per_h / K_cm_per_h;
 
       if (delta_theta > 0)
@@ -2457,8 +3269,8 @@ extern void lgar_dzdt_calc(bool use_closed_form_G, int nint, double h_p, int *so
 	dzdt = 0.0;
     }
 
-    if ((dzdt == 0.0) && (current->to_bottom==FALSE)){
-      //in lgar_move, we have: "if (current->dzdt_cm_per_h == 0.0 && current->to_bottom == FALSE) { // a new front was just created, so don't update it."
+    if ((dzdt == 0.0) && (fronts->to_bottom[wf]==FALSE)){
+      //in lgar_move, we have: "if (fronts->dzdt_cm_per_h[wf] == 0.0 && fronts->to_bottom[wf] == FALSE) { // a new front was just created, so don't update it."
       //the issue here is that when theta approaches theta_r, then dzdt can in some cases numerically evaluate to 0, even if the wetting front has to_bottom==FALSE.
       //so, there are cases where a WF should be moving very slowly, but not being completely still. 
       dzdt = 1e-9;
@@ -2468,143 +3280,302 @@ extern void lgar_dzdt_calc(bool use_closed_form_G, int nint, double h_p, int *so
       dzdt = 1e4;
     }
 
-    current->dzdt_cm_per_h = dzdt;
+    fronts->dzdt_cm_per_h[wf] = dzdt;
 
-    current = current->next;  // point to the next link
+  }
+
+}
+
+// ############################################################################################
+/* mass of a wetting front spanning layers 1..layer_num for num_psi trial heads psi_cm[c] (the same head in all
+   layers), and its derivative with respect to psi; used by lgar_theta_mass_balance. The heads (at most
+   LGAR_MAX_PSI_CANDIDATES) and the layers of each are evaluated together with the batch functions */
+// ############################################################################################
+static void lgar_front_mass_at_psi(int num_psi, const double *psi_cm, int layer_num, double *delta_theta,
+				   double *delta_thickness, int *soil_type, struct soil_properties_ *soil_properties,
+				   double *mass, double *dmass_dpsi)
+{
+  // theta only depends on the soil, so consecutive layers of the same soil (a run) share it; the runs of all the
+  // heads are evaluated in one batch, up to max_runs runs at a time
+  const int max_runs  = 16;
+  const int max_batch = max_runs * LGAR_MAX_PSI_CANDIDATES;
+  int    run_soil[max_runs];
+  int    run_first_layer[max_runs+1];  // run r spans layers run_first_layer[r]..run_first_layer[r+1]-1
+  int    batch_soil[max_batch];
+  double batch_psi[max_batch], batch_theta[max_batch], batch_dtheta_dh[max_batch];
+
+  for (int c = 0; c < num_psi; c++) {
+    mass[c]       = 0.0;
+    dmass_dpsi[c] = 0.0;
+  }
+
+  int k = 1;
+  while (k <= layer_num) {
+    int runs = lgar_soil_runs(&k, layer_num, soil_type, max_runs, run_soil, run_first_layer);
+    int n = num_psi * runs;  // element c*runs + r: head c, run r
+
+    for (int c = 0; c < num_psi; c++) {
+      for (int r = 0; r < runs; r++) {
+	batch_psi[c*runs + r]  = psi_cm[c];
+	batch_soil[c*runs + r] = run_soil[r];
+      }
+    }
+
+    calc_theta_dtheta_dh_batch(n, batch_psi, batch_soil, soil_properties, batch_theta, batch_dtheta_dh);
+
+    for (int c = 0; c < num_psi; c++) {
+      for (int r = 0; r < runs; r++) {
+	for (int j = run_first_layer[r]; j < run_first_layer[r+1]; j++) {
+	  mass[c]       += delta_thickness[j] * (batch_theta[c*runs + r] - delta_theta[j]);
+	  dmass_dpsi[c] += delta_thickness[j] * batch_dtheta_dh[c*runs + r];
+	}
+      }
+    }
+  }
+}
 
-  } while(current != NULL );   // putting conditional at end of do looop makes sure it executes at least once
+// ############################################################################################
+/* narrows the bracket [*psi_lo, *psi_hi] of the root of f(psi) = mass(psi) - prior_mass (f decreasing, f(psi_lo) >= 0
+   >= f(psi_hi)) with num_candidates heads evaluated at once: spaced geometrically when the bracket spans orders of
+   magnitude (from psi_hi*1e-6 if psi_lo is zero), evenly otherwise, the bracket shrinks num_candidates+1 fold.
+   Returns the candidate closest to the root in *psi_cm, with f and df/dpsi */
+// ############################################################################################
+static void lgar_psi_candidate_sweep(int num_candidates, double *psi_lo, double *psi_hi, double prior_mass,
+				     int layer_num, double *delta_theta, double *delta_thickness, int *soil_type,
+				     struct soil_properties_ *soil_properties, double *psi_cm, double *f,
+				     double *dmass_dpsi)
+{
+  double psi[LGAR_MAX_PSI_CANDIDATES], f_c[LGAR_MAX_PSI_CANDIDATES], dmass_c[LGAR_MAX_PSI_CANDIDATES];
+
+  double lo = *psi_lo > 0.0 ? *psi_lo : 1.0e-6 * (*psi_hi);
+  bool geometric = *psi_hi > 4.0 * lo;
+
+  for (int c = 0; c < num_candidates; c++) {
+    double t = (c + 1.0) / (num_candidates + 1.0);
+    psi[c] = geometric ? lo * pow(*psi_hi / lo, t) : *psi_lo + t * (*psi_hi - *psi_lo);
+  }
+
+  lgar_front_mass_at_psi(num_candidates, psi, layer_num, delta_theta, delta_thickness, soil_type, soil_properties,
+			 f_c, dmass_c);
+
+  // f decreases with psi: the root lies between the last candidate with f > 0 and the next one
+  int c_hi = 0;
+  while (c_hi < num_candidates && (f_c[c_hi] -= prior_mass) > 0.0)
+    c_hi++;
+  for (int c = c_hi + 1; c < num_candidates; c++)
+    f_c[c] -= prior_mass;
 
+  if (c_hi > 0)
+    *psi_lo = psi[c_hi-1];
+  if (c_hi < num_candidates)
+    *psi_hi = psi[c_hi];
+
+  int best = c_hi == 0 ? 0 : c_hi == num_candidates ? c_hi - 1 : (f_c[c_hi-1] < -f_c[c_hi] ? c_hi - 1 : c_hi);
+  *psi_cm     = psi[best];
+  *f          = f_c[best];
+  *dmass_dpsi = dmass_c[best];
 }
 
 // ############################################################################################
 /* The function does mass balance for a wetting front to get an updated theta.
-   The head (psi) value is iteratively altered until the error between prior mass and new mass
-   is within a tolerance. */
+   The head (psi) value is found such that the mass of the wetting front (in all the layers it spans) equals
+   the prior mass; the mass decreases monotonically with psi, so the root is bracketed first and then found
+   with Newton's method (analytic d(theta)/d(psi) of the van Genuchten curve), falling back to bisection
+   whenever a Newton step leaves the bracket or does not halve the step. The search is warm started from the
+   current psi of the wetting front (i.e., the previous timestep's solution).
+   With num_candidates > 1 (psi_search_candidates in the config file), the bracket is expanded and, where Newton's
+   method fails, narrowed with num_candidates heads evaluated at once with the batch functions: each evaluation
+   shrinks the bracket num_candidates+1 fold instead of two, which saves dependent evaluations in dry soils whose
+   mass varies over many orders of magnitude of psi; Newton's method still polishes the root.
+   The search stops once the mass error is within tolerance [cm] or after max_iter iterations (both set by the
+   precision profile, see lgar_set_precision_profile).
+   Corner cases (same as the earlier step search):
+   - the prior mass is below what the wetting front holds at theta_r (theta < theta_r would be needed): the
+     head stops at psi_max_cm and the remaining mass error is taken out of AET
+   - the prior mass is above what the wetting front holds at saturation: theta = theta_e and the extra water
+     goes to runoff elsewhere (no AET adjustment)
+   - theta reaches theta_e at a nonzero head: AET is set to zero (see below) */
 // ############################################################################################
 extern double lgar_theta_mass_balance(int layer_num, int soil_num, double psi_cm, double new_mass,
 				      double prior_mass, double *AET_demand_cm, double *delta_theta, double *delta_thickness,
-				      int *soil_type, struct soil_properties_ *soil_properties)
+				      int *soil_type, struct soil_properties_ *soil_properties, int num_candidates,
+				      double tolerance, int max_iter)
 {
 
-  double psi_cm_loc = psi_cm; // location psi
   double delta_mass = fabs(new_mass - prior_mass); // mass different between the new and prior
-  // double original_delta_mass = delta_mass; 
-  double tolerance = 1e-12;
-
-  double factor = fmax(1,psi_cm/100);//was 1.0 previously. This code is far faster and seems to avoid loops with >10000 iterations. Low n values can cause this
-  bool switched = false; // flag that determines capillary head to be incremented or decremented
+  double psi_max_cm = 1.0e15;                      // upper limit of the head search
 
   double theta             = 0; // this will be updated and returned
-  double psi_cm_loc_prev   = psi_cm_loc;
-  double delta_mass_prev   = delta_mass;
-  int count_no_mass_change = 0;
-  int break_no_mass_change = 5;
   bool wanted_to_saturate_flag = FALSE;
-  
+  double psi_cm_loc = fmax(psi_cm, 0.0);           // location psi; warm start from the current head
+
   // check if the difference is less than the tolerance
   if (delta_mass <= tolerance) {
-    theta = calc_theta_from_h(psi_cm_loc, soil_properties[soil_num].vg_alpha_per_cm,
-			      soil_properties[soil_num].vg_m, soil_properties[soil_num].vg_n,
-			      soil_properties[soil_num].theta_e,soil_properties[soil_num].theta_r);
+    theta = calc_theta_from_h(psi_cm, &soil_properties[soil_num]);
     return theta;
   }
 
-  // the loop increments/decrements the capillary head until mass difference between
-  // the new and prior is within the tolerance
+  // f(psi) = mass(psi) - prior_mass decreases with psi; psi_lo has f >= 0 and psi_hi has f <= 0
+  double f, dmass_dpsi;
+  lgar_front_mass_at_psi(1, &psi_cm_loc, layer_num, delta_theta, delta_thickness, soil_type, soil_properties,
+			 &f, &dmass_dpsi);
+  f -= prior_mass;
+  double psi_lo = 0.0, psi_hi = psi_max_cm;
   int iter = 0;
-  bool iter_aug_flag = FALSE;
 
-  while (delta_mass > tolerance) {
-    iter++;
+  if (f > 0.0) {
+    // too much water; the root is at a larger head, expand the bracket upwards
+    psi_lo = psi_cm_loc;
+    psi_hi = fmax(10.0 * psi_cm_loc, 1.0);
 
-    if (iter>1000 && iter_aug_flag==FALSE){
-      factor = factor*100;
-      iter_aug_flag = TRUE;
-    }
+    double f_hi, dmass_dpsi_hi;
 
-    if (new_mass > prior_mass) {
-      psi_cm_loc += 0.1 * factor;
-      switched = false;
-    }
-    else {
-      if (!switched) {
-	switched = true;
-	factor = factor * 0.1;
-      }
-      
-      psi_cm_loc_prev = psi_cm_loc;
-      psi_cm_loc -= 0.1 * factor;
+    if (num_candidates > 1) {
+      // the heads of the expansion, 100 fold apart, are evaluated num_candidates at a time
+      double psi[LGAR_MAX_PSI_CANDIDATES], f_c[LGAR_MAX_PSI_CANDIDATES], dmass_c[LGAR_MAX_PSI_CANDIDATES];
+      double f_lo = f, dmass_dpsi_lo = dmass_dpsi;
+      int c = 0, n = 0;
+
+      do {
+	for (n = 0; n < num_candidates && (n == 0 || psi[n-1] < psi_max_cm); n++)
+	  psi[n] = n == 0 ? psi_hi : fmin(100.0 * psi[n-1], psi_max_cm);
+
+	lgar_front_mass_at_psi(n, psi, layer_num, delta_theta, delta_thickness, soil_type, soil_properties,
+			       f_c, dmass_c);
+	iter++;
+
+	for (c = 0; c < n && (f_c[c] -= prior_mass) > 0.0; c++) {
+	  psi_lo        = psi[c];
+	  f_lo          = f_c[c];
+	  dmass_dpsi_lo = dmass_c[c];
+	}
+
+	psi_hi = c < n ? psi[c] : fmin(100.0 * psi[n-1], psi_max_cm);
+      } while (c == n && psi[n-1] < psi_max_cm);
+
+      c = c < n ? c : n - 1;
+      psi_hi        = psi[c];
+      f_hi          = f_c[c];
+      dmass_dpsi_hi = dmass_c[c];
 
-      if (psi_cm_loc<0.0){
-        wanted_to_saturate_flag = TRUE;
+      // Newton's method starts from the end of the bracket closer to the root
+      if (f_hi <= 0.0 && f_lo < -f_hi) {
+	psi_cm_loc = psi_lo;
+	f          = f_lo;
+	dmass_dpsi = dmass_dpsi_lo;
       }
-      
-      if (psi_cm_loc < 0 && psi_cm_loc_prev != 0) {
-	/* this is for the extremely rare case when iterative psi_cm_loc calculation temporarily
-	   yields a negative value and the actual answer for psi_cm_loc is nonzero. For example
-	   when a completely saturated wetting front with a tiny amount of ET should yield a resulting
-	   theta that is slightly below saturation. */
-        psi_cm_loc = psi_cm_loc_prev * 0.1;
+      else if (f_hi <= 0.0) {
+	psi_cm_loc = psi_hi;
+	f          = f_hi;
+	dmass_dpsi = dmass_dpsi_hi;
+      }
+    }
+    else {
+      lgar_front_mass_at_psi(1, &psi_hi, layer_num, delta_theta, delta_thickness, soil_type, soil_properties,
+			     &f_hi, &dmass_dpsi_hi);
+      f_hi -= prior_mass;
+      iter++;
+
+      while (f_hi > 0.0 && psi_hi < psi_max_cm) {
+	psi_lo = psi_hi;
+	psi_hi = fmin(100.0 * psi_hi, psi_max_cm);
+	lgar_front_mass_at_psi(1, &psi_hi, layer_num, delta_theta, delta_thickness, soil_type, soil_properties,
+			       &f_hi, &dmass_dpsi_hi);
+	f_hi -= prior_mass;
+	iter++;
       }
-      
     }
 
-    double theta_layer;
-    double mass_layers= 0.0;
+    if (f_hi > 0.0) {
+      // theta < theta_r would be needed to close the mass balance, the head can't get there
+      psi_cm_loc = psi_hi;
+      f          = f_hi;
+      iter       = max_iter;
+    }
+  }
+  else if (f < 0.0) {
+    // too little water; the root is at a smaller head, down to saturation
+    psi_hi = psi_cm_loc;
 
-    theta = calc_theta_from_h(psi_cm_loc, soil_properties[soil_num].vg_alpha_per_cm, soil_properties[soil_num].vg_m,
-			      soil_properties[soil_num].vg_n,soil_properties[soil_num].theta_e,
-			      soil_properties[soil_num].theta_r);
+    double psi_sat = 0.0, f_lo, dmass_dpsi_lo;
+    lgar_front_mass_at_psi(1, &psi_sat, layer_num, delta_theta, delta_thickness, soil_type, soil_properties,
+			   &f_lo, &dmass_dpsi_lo);
+    f_lo -= prior_mass;
+    iter++;
 
-    mass_layers += delta_thickness[layer_num] * (theta - delta_theta[layer_num]);
+    if (f_lo < 0.0) {
+      // even a saturated wetting front can't hold the prior mass
+      wanted_to_saturate_flag = TRUE;
+      psi_cm_loc = 0.0;
+      f          = f_lo;
+      iter       = max_iter;
+    }
+  }
 
-    for (int k=1; k<layer_num; k++) {
-      int soil_num_loc =  soil_type[k]; // _loc denotes the variable is local to the loop
+  // safeguarded Newton iterations within the bracket [psi_lo, psi_hi]
+  double step_prev = psi_hi - psi_lo;
 
-      theta_layer = calc_theta_from_h(psi_cm_loc, soil_properties[soil_num_loc].vg_alpha_per_cm,
-				      soil_properties[soil_num_loc].vg_m, soil_properties[soil_num_loc].vg_n,
-				      soil_properties[soil_num_loc].theta_e, soil_properties[soil_num_loc].theta_r);
+  while (fabs(f) > tolerance && iter < max_iter) {
+    iter++;
 
-      mass_layers += delta_thickness[k] * (theta_layer - delta_theta[k]);
+    if (f > 0.0)
+      psi_lo = psi_cm_loc;
+    else
+      psi_hi = psi_cm_loc;
+
+    double psi_new = psi_cm_loc - f / dmass_dpsi; // dmass_dpsi < 0, so f > 0 moves psi up
+    bool newton_fails = !(dmass_dpsi < 0.0) || !(psi_new > psi_lo && psi_new < psi_hi)
+                        || fabs(psi_new - psi_cm_loc) > 0.5 * step_prev;
+
+    if (newton_fails && num_candidates > 1 && psi_hi - psi_lo > 1.0e-15 * psi_hi) {
+      // narrow the bracket num_candidates+1 fold and continue from the candidate closest to the root
+      double psi_prev = psi_cm_loc;
+      lgar_psi_candidate_sweep(num_candidates, &psi_lo, &psi_hi, prior_mass, layer_num, delta_theta, delta_thickness,
+			       soil_type, soil_properties, &psi_cm_loc, &f, &dmass_dpsi);
+      step_prev = fabs(psi_cm_loc - psi_prev);
+      continue;
     }
 
-    new_mass = mass_layers;
-    delta_mass = fabs(new_mass - prior_mass);
-
-    // stop the loop if the error between the current and previous psi is less than 10^-15
-    // 1. enough accuracy, 2. the algorithm can't improve the error further,
-    // 3. avoid infinite loop, 4. handles a corner case when prior mass is tiny (e.g., <1.E-5)
-    // printf("A1 = %.20f, %.18f %.18f %.18f %.18f \n ",fabs(psi_cm_loc - psi_cm_loc_prev) , psi_cm_loc, psi_cm_loc_prev, factor, delta_mass);
-    
-    if (fabs(psi_cm_loc - psi_cm_loc_prev) < 1E-15 && factor < 1E-13) break;
+    if (newton_fails) {
+      // bisection; geometric mean when the bracket spans orders of magnitude
+      if (psi_lo > 0.0 && psi_hi > 4.0 * psi_lo)
+	psi_new = sqrt(psi_lo * psi_hi);
+      else
+	psi_new = 0.5 * (psi_lo + psi_hi);
+    }
 
-    // another condition to avoid infinite loop when the error does not improve
-    if (fabs(delta_mass - delta_mass_prev) < 1E-15)
-      count_no_mass_change++;
-    else
-      count_no_mass_change = 0;
+    step_prev = fabs(psi_new - psi_cm_loc);
 
-    // break the loop if the mass does not change in the five consecutive iterations.
-    if (count_no_mass_change == break_no_mass_change)
+    // the bracket can't be narrowed further at machine precision
+    if (psi_new == psi_cm_loc || psi_hi - psi_lo <= 1.0e-15 * psi_hi)
       break;
-    
-    // -ve pressure will return NAN, so terminate the loop if previous psi is way small and current psi is zero
-    // the wetting front is almost saturated
-    if (psi_cm_loc <= 0 && psi_cm_loc_prev < 0) break;
-
-    delta_mass_prev = delta_mass;
 
+    psi_cm_loc = psi_new;
+    lgar_front_mass_at_psi(1, &psi_cm_loc, layer_num, delta_theta, delta_thickness, soil_type, soil_properties,
+			   &f, &dmass_dpsi);
+    f -= prior_mass;
   }
 
+  delta_mass = fabs(f);
+
+  if (wanted_to_saturate_flag)
+    theta = soil_properties[soil_num].theta_e;
+  else
+    theta = calc_theta_from_h(psi_cm_loc, &soil_properties[soil_num]);
+
   //There is a rare case where mass balance closure would require that theta<theta_r. 
-  //However, the above loop can never increase psi to the point where theta<theta_r, because theta must always be between theta_r and theta_r, because of the van Genuchten model (calc_theta_from_h).
-  //If we get to the case where theta<theta_r would be necessary for mass balance closure, then the above loop will break before delta_mass <= tolerance.
+  //However, the search can never increase psi to the point where theta<theta_r, because theta must always be between theta_r and theta_e, because of the van Genuchten model (calc_theta_from_h).
+  //If we get to the case where theta<theta_r would be necessary for mass balance closure, then the search stops at psi_max_cm before delta_mass <= tolerance.
   //In this rare case, the remaining mass balance error is put into AET. 
-  if ((delta_mass > tolerance) && (!wanted_to_saturate_flag)){//the second condition is necessary because count_no_mass_change == break_no_mass_change in the loop above will trigger when the model approaches saturation; in this event the extra water should go into runoff (handled eslewhere), because the soil saturates, rather than AET
+  if ((delta_mass > tolerance) && (!wanted_to_saturate_flag)){//the second condition is necessary because the search also stops when the model approaches saturation; in this event the extra water should go into runoff (handled eslewhere), because the soil saturates, rather than AET
     *AET_demand_cm = *AET_demand_cm - fabs(delta_mass - tolerance);
   }
 
-  if ( (theta>=soil_properties[soil_num].theta_e) && (psi_cm_loc!=0.0) ){
+  // a wetting front driven to saturation from a nonzero head approaches it through ever smaller nonzero heads,
+  // so it also falls under the rare case below
+  bool saturated_from_nonzero_head = wanted_to_saturate_flag && psi_cm > 0.0;
+
+  if ( (theta>=soil_properties[soil_num].theta_e) && (psi_cm_loc!=0.0 || saturated_from_nonzero_head) ){
     //addresses a very rare case. Sometimes when psi gets very close to 0 but is not 0, calc_theta_from_h will actually yield theta_e for a very small nonzero psi value (for example psi=1e-3 or something like that).
     //This can happen for example when the model domain is very close to saturation, and the number of WFs == the number of layers, but there is a little bit of AET so the resulting model state should have just slightly less water than complete saturation.
     //However, layers above the current one might not have the property that this small zonzero psi value yields theta = theta_e.
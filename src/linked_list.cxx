@@ -1,10 +1,14 @@
 #include "../include/all.hxx"
+#include <string.h>
+#include <stdexcept>
 
 //#####################################################################################
 /* authors : Fred Ogden and Ahmad Jan
    year    : 2022
    email   : ahmad.jan@noaa.gov
-   - The file constains linked list functionality for the wetting front
+   - The file constains list functionality for the wetting fronts
+   - The wetting fronts are stored as a structure of arrays (struct wetting_front_list), 1-indexed by front number
+   - The storage of all lists of a model instance comes from one pool (struct wetting_front_pool)
    - Originally written by Fred Ogden (most of it), and modified/extended by Ahmad Jan */
 //#####################################################################################
 
@@ -13,7 +17,7 @@
 /*#########################################################*/
 //---------------------------------------------------------
 //
-// linked   LL           II     SSS      TTTTTTTTTTT
+// front    LL           II     SSS      TTTTTTTTTTT
 //          LL           II   SSS  SSS        TT
 //          LL           II  SS      SS       TT
 //          LL           II  SS               TT
@@ -27,102 +31,236 @@
 
 
 
+/*##########################################################################*/
+/* listPoolCreate() - allocates a pool of num_lists lists of wetting fronts,  */
+/* each holding up to capacity fronts in a column of num_layers layers, in a  */
+/* single block of memory                                                     */
+/*##########################################################################*/
+extern struct wetting_front_pool* listPoolCreate(int num_lists, int capacity, int num_layers)
+{
+  struct wetting_front_pool *pool = (struct wetting_front_pool*) malloc(sizeof(struct wetting_front_pool));
+
+  // arrays are 1-indexed (FORTRAN numbering), index 0 is unused
+  size_t n = (size_t)(capacity+1);
+  size_t stride = (size_t)(num_layers+1); // row length of the per-layer psi projections
+
+  pool->capacity  = capacity;
+  pool->num_lists = num_lists;
+  pool->num_free  = num_lists;
+  pool->free_list = (int*) malloc(sizeof(int)*num_lists);
+  pool->lists     = (struct wetting_front_list*) malloc(sizeof(struct wetting_front_list)*num_lists);
+
+  // doubles first, then ints, then bools, so that every array is properly aligned
+  size_t block_nbytes = num_lists * n * ((12 + 2*stride)*sizeof(double) + 4*sizeof(int) + sizeof(bool));
+  pool->block  = malloc(block_nbytes);
+  pool->nbytes = sizeof(struct wetting_front_pool) + sizeof(int)*num_lists
+               + sizeof(struct wetting_front_list)*num_lists + block_nbytes;
+
+  double *d = (double*) pool->block;
+  int    *i = (int*) (d + (12 + 2*stride)*n*num_lists);
+  bool   *b = (bool*) (i + 4*n*num_lists);
+
+  for (int l = 0; l < num_lists; l++) {
+    struct wetting_front_list *fronts = &pool->lists[l];
+
+    fronts->num_fronts    = 0;
+    fronts->capacity      = capacity;
+    fronts->depth_cm      = d; d += n;
+    fronts->theta         = d; d += n;
+    fronts->psi_cm        = d; d += n;
+    fronts->K_cm_per_h    = d; d += n;
+    fronts->dzdt_cm_per_h = d; d += n;
+    fronts->mass_cm       = d; d += n;
+    fronts->mass_total_cm = 0.0;
+    fronts->Geff_cm           = d; d += n;
+    fronts->Geff_theta1       = d; d += n;
+    fronts->Geff_theta2       = d; d += n;
+    fronts->resistance_h      = d; d += n;
+    fronts->resistance_psi_cm = d; d += n;
+    fronts->proj_stride       = (int) stride;
+    fronts->proj_theta        = d; d += n*stride;
+    fronts->proj_K_cm_per_h   = d; d += n*stride;
+    fronts->proj_psi_cm       = d; d += n;
+    fronts->layer_num     = i; i += n;
+    fronts->Geff_layer_num       = i; i += n;
+    fronts->resistance_layer_num = i; i += n;
+    fronts->proj_num_layers      = i; i += n;
+    fronts->to_bottom     = b; b += n;
+    fronts->pool          = pool;
+    fronts->pool_index    = l;
+
+    pool->free_list[l] = num_lists - 1 - l; // lists are handed out in order 0, 1, ...
+  }
+
+  return pool;
+}
+
+
 /*#########################################################*/
-/* listPrint() - prints a linked list to screen             */
+/* listPoolFree() - frees a pool and all its lists           */
 /*#########################################################*/
-extern void listPrint(struct wetting_front* head)
+extern void listPoolFree(struct wetting_front_pool* pool)
+{
+  if (pool == NULL)
+    return;
+
+  free(pool->block);
+  free(pool->lists);
+  free(pool->free_list);
+  free(pool);
+}
+
+
+/*############################################################*/
+/* listCreate() - acquires an empty list of wetting fronts     */
+/* from the pool                                               */
+/*############################################################*/
+extern struct wetting_front_list* listCreate(struct wetting_front_pool* pool)
+{
+  if (pool->num_free == 0) {
+    stringstream errMsg;
+    errMsg << "wetting front pool exhausted, all "<< pool->num_lists << " lists are in use \n";
+    throw runtime_error(errMsg.str());
+  }
+
+  struct wetting_front_list *fronts = &pool->lists[pool->free_list[--pool->num_free]];
+  fronts->num_fronts    = 0;
+  fronts->mass_total_cm = 0.0;
+
+  return fronts;
+}
+
+
+/*#########################################################*/
+/* listFree() - releases a list of wetting fronts to its pool */
+/*#########################################################*/
+extern void listFree(struct wetting_front_list* fronts)
+{
+  if (fronts == NULL)
+    return;
+
+  struct wetting_front_pool *pool = fronts->pool;
+  pool->free_list[pool->num_free++] = fronts->pool_index;
+}
+
+
+/*#######################################################################*/
+/* listShift() - moves fronts first..num_fronts by offset (+1 opens a     */
+/* slot at position first, -1 closes the slot at position first-1)        */
+/*#######################################################################*/
+static void listShift(int first, int offset, struct wetting_front_list* fronts)
+{
+  int count = fronts->num_fronts - first + 1;
+
+  if (count <= 0)
+    return;
+
+  memmove(&fronts->depth_cm[first+offset],      &fronts->depth_cm[first],      sizeof(double)*count);
+  memmove(&fronts->theta[first+offset],         &fronts->theta[first],         sizeof(double)*count);
+  memmove(&fronts->psi_cm[first+offset],        &fronts->psi_cm[first],        sizeof(double)*count);
+  memmove(&fronts->K_cm_per_h[first+offset],    &fronts->K_cm_per_h[first],    sizeof(double)*count);
+  memmove(&fronts->layer_num[first+offset],     &fronts->layer_num[first],     sizeof(int)*count);
+  memmove(&fronts->to_bottom[first+offset],     &fronts->to_bottom[first],     sizeof(bool)*count);
+  memmove(&fronts->dzdt_cm_per_h[first+offset], &fronts->dzdt_cm_per_h[first], sizeof(double)*count);
+  memmove(&fronts->mass_cm[first+offset],       &fronts->mass_cm[first],       sizeof(double)*count);
+
+  memmove(&fronts->Geff_cm[first+offset],              &fronts->Geff_cm[first],              sizeof(double)*count);
+  memmove(&fronts->Geff_theta1[first+offset],          &fronts->Geff_theta1[first],          sizeof(double)*count);
+  memmove(&fronts->Geff_theta2[first+offset],          &fronts->Geff_theta2[first],          sizeof(double)*count);
+  memmove(&fronts->Geff_layer_num[first+offset],       &fronts->Geff_layer_num[first],       sizeof(int)*count);
+  memmove(&fronts->resistance_h[first+offset],         &fronts->resistance_h[first],         sizeof(double)*count);
+  memmove(&fronts->resistance_psi_cm[first+offset],    &fronts->resistance_psi_cm[first],    sizeof(double)*count);
+  memmove(&fronts->resistance_layer_num[first+offset], &fronts->resistance_layer_num[first], sizeof(int)*count);
+
+  int stride = fronts->proj_stride;
+  memmove(&fronts->proj_theta[(first+offset)*stride],      &fronts->proj_theta[first*stride],      sizeof(double)*count*stride);
+  memmove(&fronts->proj_K_cm_per_h[(first+offset)*stride], &fronts->proj_K_cm_per_h[first*stride], sizeof(double)*count*stride);
+  memmove(&fronts->proj_psi_cm[first+offset],              &fronts->proj_psi_cm[first],              sizeof(double)*count);
+  memmove(&fronts->proj_num_layers[first+offset],          &fronts->proj_num_layers[first],          sizeof(int)*count);
+}
+
+
+/*#########################################################*/
+/* listPrint() - prints the list of wetting fronts to screen */
+/*#########################################################*/
+extern void listPrint(struct wetting_front_list* fronts)
 {
-  struct wetting_front *current = head;
   printf("\n[ ");
 
   //start from the beginning
-  while(current != NULL) {
-    if (current->next == NULL)
-      printf("(%lf,%6.14f,%d,%d,%d, %e, %lf %6.14f) ] \n",current->depth_cm, current->theta, current->layer_num,
-	     current->front_num, current->to_bottom, current->dzdt_cm_per_h, current->K_cm_per_h, current->psi_cm);
+  for (int wf = 1; wf <= fronts->num_fronts; wf++) {
+    if (wf == fronts->num_fronts)
+      printf("(%lf,%6.14f,%d,%d,%d, %e, %lf %6.14f) ] \n",fronts->depth_cm[wf], fronts->theta[wf], fronts->layer_num[wf],
+	     wf, fronts->to_bottom[wf], fronts->dzdt_cm_per_h[wf], fronts->K_cm_per_h[wf], fronts->psi_cm[wf]);
     else
-      printf("(%lf,%6.14f,%d,%d,%d, %e, %lf %6.14f)\n",current->depth_cm, current->theta, current->layer_num,
-	     current->front_num, current->to_bottom, current->dzdt_cm_per_h, current->K_cm_per_h, current->psi_cm);
-    current = current->next;
+      printf("(%lf,%6.14f,%d,%d,%d, %e, %lf %6.14f)\n",fronts->depth_cm[wf], fronts->theta[wf], fronts->layer_num[wf],
+	     wf, fronts->to_bottom[wf], fronts->dzdt_cm_per_h[wf], fronts->K_cm_per_h[wf], fronts->psi_cm[wf]);
   }
 
 }
 
-/*###########################################################*/
-/* listCopy() - copies a linked list to another linked list  */
-/*###########################################################*/
-extern struct wetting_front* listCopy(struct wetting_front* current, struct wetting_front* state_previous)
+/*##################################################################################*/
+/* listCopy() - copies a list of wetting fronts into state_previous (acquired from  */
+/* the pool if NULL) and returns the copy                                            */
+/*##################################################################################*/
+extern struct wetting_front_list* listCopy(struct wetting_front_list* fronts, struct wetting_front_list* state_previous)
 {
-  if (current == NULL) {
+  if (fronts == NULL) {
     return NULL;
   }
-  else {
-
-    struct wetting_front* wf = (struct wetting_front*)malloc(sizeof(struct wetting_front));
-
-    wf->depth_cm = current->depth_cm;
-    wf->theta = current->theta;
-    wf->psi_cm = current->psi_cm;
-    wf->K_cm_per_h = current->K_cm_per_h;
-    wf->layer_num = current->layer_num;
-    wf->front_num = current->front_num;
-    wf->to_bottom = current->to_bottom;
-    wf->dzdt_cm_per_h = current->dzdt_cm_per_h;
-    wf->next = listCopy(current->next, NULL);
-
-    if (state_previous == NULL)
-      state_previous = wf;
-    return wf;
-  }
+
+  int n = fronts->num_fronts;
+
+  if (state_previous == NULL)
+    state_previous = listCreate(fronts->pool);
+
+  memcpy(&state_previous->depth_cm[1],      &fronts->depth_cm[1],      sizeof(double)*n);
+  memcpy(&state_previous->theta[1],         &fronts->theta[1],         sizeof(double)*n);
+  memcpy(&state_previous->psi_cm[1],        &fronts->psi_cm[1],        sizeof(double)*n);
+  memcpy(&state_previous->K_cm_per_h[1],    &fronts->K_cm_per_h[1],    sizeof(double)*n);
+  memcpy(&state_previous->layer_num[1],     &fronts->layer_num[1],     sizeof(int)*n);
+  memcpy(&state_previous->to_bottom[1],     &fronts->to_bottom[1],     sizeof(bool)*n);
+  memcpy(&state_previous->dzdt_cm_per_h[1], &fronts->dzdt_cm_per_h[1], sizeof(double)*n);
+  memcpy(&state_previous->mass_cm[1],       &fronts->mass_cm[1],       sizeof(double)*n);
+
+  memcpy(&state_previous->Geff_cm[1],              &fronts->Geff_cm[1],              sizeof(double)*n);
+  memcpy(&state_previous->Geff_theta1[1],          &fronts->Geff_theta1[1],          sizeof(double)*n);
+  memcpy(&state_previous->Geff_theta2[1],          &fronts->Geff_theta2[1],          sizeof(double)*n);
+  memcpy(&state_previous->Geff_layer_num[1],       &fronts->Geff_layer_num[1],       sizeof(int)*n);
+  memcpy(&state_previous->resistance_h[1],         &fronts->resistance_h[1],         sizeof(double)*n);
+  memcpy(&state_previous->resistance_psi_cm[1],    &fronts->resistance_psi_cm[1],    sizeof(double)*n);
+  memcpy(&state_previous->resistance_layer_num[1], &fronts->resistance_layer_num[1], sizeof(int)*n);
+
+  int stride = fronts->proj_stride;
+  memcpy(&state_previous->proj_theta[stride],      &fronts->proj_theta[stride],      sizeof(double)*n*stride);
+  memcpy(&state_previous->proj_K_cm_per_h[stride], &fronts->proj_K_cm_per_h[stride], sizeof(double)*n*stride);
+  memcpy(&state_previous->proj_psi_cm[1],          &fronts->proj_psi_cm[1],          sizeof(double)*n);
+  memcpy(&state_previous->proj_num_layers[1],      &fronts->proj_num_layers[1],      sizeof(int)*n);
+
+  state_previous->num_fronts    = n;
+  state_previous->mass_total_cm = fronts->mass_total_cm;
+
+  return state_previous;
 }
 
 
 /*#######################################################*/
 /* listInsertFirst - adds a list entry to start of list  */
+/* returns the position (1) of the new front             */
 /*#######################################################*/
-extern void listInsertFirst(double depth, double theta, int front_num, int layer_num, bool bottom_flag, struct wetting_front** head)
+extern int listInsertFirst(double depth, double theta, int layer_num, bool bottom_flag, struct wetting_front_list* fronts)
 {
-
-  //create a link
-  struct wetting_front *link = (struct wetting_front*) malloc(sizeof(struct wetting_front));
-
-  link->depth_cm = depth;
-  link->theta = theta;
-  link->front_num = front_num;
-  link->layer_num = layer_num;
-  link->to_bottom = bottom_flag;
-  link->dzdt_cm_per_h = (double)0.0;
-  
-  //point it to old first wetting_front
-  link->next = *head;
-
- 
-  //point head to new first wetting_front  FORGET THIS CODE WON'T WORK
-  *head = link;
-  link = (*head)->next;
-  
-  while (link != NULL) {
-    link->front_num++;
-    link=link->next;
-  }
-
+  return listInsertFront(depth, theta, 1, layer_num, bottom_flag, fronts);
 }
 
 
 /*#######################################################*/
-/* listDeleteFirst -deletes the first entry of a linked list */
+/* listDeleteFirst -deletes the first entry of the list  */
 /*#######################################################*/
-extern struct wetting_front* listDeleteFirst(struct wetting_front* head)
+extern void listDeleteFirst(struct wetting_front_list* fronts)
 {
-
-  //save reference to first link
-  struct wetting_front *tempLink = head;
-
-  //mark next to first link as first
-  head = head->next;
-
-  //return the deleted link
-  return tempLink;
+  if (fronts->num_fronts > 0)
+    listDeleteFront(1, fronts);
 }
 
 
@@ -130,9 +268,9 @@ extern struct wetting_front* listDeleteFirst(struct wetting_front* head)
 /*#######################################################*/
 /* listIsEmpty - checks to see if the list is empty          */
 /*#######################################################*/
-bool listIsEmpty(struct wetting_front* head)
+bool listIsEmpty(struct wetting_front_list* fronts)
 {
-  return head == NULL;
+  return fronts == NULL || fronts->num_fronts == 0;
 }
 
 
@@ -140,180 +278,66 @@ bool listIsEmpty(struct wetting_front* head)
 /*#######################################################*/
 /* listLength - counts how many items are in the list    */
 /*#######################################################*/
-int listLength(struct wetting_front* head)
-{
-  int listLength = 0;
-  struct wetting_front *current;
-
-  for(current = head; current != NULL; current = current->next) {
-    listLength++;
-  }
-
-  return listLength;
-}
-
-
-/*#######################################################################################*/
-/* listFindFront -searches linked list for a particular front number and returns that struct */
-/*#######################################################################################*/
-extern struct wetting_front* listFindFront(int key, struct wetting_front* head, struct wetting_front* head_old)
+int listLength(struct wetting_front_list* fronts)
 {
+  if (fronts == NULL)
+    return 0;
 
-  //start from the first link
-  struct wetting_front* current=NULL;
-  if (head_old == NULL)
-    current = head;
-  else
-    current = head_old;
-
-  //iff list is empty
-  if (head == NULL) {
-    return NULL;
-  }
-
-  //list not empty, so search through list
-  while(current->front_num != key) { // as soon as front_num==key, this loop stops
-    //if it is last wetting_front
-    if(current->next == NULL) {
-      return NULL;
-    }
-    else {
-      //go to next link
-      current = current->next;
-    }
-  }
-
-  //if data found, return the current Link
-  return current;
+  return fronts->num_fronts;
 }
 
 
 /*##############################################################*/
 /* listDeleteFront -delete the front with a particular front number */
+/* the deeper fronts move up by one position (their front numbers   */
+/* decrease by 1); its mass contribution leaves the running total   */
 /*##############################################################*/
-extern struct wetting_front* listDeleteFront(int front_num, struct wetting_front** head)
+extern void listDeleteFront(int front_num, struct wetting_front_list* fronts)
 {
-  //start from the first link
-  struct wetting_front* current = *head;
-  struct wetting_front* previous = NULL;
-
-  //if list is empty
-  // debugging
-  bool front_found = false;
-  while(current != NULL) {
-    if (current->front_num == front_num) {
-      front_found = true;
-    }
-    current = current->next;
-  }
-
-  if (!front_found) abort();
-
-  current = *head;
-  if(*head == NULL) {
-    return NULL; // can't do anything, there is no list.
-  }
-
-  //navigate through list
-  while(current->front_num != front_num) {
-    //if it is last wetting_front
-    if(current->next == NULL) {
-      return NULL;
-    }
-    else {
-      //store reference to current link
-      previous = current;
-      //move to next link
-      current = current->next;
-    }
-  }
+  if (front_num < 1 || front_num > fronts->num_fronts) abort();
 
-  //found a match, update the link
-  if(current == *head) {
-    //change first to point to next link
-    *head = (*head)->next;
-    previous = *head;
-  }
-  else {
-    //bypass the current link
-    previous->next = current->next;
-    previous = current->next;
+  fronts->mass_total_cm -= fronts->mass_cm[front_num];
 
-  }
-
-  current = previous;
+  listShift(front_num+1, -1, fronts);
 
-  while(previous != NULL) { // decrement all front numbers
-    previous->front_num--;
-    previous = previous->next;
-  }
-
-  return current;
+  fronts->num_fronts--;
 }
 
 
 /*####################################################################*/
 /* listInsertFront -creates a new front at specified position in list */
 /* and increase all front numbers greater than or equal to the        */
-/* new front number by 1.                                             */
+/* new front number by 1. Returns the new front number, or 0 if the   */
+/* position is not valid                                              */
 /*####################################################################*/
-extern struct wetting_front* listInsertFront(double depth, double theta, int new_front_num,
-                                             int layer_num, bool bottom_flag, struct wetting_front** head)
+extern int listInsertFront(double depth, double theta, int new_front_num,
+                           int layer_num, bool bottom_flag, struct wetting_front_list* fronts)
 {
-  //start from the first link
-  struct wetting_front* current = NULL;
-  struct wetting_front* previous = NULL;
-
-  if(*head == NULL) { // list is empty
-    
-    if(new_front_num==1) { // create it
-      //create a link
-      struct wetting_front *link = (struct wetting_front*) malloc(sizeof(struct wetting_front));
-
-      link->depth_cm = depth;
-      link->theta = theta;
-      link->front_num = new_front_num;
-      link->layer_num = layer_num;
-      link->to_bottom = bottom_flag;
-      link->dzdt_cm_per_h = (double)(0.0);
-      link->next = NULL;
-      *head=link;
-      return link;
-    }
-    else { // list is empty and desired link number is >1, unable to create
-      return NULL;
-    }
+  if (new_front_num < 1 || new_front_num > fronts->num_fronts + 1) // unable to create
+    return 0;
+
+  if (fronts->num_fronts == fronts->capacity) {
+    stringstream errMsg;
+    errMsg << "number of wetting fronts exceeds the maximum ("<< fronts->capacity
+	   << "), increase MAX_NUM_WETTING_FRONTS \n";
+    throw runtime_error(errMsg.str());
   }
-  
-  // list is not empty, so search through list
-  previous = *head;
-  do {
-    if (previous->front_num == new_front_num-1) { // this is where we want to insert it
-      //create a new link
-      struct wetting_front *link = (struct wetting_front*) malloc(sizeof(struct wetting_front));
-
-      link->depth_cm = depth;
-      link->theta = theta;
-      link->front_num = new_front_num;
-      link->layer_num = layer_num;
-      link->to_bottom = bottom_flag;
-      link->dzdt_cm_per_h = (double)(0.0);
-      link->next = previous->next ;
-      previous->next = link;
-
-      while(link->next != NULL) { // increment all front numbers
-	current = link->next;
-	current->front_num++;
-	previous = current;
-	current = current->next;
-      }
 
-      return link;
-    }
+  listShift(new_front_num, 1, fronts);
+  fronts->num_fronts++;
+
+  fronts->depth_cm[new_front_num]      = depth;
+  fronts->theta[new_front_num]         = theta;
+  fronts->layer_num[new_front_num]     = layer_num;
+  fronts->to_bottom[new_front_num]     = bottom_flag;
+  fronts->dzdt_cm_per_h[new_front_num] = (double)(0.0);
+  fronts->mass_cm[new_front_num]       = (double)(0.0); // not accounted for until its mass is updated
 
-    previous = previous->next;
-  } while(TRUE);
+  fronts->Geff_layer_num[new_front_num]       = 0; // nothing cached yet
+  fronts->resistance_layer_num[new_front_num] = 0;
+  fronts->proj_num_layers[new_front_num]      = 0;
 
+  return new_front_num;
 }
 
 /*############################################################################*/
@@ -321,214 +345,149 @@ extern struct wetting_front* listInsertFront(double depth, double theta, int new
 /* and increase all front numbers greater than or equal to the                */
 /* new front number by 1. Determines layer number, front number and           */
 /* determine if the new front is at the bottom of the layer                   */
+/* Returns the new front number, or 0 if the depth is not in the soil         */
 /*############################################################################*/
-extern struct wetting_front* listInsertFrontAtDepth(int num_layers, double *cum_layer_thickness,
-                                                    double depth, double theta, struct wetting_front* head)
+extern int listInsertFrontAtDepth(int num_layers, double *cum_layer_thickness,
+                                  double depth, double theta, struct wetting_front_list* fronts)
 {
   int el_layer=0;
   bool extends_to_bottom_flag = FALSE;
-  bool layer_found_flag = FALSE;
-
-  struct wetting_front *link = NULL;
 
-  //start from the first link
-  struct wetting_front* current = head;
-  struct wetting_front* previous = NULL;
+  if (listFindLayer(depth, num_layers, cum_layer_thickness, &el_layer, &extends_to_bottom_flag) == FALSE)
+    return 0; // this should never happen, unless it asks to create a front not in the soil
 
-  if(head == NULL) { // list is empty
-    // Kinda weird.  Shouldn't call this function to start a list.  Create link in the first position
+  // search through list to find where this front fits in.  Might be first though...
+  int new_front_num = 1;
+  while (new_front_num <= fronts->num_fronts && depth > fronts->depth_cm[new_front_num])
+    new_front_num++;
 
-    link = (struct wetting_front*) malloc(sizeof(struct wetting_front));
-
-    link->depth_cm = depth;
-    link->theta = theta;
-    link->to_bottom = FALSE;
-
-    layer_found_flag = listFindLayer(link,num_layers,cum_layer_thickness, &el_layer, &extends_to_bottom_flag);
-
-    if(layer_found_flag ==FALSE) {
-      return NULL; // this should never happen, unless it asks to create a front not in the soil
-    }
-
-    link->layer_num = el_layer;
-    link->to_bottom = extends_to_bottom_flag;
-    link->dzdt_cm_per_h = (double)(-1.0);
-    link->next = NULL;   // because this is the first link.
-    head = link;  // don't forget this.  Must keep head current with the beginning of the list.
-    return link;
-  }
-  else {
-    // list is not empty, so search through list fo find where this front fits in.  Might be first though...
-    if(depth < current->depth_cm) {
-      // yep.  It's first
-      //create a link and put it at the beginning of the list
-
-      link = (struct wetting_front*) malloc(sizeof(struct wetting_front));
-
-      link->depth_cm = depth;
-      link->theta = theta;
-      link->to_bottom = FALSE;
-
-      layer_found_flag = listFindLayer(link,num_layers,cum_layer_thickness, &el_layer, &extends_to_bottom_flag);
-
-      if(layer_found_flag ==FALSE) {
-	return NULL; // this should never happen, unless it asks to create a front not in the soil
-      }
-
-      link->layer_num = el_layer;
-      link->to_bottom = extends_to_bottom_flag;
-      link->dzdt_cm_per_h = (double)(-1.0);
-      link->next = head;   // point to the old first list entry
-      head=link;  // don't forget this.  Must keep head point to the beginning of the list
-      return link;
-    }
-    else {
-      // the new one is not the first wetting front in the list sorted by depth, search to see where it fits.
-
-      previous=current;
-      current=current->next;
-      do {
-	if((depth > previous->depth_cm ) && (depth <= current->depth_cm) ) {
-	  // it is in this interval
-
-	  // create a link
-	  link = (struct wetting_front*) malloc(sizeof(struct wetting_front));
-
-	  link->depth_cm = depth;
-	  link->theta = theta;
-	  link->to_bottom = FALSE;
-
-	  layer_found_flag = listFindLayer(link,num_layers,cum_layer_thickness,
-					   &el_layer, &extends_to_bottom_flag);
-
-	  if(layer_found_flag ==FALSE) {
-	    return NULL; // this should never happen, unless it asks to create a front not in the soil
-	  }
-
-	  link->layer_num = el_layer;
-	  link->to_bottom = extends_to_bottom_flag;
-	  link->dzdt_cm_per_h = (double)(-1.0);
-	  link->front_num = current->front_num;
-	  link->next = current;   // point to one replaced
-	  previous->next = link;  // make the previous one point to this new one
-	  current = previous->next;
-	  break;
-	}
-
-	previous=current;
-	current=previous->next;
-      } while ( current != NULL );
-
-      if (layer_found_flag == TRUE && current->next != NULL) {
-	//re-number the links that follow the current link
-	current=current->next;
-
-	while (current != NULL) { // increment all front numbers
-	  //printf("front number: %3d, current->next=%p\n",current->front_num,current->next);
-	  current->front_num++;
-	  previous = current;
-	  current = current->next;
-        }
-
-	return link;
-      }
-      else {
-	return NULL;
-      }
-    }
-  }
+  listInsertFront(depth, theta, new_front_num, el_layer, extends_to_bottom_flag, fronts);
+  fronts->dzdt_cm_per_h[new_front_num] = (double)(-1.0);
 
+  return new_front_num;
 }
 
 
 /*##############################################################*/
-/* listFindLayer -find what layer a newly created link lives in */
+/* listFindLayer -find what layer a front at a given depth lives in */
+/* bisection on the cumulative layer depths, O(log(num_layers))     */
 /*###############################################################*/
-extern bool listFindLayer( struct wetting_front* link, int num_layers, double *cum_layer_thickness_cm,
-                           int *lives_in_layer,bool *extends_to_bottom_flag)
+extern bool listFindLayer(double depth, int num_layers, double *cum_layer_thickness_cm,
+                          int *lives_in_layer,bool *extends_to_bottom_flag)
 {
 
-  int layer;
-  double depth;
+  int lower = 1;            // first layer whose bottom may be at or below depth
+  int upper = num_layers;
 
   (*lives_in_layer)=0;
-  depth=link->depth_cm;
-  for (layer=1; layer<=num_layers; layer++) {
-    if(depth <= cum_layer_thickness_cm[layer] && depth > cum_layer_thickness_cm[layer-1]) {
-      (*lives_in_layer)  = layer;
-      if ( is_epsilon_less_than (depth-cum_layer_thickness_cm[layer],1.0E-05) )
-	(*extends_to_bottom_flag)=TRUE;
-      break;
-    }
-  }
-  if ( (*lives_in_layer) == 0)
+
+  if (num_layers < 1 || !(depth > cum_layer_thickness_cm[0] && depth <= cum_layer_thickness_cm[num_layers]))
     return FALSE;
-  else
-    return TRUE;
+
+  // find the shallowest layer with cum_layer_thickness_cm[layer] >= depth
+  while (lower < upper) {
+    int mid = (lower + upper) / 2;
+    if (depth <= cum_layer_thickness_cm[mid])
+      upper = mid;
+    else
+      lower = mid + 1;
+  }
+
+  (*lives_in_layer) = lower;
+  if ( is_epsilon_less_than (depth-cum_layer_thickness_cm[lower],1.0E-05) )
+    (*extends_to_bottom_flag)=TRUE;
+
+  return TRUE;
 }
 
 /*#################################################################################################*/
 /* listSortFrontsByDepth -if fronts get out of order, this routine sorts them back into order by depth */
 /*#################################################################################################*/
-extern void listSortFrontsByDepth(struct wetting_front *head)
+extern void listSortFrontsByDepth(struct wetting_front_list* fronts)
 {
-  int i, j, k, tempKey;
+  int i, j, tempKey;
   double tempData;
-  struct wetting_front *current;
-  struct wetting_front *next;
+  bool tempFlag;
 
-  int size = listLength(head);
-  k = size ;
+  int size = listLength(fronts);
 
-  for ( i = 0 ; i < size - 1 ; i++, k-- ) {
-    current = head;
-    next = head->next;
+  for ( i = 1 ; i < size ; i++ ) {
+    for ( j = 1 ; j <= size - i ; j++ ) {
+      if ( fronts->depth_cm[j] > fronts->depth_cm[j+1] ) {
+	tempData = fronts->depth_cm[j];
+	fronts->depth_cm[j] = fronts->depth_cm[j+1];
+	fronts->depth_cm[j+1] = tempData;
 
-    for ( j = 1 ; j < k ; j++ ) {
-      if ( current->depth_cm > next->depth_cm ) {
-	tempData = current->depth_cm;
-	current->depth_cm = next->depth_cm;
-	next->depth_cm = tempData;
+	tempData = fronts->theta[j];
+	fronts->theta[j] = fronts->theta[j+1];
+	fronts->theta[j+1] = tempData;
 
-	tempData = current->theta;
-	current->theta = next->theta;
-	next->theta = tempData;
+	tempData = fronts->psi_cm[j];
+	fronts->psi_cm[j] = fronts->psi_cm[j+1];
+	fronts->psi_cm[j+1] = tempData;
 
-	tempKey = current->layer_num;
-	current->layer_num = next->layer_num;
-	next->layer_num = tempKey;
+	tempData = fronts->K_cm_per_h[j];
+	fronts->K_cm_per_h[j] = fronts->K_cm_per_h[j+1];
+	fronts->K_cm_per_h[j+1] = tempData;
 
-	tempKey = current->front_num;
-	current->front_num = next->front_num;
-	next->front_num = tempKey;
-      }
+	tempData = fronts->dzdt_cm_per_h[j];
+	fronts->dzdt_cm_per_h[j] = fronts->dzdt_cm_per_h[j+1];
+	fronts->dzdt_cm_per_h[j+1] = tempData;
 
-      current = current->next;
-      next = next->next;
+	tempData = fronts->mass_cm[j];
+	fronts->mass_cm[j] = fronts->mass_cm[j+1];
+	fronts->mass_cm[j+1] = tempData;
+
+	tempKey = fronts->layer_num[j];
+	fronts->layer_num[j] = fronts->layer_num[j+1];
+	fronts->layer_num[j+1] = tempKey;
+
+	tempFlag = fronts->to_bottom[j];
+	fronts->to_bottom[j] = fronts->to_bottom[j+1];
+	fronts->to_bottom[j+1] = tempFlag;
+      }
     }
   }
 
+  // cached dz/dt inputs refer to the old neighbors
+  for (i = 1 ; i <= size ; i++) {
+    fronts->Geff_layer_num[i]       = 0;
+    fronts->resistance_layer_num[i] = 0;
+    fronts->proj_num_layers[i]      = 0;
+  }
+
 }
 
 
 
 /*####################################################################*/
-/* listReverseOrder  - reverses the order of the current linked list  */
+/* listReverseOrder  - reverses the order of the current list         */
 /*####################################################################*/
 // probably not needed, left in as an example of how it's done
-extern void listReverseOrder(struct wetting_front** head_ref)
+extern void listReverseOrder(struct wetting_front_list* fronts)
 {
   printf("In Reverse order.... \n ");
-  struct wetting_front* prev   = NULL;
-  struct wetting_front* current = *head_ref;  // notice that it is passed down as a pointer to a pointer, that explains
-  struct wetting_front* next;                 // why they call this "head_ref", it is a pointer referencing the
-  // pointer struct wetting_front *head.
-  while (current != NULL) {
-    next  = current->next;
-    current->next = prev;
-    prev = current;
-    current = next;
+  int n = fronts->num_fronts;
+
+  for (int i = 1, j = n; i < j; i++, j--) {
+    double tempData;
+    int tempKey;
+    bool tempFlag;
+
+    tempData = fronts->depth_cm[i];      fronts->depth_cm[i] = fronts->depth_cm[j];           fronts->depth_cm[j] = tempData;
+    tempData = fronts->theta[i];         fronts->theta[i] = fronts->theta[j];                 fronts->theta[j] = tempData;
+    tempData = fronts->psi_cm[i];        fronts->psi_cm[i] = fronts->psi_cm[j];               fronts->psi_cm[j] = tempData;
+    tempData = fronts->K_cm_per_h[i];    fronts->K_cm_per_h[i] = fronts->K_cm_per_h[j];       fronts->K_cm_per_h[j] = tempData;
+    tempData = fronts->dzdt_cm_per_h[i]; fronts->dzdt_cm_per_h[i] = fronts->dzdt_cm_per_h[j]; fronts->dzdt_cm_per_h[j] = tempData;
+    tempData = fronts->mass_cm[i];       fronts->mass_cm[i] = fronts->mass_cm[j];             fronts->mass_cm[j] = tempData;
+    tempKey  = fronts->layer_num[i];     fronts->layer_num[i] = fronts->layer_num[j];         fronts->layer_num[j] = tempKey;
+    tempFlag = fronts->to_bottom[i];     fronts->to_bottom[i] = fronts->to_bottom[j];         fronts->to_bottom[j] = tempFlag;
   }
 
-  *head_ref = prev;
+  // cached dz/dt inputs refer to the old neighbors
+  for (int i = 1; i <= n; i++) {
+    fronts->Geff_layer_num[i]       = 0;
+    fronts->resistance_layer_num[i] = 0;
+    fronts->proj_num_layers[i]      = 0;
+  }
 }
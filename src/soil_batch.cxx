@@ -0,0 +1,276 @@
+#include "../include/all.hxx"
+#include <stdint.h>
+#ifdef SOIL_BATCH_SIMD
+#include <immintrin.h>
+#endif
+
+/*##################################################*/
+/*##################################################*/
+//  Batch versions of the van Genuchten and conductivity functions of soil_funcs.cxx
+//
+//  The functions take arrays of n (argument, soil) pairs and evaluate several pairs at once in the lanes of SIMD
+//  registers: 2 (SSE2), 4 (AVX2) or 8 (AVX-512) doubles. The instruction set is an option of the model
+//  (batch_kernels, stored with each soil in batch_isa); the default, SOIL_BATCH_SCALAR, calls the scalar functions of
+//  soil_funcs.cxx, which are also the reference for the accuracy of the vector kernels. The vector kernels round
+//  differently (fused multiply-adds, their own log and exp), so the model outputs then differ in the last digits
+//  between instruction sets, and machines.
+//
+//  The kernels (soil_batch_kernels.hxx) are written once, with the generic vector types of GCC (vector_size), and
+//  compiled for each instruction set in a namespace of their own under its target pragma. They are compiled only if
+//  the build defines SOIL_BATCH_SIMD, which CMakeLists.txt does for GCC on x86 processors; otherwise only the scalar
+//  functions are available.
+//
+//  pow is computed as exp(y*log(x)) with log(x) and the product y*log(x) carried in double-double arithmetic, so that
+//  the large exponents of dry soils (y*log(x) up to several hundreds) do not amplify the rounding of the logarithm;
+//  the relations are evaluated in forms free of cancellation (log1p, expm1) near saturation and in dry soils. The
+//  error of the vector kernels is a few ulp against a long double evaluation of the same relations for the soils of
+//  data/vG_default_params.dat (see the batch kernel test in tests/main_unit_test_bmi.cxx).
+//
+//  Elements whose soil has van Genuchten tables (vg_table) and arguments outside the domain of the vector kernels
+//  (non-positive or non-finite) are computed with the scalar functions.
+//
+//  A vector pass costs about as much as three or four scalar evaluations, so batches smaller than that (min_n; the
+//  model's batches are mostly runs of one to three soils) are computed with the scalar functions too. SSE2, with two
+//  lanes and no fused multiply-add, is slower than the scalar functions at any batch size; it is kept for the
+//  accuracy test.
+/*##################################################*/
+
+#ifdef SOIL_BATCH_SIMD
+// the kernels are compiled with optimization whatever the build type (unoptimized vector code keeps every
+// intermediate vector in memory); the error-free transformations (two_sum, two_prod) are exact only if evaluated as
+// written, the fused multiply-adds are explicit (mul_add)
+#pragma GCC optimize ("O2", "fp-contract=off")
+
+static const double LN2_HI   = 6.93147180369123816490e-01;  // ln(2), upper 32 bits (k*LN2_HI is exact)
+static const double LN2_LO   = 1.90821492927058770002e-10;  // ln(2) - LN2_HI
+static const double INV_LN2  = 1.44269504088896338700e+00;
+static const double ROUNDING = 6755399441055744.0;          // 1.5*2^52: x + ROUNDING rounds x to an integer
+static const int64_t ROUNDING_BITS = 0x4338000000000000LL;  // bit pattern of ROUNDING
+static const double EXP_ARG_MAX = 1400.0;                   // exp overflows (underflows) beyond +(-)709 (-745)
+#endif
+
+typedef void (*soil_batch_function)(int n, const double *x, const int *soil_num,
+				    const struct soil_properties_ *soil_properties, double *y);
+typedef void (*soil_batch_function2)(int n, const double *x, const int *soil_num,
+				     const struct soil_properties_ *soil_properties, double *y, double *dy);
+
+struct soil_batch_kernels
+{
+  int min_n;  // batches of fewer elements are computed with the scalar functions, faster for them
+  soil_batch_function theta_from_h, Se_from_h, dtheta_dh, h_from_Se, K_from_Se;
+  soil_batch_function2 theta_dtheta_dh;
+};
+
+// ############################################################################################
+// scalar reference
+// ############################################################################################
+static void theta_from_h_scalar(int n, const double *h, const int *soil_num,
+				const struct soil_properties_ *soil_properties, double *theta)
+{
+  for (int i = 0; i < n; i++)
+    theta[i] = calc_theta_from_h(h[i], &soil_properties[soil_num[i]]);
+}
+
+static void Se_from_h_scalar(int n, const double *h, const int *soil_num,
+			     const struct soil_properties_ *soil_properties, double *Se)
+{
+  for (int i = 0; i < n; i++) {
+    const struct soil_properties_ *soil = &soil_properties[soil_num[i]];
+    Se[i] = calc_Se_from_h(h[i], soil->vg_alpha_per_cm, soil->vg_m, soil->vg_n);
+  }
+}
+
+static void dtheta_dh_scalar(int n, const double *h, const int *soil_num,
+			     const struct soil_properties_ *soil_properties, double *dtheta_dh)
+{
+  for (int i = 0; i < n; i++)
+    dtheta_dh[i] = calc_dtheta_dh(h[i], &soil_properties[soil_num[i]]);
+}
+
+static void h_from_Se_scalar(int n, const double *Se, const int *soil_num,
+			     const struct soil_properties_ *soil_properties, double *h)
+{
+  for (int i = 0; i < n; i++)
+    h[i] = calc_h_from_Se(Se[i], &soil_properties[soil_num[i]]);
+}
+
+static void K_from_Se_scalar(int n, const double *Se, const int *soil_num,
+			     const struct soil_properties_ *soil_properties, double *K)
+{
+  for (int i = 0; i < n; i++) {
+    const struct soil_properties_ *soil = &soil_properties[soil_num[i]];
+    K[i] = calc_K_from_Se(Se[i], soil->Ksat_cm_per_h, soil);
+  }
+}
+
+static void theta_dtheta_dh_scalar(int n, const double *h, const int *soil_num,
+				   const struct soil_properties_ *soil_properties, double *theta, double *dtheta_dh)
+{
+  for (int i = 0; i < n; i++) {
+    double h_i = h[i];  // theta may be the argument array
+    theta[i] = calc_theta_from_h(h_i, &soil_properties[soil_num[i]]);
+    dtheta_dh[i] = calc_dtheta_dh(h_i, &soil_properties[soil_num[i]]);
+  }
+}
+
+static const struct soil_batch_kernels scalar_kernels = {0, theta_from_h_scalar, Se_from_h_scalar, dtheta_dh_scalar,
+							 h_from_Se_scalar, K_from_Se_scalar, theta_dtheta_dh_scalar};
+
+// ############################################################################################
+// vector kernels of each instruction set
+// ############################################################################################
+#ifdef SOIL_BATCH_SIMD
+
+#pragma GCC push_options
+#pragma GCC target ("sse2")
+namespace soil_batch_sse2 {
+  typedef double   VD __attribute__((vector_size(16)));
+  typedef int64_t  VI __attribute__((vector_size(16)));
+  typedef uint64_t VU __attribute__((vector_size(16)));
+  static const int W = 2;
+  static const int MIN_N = 0;  // slower than the scalar functions at any batch size
+  static const bool HAS_FMA = false;
+
+  static inline __attribute__((always_inline)) VD mul_add(VD a, VD b, VD c)
+  {
+    return a*b + c;
+  }
+
+#include "../include/soil_batch_kernels.hxx"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target ("avx2,fma")
+namespace soil_batch_avx2 {
+  typedef double   VD __attribute__((vector_size(32)));
+  typedef int64_t  VI __attribute__((vector_size(32)));
+  typedef uint64_t VU __attribute__((vector_size(32)));
+  static const int W = 4;
+  static const int MIN_N = 3;
+  static const bool HAS_FMA = true;
+
+  static inline __attribute__((always_inline)) VD mul_add(VD a, VD b, VD c)
+  {
+    return (VD) _mm256_fmadd_pd((__m256d) a, (__m256d) b, (__m256d) c);
+  }
+
+#include "../include/soil_batch_kernels.hxx"
+}
+#pragma GCC pop_options
+
+#pragma GCC push_options
+#pragma GCC target ("avx512f,avx512dq")
+namespace soil_batch_avx512 {
+  typedef double   VD __attribute__((vector_size(64)));
+  typedef int64_t  VI __attribute__((vector_size(64)));
+  typedef uint64_t VU __attribute__((vector_size(64)));
+  static const int W = 8;
+  static const int MIN_N = 4;
+  static const bool HAS_FMA = true;
+
+  static inline __attribute__((always_inline)) VD mul_add(VD a, VD b, VD c)
+  {
+    return (VD) _mm512_fmadd_pd((__m512d) a, (__m512d) b, (__m512d) c);
+  }
+
+#include "../include/soil_batch_kernels.hxx"
+}
+#pragma GCC pop_options
+
+#endif
+
+// ############################################################################################
+// instruction sets
+// ############################################################################################
+
+extern bool soil_batch_supported(int isa)
+{
+#ifdef SOIL_BATCH_SIMD
+  __builtin_cpu_init();
+
+  switch (isa) {
+  case SOIL_BATCH_SCALAR: return true;
+  case SOIL_BATCH_SSE2:   return __builtin_cpu_supports("sse2");
+  case SOIL_BATCH_AVX2:   return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  case SOIL_BATCH_AVX512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+  default:                return false;
+  }
+#else
+  return isa == SOIL_BATCH_SCALAR;
+#endif
+}
+
+extern const char* soil_batch_name(int isa)
+{
+  switch (isa) {
+  case SOIL_BATCH_SCALAR: return "scalar";
+  case SOIL_BATCH_SSE2:   return "SSE2";
+  case SOIL_BATCH_AVX2:   return "AVX2";
+  case SOIL_BATCH_AVX512: return "AVX-512";
+  default:                return "unknown";
+  }
+}
+
+// ############################################################################################
+// batch functions
+// ############################################################################################
+
+// kernels of a batch of n elements, in the instruction set of the model (batch_isa of its soils); batches of fewer
+// than min_n elements (plus extra_n) use the scalar functions
+static inline const struct soil_batch_kernels* batch_kernels(int n, const int *soil_num,
+							      const struct soil_properties_ *soil_properties, int extra_n)
+{
+  const struct soil_batch_kernels *kernels = &scalar_kernels;
+
+  if (n <= 0)
+    return kernels;
+
+  switch (soil_properties[soil_num[0]].batch_isa) {
+#ifdef SOIL_BATCH_SIMD
+  case SOIL_BATCH_SSE2:   kernels = &soil_batch_sse2::kernels;   break;
+  case SOIL_BATCH_AVX2:   kernels = &soil_batch_avx2::kernels;   break;
+  case SOIL_BATCH_AVX512: kernels = &soil_batch_avx512::kernels; break;
+#endif
+  default:                break;
+  }
+
+  return n < kernels->min_n + extra_n ? &scalar_kernels : kernels;
+}
+
+extern void calc_theta_from_h_batch(int n, const double *h, const int *soil_num,
+				    const struct soil_properties_ *soil_properties, double *theta)
+{
+  batch_kernels(n, soil_num, soil_properties, 0)->theta_from_h(n, h, soil_num, soil_properties, theta);
+}
+
+extern void calc_Se_from_h_batch(int n, const double *h, const int *soil_num,
+				 const struct soil_properties_ *soil_properties, double *Se)
+{
+  batch_kernels(n, soil_num, soil_properties, 0)->Se_from_h(n, h, soil_num, soil_properties, Se);
+}
+
+extern void calc_dtheta_dh_batch(int n, const double *h, const int *soil_num,
+				 const struct soil_properties_ *soil_properties, double *dtheta_dh)
+{
+  batch_kernels(n, soil_num, soil_properties, 0)->dtheta_dh(n, h, soil_num, soil_properties, dtheta_dh);
+}
+
+extern void calc_h_from_Se_batch(int n, const double *Se, const int *soil_num,
+				 const struct soil_properties_ *soil_properties, double *h)
+{
+  batch_kernels(n, soil_num, soil_properties, 0)->h_from_Se(n, Se, soil_num, soil_properties, h);
+}
+
+extern void calc_K_from_Se_batch(int n, const double *Se, const int *soil_num,
+				 const struct soil_properties_ *soil_properties, double *K)
+{
+  batch_kernels(n, soil_num, soil_properties, 0)->K_from_Se(n, Se, soil_num, soil_properties, K);
+}
+
+extern void calc_theta_dtheta_dh_batch(int n, const double *h, const int *soil_num,
+				       const struct soil_properties_ *soil_properties, double *theta, double *dtheta_dh)
+{
+  // two scalar functions per element: the vector kernel pays off one element earlier
+  batch_kernels(n, soil_num, soil_properties, -1)->theta_dtheta_dh(n, h, soil_num, soil_properties, theta, dtheta_dh);
+}
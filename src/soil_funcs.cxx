@@ -29,23 +29,236 @@
 /* author: Fred Ogden, June, 2021, edited by Peter La Follette in 2023 for adaptive integral   */
 //updated to calculate G using an adaptive integral method, rather than always using a fixed number of trapezoids.
 //This really helps when the limits of integration in terms of psi are quite far apart, and also helps to save runtime.
+//The integral is computed with globally adaptive 7-15 point Gauss-Kronrod quadrature in the variable s = ln(h), in which
+//K(h)*h varies slowly over the many decades of h spanned by the limits; panels are bisected until the estimated relative
+//error is below the tolerance (geff_tolerance in the config file). If the soil has a table of the cumulative integral
+//(see calc_Geff_table), Geff is instead the difference of two interpolated table values.
 /***********************************************************************************************/
 
+#ifdef GEFF_STATISTICS
+// counters of the Geff computations of the layer benchmark (see struct geff_statistics)
+struct geff_statistics geff_stats = {0, 0};
+#endif
+
+// nodes (abscissae on [-1,1], the positive half) and weights of the 15-point Kronrod rule and of the embedded
+// 7-point Gauss rule (Gauss nodes are gk15_x[1], gk15_x[3], gk15_x[5] and the center); values as in QUADPACK qk15
+static const double gk15_x[8]  = {0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+				  0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+				  0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+				  0.207784955007898467600689403773245, 0.000000000000000000000000000000000};
+static const double gk15_wk[8] = {0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+				  0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+				  0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+				  0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+static const double g7_w[4]    = {0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+				  0.381830050505118944950369775488975, 0.417959183673469387755102040816327};
+
+#define GEFF_MAX_PANELS 32     // maximum number of panels of the adaptive quadrature (fixed, no allocation)
+#define GEFF_H_SATURATED 0.1   // below this head [cm] calc_Se_from_h returns Se = 1, i.e., K = Ksat
+#define GEFF_TABLE_DS (log(10.0)/GEFF_TABLE_NODES_PER_DECADE)  // spacing of the table nodes in ln(h)
+
+// integrand of Geff in s = ln(h): K(h) dh = K(e^s) e^s ds
+static inline double geff_integrand(double s, double vg_alpha, double vg_n, double vg_m, double Ksat)
+{
+  double h = exp(s);
+  return calc_K_from_Se(calc_Se_from_h(h, vg_alpha, vg_m, vg_n), Ksat, vg_m) * h;
+}
+
+// 15-point Kronrod estimate of the integral over [s_left, s_right]; the difference to the embedded 7-point Gauss
+// estimate is returned in error
+static double geff_kronrod_panel(double s_left, double s_right, double vg_alpha, double vg_n, double vg_m, double Ksat,
+				 double *error)
+{
+  double center     = 0.5 * (s_left + s_right);
+  double half_width = 0.5 * (s_right - s_left);
+
+  double f_center = geff_integrand(center, vg_alpha, vg_n, vg_m, Ksat);
+  double kronrod  = gk15_wk[7] * f_center;
+  double gauss    = g7_w[3] * f_center;
+
+  for (int j = 0; j < 7; j++) {
+    double ds = half_width * gk15_x[j];
+    double f  = geff_integrand(center - ds, vg_alpha, vg_n, vg_m, Ksat) + geff_integrand(center + ds, vg_alpha, vg_n, vg_m, Ksat);
+    kronrod += gk15_wk[j] * f;
+    if (j % 2 == 1)
+      gauss += g7_w[j/2] * f;
+  }
+
+#ifdef GEFF_STATISTICS
+  geff_stats.K_evaluations += 15;
+#endif
+
+  *error = fabs((kronrod - gauss) * half_width);
+  return kronrod * half_width;
+}
+
+// integral of K(h) dh from h_f to h_i (h_i > h_f); adaptive quadrature with relative error tolerance
+static double geff_integral(double h_f, double h_i, double vg_alpha, double vg_n, double vg_m, double Ksat, double tolerance)
+{
+  double integral_sat = 0.0;
+
+  // K = Ksat below GEFF_H_SATURATED, so that part of the integral is exact (and ln(h) is finite above it)
+  if (h_f < GEFF_H_SATURATED) {
+    integral_sat = Ksat * (fmin(h_i, GEFF_H_SATURATED) - h_f);
+    h_f = GEFF_H_SATURATED;
+  }
+
+  if (h_i <= h_f)
+    return integral_sat;
+
+  double s_left[GEFF_MAX_PANELS], s_right[GEFF_MAX_PANELS], panel_integral[GEFF_MAX_PANELS], panel_error[GEFF_MAX_PANELS];
+  int num_panels = 1;
+
+  s_left[0]  = log(h_f);
+  s_right[0] = log(h_i);
+  panel_integral[0] = geff_kronrod_panel(s_left[0], s_right[0], vg_alpha, vg_n, vg_m, Ksat, &panel_error[0]);
+
+  // globally adaptive: bisect the panel with the largest error until the total error meets the tolerance
+  while (true) {
+    double integral = 0.0, error = 0.0;
+    int worst = 0;
+
+    for (int p = 0; p < num_panels; p++) {
+      integral += panel_integral[p];
+      error    += panel_error[p];
+      if (panel_error[p] > panel_error[worst])
+	worst = p;
+    }
+
+    if (error <= tolerance * fabs(integral_sat + integral) || num_panels == GEFF_MAX_PANELS)
+      return integral_sat + integral;
+
+    double s_mid = 0.5 * (s_left[worst] + s_right[worst]);
+    s_left[num_panels]  = s_mid;
+    s_right[num_panels] = s_right[worst];
+    s_right[worst]      = s_mid;
+
+    panel_integral[worst]      = geff_kronrod_panel(s_left[worst], s_right[worst], vg_alpha, vg_n, vg_m, Ksat,
+						    &panel_error[worst]);
+    panel_integral[num_panels] = geff_kronrod_panel(s_left[num_panels], s_right[num_panels], vg_alpha, vg_n, vg_m, Ksat,
+						    &panel_error[num_panels]);
+    num_panels++;
+  }
+}
+
+// cubic Hermite interpolant on [0,1] through (0, y0), (1, y1) with slopes d0, d1 (per unit of t)
+static inline double hermite(double t, double y0, double y1, double d0, double d1)
+{
+  double t2 = t*t, t3 = t2*t;
+  return (2.0*t3 - 3.0*t2 + 1.0)*y0 + (t3 - 2.0*t2 + t)*d0 + (-2.0*t3 + 3.0*t2)*y1 + (t3 - t2)*d1;
+}
+
+// cumulative integral I(h) = int_0^h K(h')/Ksat dh' from the table of a soil (see calc_Geff_table); beyond the
+// table the remainder is integrated numerically
+static double geff_table_integral(double h, const double *table, double vg_alpha, double vg_n, double vg_m,
+				  double tolerance)
+{
+  const int num_intervals = GEFF_TABLE_DECADES * GEFF_TABLE_NODES_PER_DECADE;
+
+  if (h <= GEFF_H_SATURATED)
+    return h;
+
+  if (h >= GEFF_TABLE_H_MAX)
+    return table[2*num_intervals] + geff_integral(GEFF_TABLE_H_MAX, h, vg_alpha, vg_n, vg_m, 1.0, tolerance);
+
+  double x = log(h/GEFF_H_SATURATED)/GEFF_TABLE_DS;
+  int k = (int) x;
+  if (k >= num_intervals)
+    k = num_intervals - 1;
+
+  const double *node = &table[2*k];  // I and dI/ds at node k, then at node k+1
+  return hermite(x - k, node[0], node[2], node[1]*GEFF_TABLE_DS, node[3]*GEFF_TABLE_DS);
+}
+
+/***********************************************************************************************/
+/* builds the table of the cumulative integral I(h) = int_0^h K(h')/Ksat dh' of a soil, used by  */
+/* calc_Geff in place of the quadrature: Geff = I(h_i) - I(h_f), i.e., two lookups.              */
+/* The nodes are equally spaced in ln(h) (GEFF_TABLE_NODES_PER_DECADE per decade) from           */
+/* GEFF_H_SATURATED to GEFF_TABLE_H_MAX and hold I and its derivative dI/d(ln h) = K(h)/Ksat*h   */
+/* (exact), interpolated with cubic Hermite polynomials. A Geff tolerance is met if, at the      */
+/* midpoint of every interval, the interpolant is within tolerance*I of the integral and, where  */
+/* I still changes at the tolerance, the Fritsch-Carlson condition holds (the interpolant is     */
+/* monotone, like I); the smallest such tolerance is stored in tolerance_min, and calc_Geff uses */
+/* the quadrature below it. The table is independent of Ksat and thus of the frozen factor, and  */
+/* of the Geff tolerance: a change of precision profile does not rebuild it.                     */
+/***********************************************************************************************/
+extern void calc_Geff_table(struct geff_table_ *table, double vg_alpha, double vg_n, double vg_m)
+{
+  const double ds = GEFF_TABLE_DS;
+  const int num_intervals = GEFF_TABLE_DECADES * GEFF_TABLE_NODES_PER_DECADE;
+  double *I = table->I;
+
+  // the error of the nodes adds to that of the interpolation
+  double tolerance_min = GEFF_TABLE_NODE_TOLERANCE;
+
+  double h_left = GEFF_H_SATURATED;
+  I[0] = h_left;  // I(h) = h at and below GEFF_H_SATURATED
+  I[1] = geff_integrand(log(h_left), vg_alpha, vg_n, vg_m, 1.0);
+
+  for (int k = 1; k <= num_intervals; k++) {
+    double h_mid   = GEFF_H_SATURATED * exp((k-0.5)*ds);
+    double h_right = GEFF_H_SATURATED * exp(k*ds);
+    double I_mid   = I[2*k-2] + geff_integral(h_left, h_mid, vg_alpha, vg_n, vg_m, 1.0, GEFF_TABLE_NODE_TOLERANCE);
+
+    I[2*k]   = I_mid + geff_integral(h_mid, h_right, vg_alpha, vg_n, vg_m, 1.0, GEFF_TABLE_NODE_TOLERANCE);
+    I[2*k+1] = geff_integrand(log(h_right), vg_alpha, vg_n, vg_m, 1.0);
+
+    // interpolation error at the midpoint and monotonicity on this interval
+    const double *node = &I[2*k-2];
+    double error_mid = fabs(hermite(0.5, node[0], node[2], node[1]*ds, node[3]*ds) - I_mid) / I_mid;
+    double alpha = node[1]*ds/(node[2] - node[0]); // slopes relative to the secant slope
+    double beta  = node[3]*ds/(node[2] - node[0]);
+
+    // where K has decayed so far that I no longer changes at the tolerance, any deviation from monotonicity is
+    // smaller: a non monotone interval only bounds the tolerance by the relative change of I across it
+    double tolerance_interval = error_mid;
+    if (alpha*alpha + beta*beta > 9.0)
+      tolerance_interval = fmax(error_mid, (node[1] + node[3])*ds / I_mid);
+
+    tolerance_min = fmax(tolerance_min, tolerance_interval);
+    h_left = h_right;
+  }
+
+  table->vg_alpha      = vg_alpha;
+  table->vg_n          = vg_n;
+  table->vg_m          = vg_m;
+  table->tolerance_min = tolerance_min;
+
+  if (verbosity.compare("high") == 0)
+    printf("Geff table built (alpha = %lf, n = %lf), smallest Geff tolerance met = %e \n", vg_alpha, vg_n, tolerance_min);
+}
+
+// the Geff table of a soil, built at the first use and rebuilt if the van Genuchten parameters have changed since;
+// NULL if the soil has no table or the table does not meet the tolerance
+static const struct geff_table_* geff_table_of(const struct soil_properties_ *soil, double tolerance)
+{
+  struct geff_table_ *table = soil->geff_table;
+
+  if (table == NULL)
+    return NULL;
+
+  if (table->vg_alpha != soil->vg_alpha_per_cm || table->vg_n != soil->vg_n || table->vg_m != soil->vg_m)
+    calc_Geff_table(table, soil->vg_alpha_per_cm, soil->vg_n, soil->vg_m);
+
+  return tolerance >= table->tolerance_min ? table : NULL;
+}
+
 extern double calc_Geff(bool use_closed_form_G, double theta1, double theta2, double theta_e, double theta_r,
-                        double vg_alpha, double vg_n, double vg_m, double h_min, double Ksat, int nint, double lambda, double bc_psib_cm)
+                        double vg_alpha, double vg_n, double vg_m, double h_min, double Ksat, double tolerance,
+			double lambda, double bc_psib_cm, const struct geff_table_ *geff_table)
 
 {
   double Geff;       // this is the result to be returned.
 
+#ifdef GEFF_STATISTICS
+  geff_stats.calls++;
+#endif
+
   if (!use_closed_form_G){
     // local variables
     // note: units of h in cm.  units of K in cm/s
     double h_i,h_f,Se_i,Se_f;  // variables to store initial and final values
     double Se;
-    double h2;         // the head at the right-hand side of the trapezoid being integrated [m]
-    double dh;         // the delta h over which integration is performed [m]
-    double Se1,Se2;    // the scaled moisture content on left- and right-hand side of trapezoid
-    double K1,K2;      // the K(h) values on the left and right of the region dh integrated [m]
 
     Se_i = calc_Se_from_theta(theta1,theta_e,theta_r);    // scaled initial water content (0-1) [-]
     Se_f = calc_Se_from_theta(theta2,theta_e,theta_r);    // scaled final water content (0-1) [-]
@@ -66,48 +279,15 @@ extern double calc_Geff(bool use_closed_form_G, double theta1, double theta2, do
       printf("Se_f = %8.6lf,  Se_inverse = %8.6lf\n", Se_f, Se);
     }
 
-    dh = (h_i-h_f)/(double)nint;
-    dh = dh*0.01; //factor used to make dh small to begin with; dh begins small and is adaptively changed
-
     Geff = 0.0;
 
-    // integrate k(h) dh from h_i to h_f, using trapezoidal rule, with subscript
-    // 1 denoting the left-hand side of the trapezoid, and 2 denoting the right-hand side
-
-    Se1 = Se_i;  // could just use Se_i in next statement.  Done 4 completeness.
-    K1  = calc_K_from_Se(Se1, Ksat, vg_m);
-    h2  = h_f + dh;
-
-    while(h2<h_i) {
-
-      double prior_h2 = h2;
-
-      Se2 = calc_Se_from_h(h2, vg_alpha, vg_m, vg_n);
-      K2  = calc_K_from_Se(Se2, Ksat, vg_m);
-
-      //dh is the trapezoid width for numerical integration. dh becomes smaller if the percent difference between K1 and K2 is too large, and dh becomes bigger if K1 and K2 are sufficiently close.
-      //In the case that (K1-K2)/K2 > 0.02, K1 and K2 differ by more than 2 percent. The factor of 2 percent seemed to offer the optimal intersection of accuracy and speed. 
-      if ( (K1-K2)/K2 > 0.02 ){//if K1 disagrees with K2 by more than this fraction, then dh is made smaller
-        dh = dh*0.5;
-      }
-      else {//but if K1 and K2 are within a certain fraction of each other, then dh is made larger
-        dh = dh*10.0;
-      }
-
-      if (h2<h_i){
-        Geff += (K1+K2)*dh/2.0;                  // trapezoidal rule
-      }
-      else{
-        dh = h_i - prior_h2;
-        Se2 = calc_Se_from_h(h_i, vg_alpha, vg_m, vg_n);
-        K2  = calc_K_from_Se(Se2, Ksat, vg_m);
-        Geff += (K1+K2)*dh/2.0;  
-      }
-
-      // reset for next time through loop
-      K1 = K2;
-      h2 += dh;
-
+    // integrate K(h) dh from h_f to h_i; zero if the front is not wetter than the soil below it
+    if (h_i > h_f) {
+      if (geff_table != NULL && tolerance >= geff_table->tolerance_min)   // the table is normalized by Ksat
+	Geff = Ksat * (geff_table_integral(h_i, geff_table->I, vg_alpha, vg_n, vg_m, tolerance) -
+		       geff_table_integral(h_f, geff_table->I, vg_alpha, vg_n, vg_m, tolerance));
+      else
+	Geff = geff_integral(h_f, h_i, vg_alpha, vg_n, vg_m, Ksat, tolerance);
     }
 
     //std::cerr<<"Integral = "<< Geff<<" "<<Ksat<<"\n";
@@ -149,6 +329,18 @@ double calc_theta_from_h(double h,double alpha, double m, double n, double theta
   return(1.0/(pow(1.0+pow(alpha*h,n),m))*(theta_e-theta_r)+theta_r);
 }
 
+/*******************************************************************/
+/* function to calculate d(theta)/dh, the slope of the retention   */
+/* curve (negative; theta decreases as the capillary head grows)   */
+/*******************************************************************/
+double calc_dtheta_dh(double h,double alpha, double m, double n, double theta_e, double theta_r)
+{
+  if (h <= 0.0) return 0.0;  // saturated; the curve is flat at h = 0 for n > 1
+
+  double ah_n = pow(alpha*h,n);
+  return(-(theta_e-theta_r)*m*n*ah_n/(h*pow(1.0+ah_n,m+1.0)));
+}
+
 /***********************************/
 /* function to calculate Se from h */
 /***********************************/
@@ -181,3 +373,264 @@ double calc_Se_from_theta(double theta,double e,double r)
 {
   return((theta-r)/(e-r));
 }
+
+
+
+/***********************************************************************************************/
+/* Tables of the van Genuchten relations (optional, vg_table in the config file).              */
+/* Each relation is tabulated in variables in which it is smooth over its whole range:         */
+/*   ln(Se)     at nodes of ln(h)                                    for theta(h)               */
+/*   ln(h)      at nodes of logit(Se) = ln(Se/(1-Se))                for h(Se)                  */
+/*   ln(K/Ksat) at nodes of logit(Se)                                for K(Se)                  */
+/* with VG_TABLE_NODES_PER_UNIT equally spaced nodes per unit of the abscissa, interpolated     */
+/* with monotone piecewise cubics (PCHIP, Fritsch and Butland 1984), so the tabulated relations */
+/* are monotone like the formulas. Outside the tables the formulas are used. The relative error */
+/* of Se (i.e., theta - theta_r) and K is at most VG_TABLE_TOLERANCE (checked when a table is   */
+/* built; about 2e-6 and 1e-6 for the soils of data/vG_default_params.dat). h(Se) is refined to */
+/* the inverse of the tabulated theta(h), with a relative error of at most 7e-6 for those soils. */
+/***********************************************************************************************/
+
+#define VG_TABLE_DX (1.0/VG_TABLE_NODES_PER_UNIT)  // spacing of the table nodes
+
+// range of h covered by the theta(h) table and range of Se covered by the h(Se) and K(Se) tables
+static const double vg_table_h_min  = exp((double)VG_TABLE_LN_H_MIN);
+static const double vg_table_h_max  = exp((double)VG_TABLE_LN_H_MAX);
+static const double vg_table_Se_min = 1.0/(1.0 + exp(-(double)VG_TABLE_LOGIT_MIN));
+static const double vg_table_Se_max = 1.0/(1.0 + exp(-(double)VG_TABLE_LOGIT_MAX));
+
+// ln(Se) at s = ln(h)
+static double vg_ln_Se(double s, double vg_alpha, double vg_n, double vg_m)
+{
+  return -vg_m * log1p(pow(vg_alpha * exp(s), vg_n));
+}
+
+// ln(h) at t = logit(Se); Se^(-1/m) - 1 is computed without cancellation near saturation
+static double vg_ln_h(double t, double vg_alpha, double vg_n, double vg_m)
+{
+  double ln_Se = -log1p(exp(-t));
+  return log(expm1(-ln_Se/vg_m))/vg_n - log(vg_alpha);
+}
+
+// ln(K/Ksat) at t = logit(Se); ln(1 - Se^(1/m)) and 1 - (1 - Se^(1/m))^m are computed without cancellation
+static double vg_ln_Kr(double t, double vg_m)
+{
+  double ln_Se = -log1p(exp(-t));
+  double y = ln_Se/vg_m;  // ln(Se^(1/m))
+  double ln_one_minus = y < -M_LN2 ? log1p(-exp(y)) : log(-expm1(y));
+  return 0.5*ln_Se + 2.0*log(-expm1(vg_m * ln_one_minus));
+}
+
+// slopes (per node spacing) of the PCHIP interpolant through the values table[2k], k = 0..num_intervals; the slopes
+// are stored in table[2k+1]. Interior slopes are the harmonic mean of the adjacent secants (zero at extrema), end
+// slopes the shape-preserving three-point estimate
+static void pchip_slopes(double *table, int num_intervals)
+{
+  for (int k = 1; k < num_intervals; k++) {
+    double secant_left  = table[2*k] - table[2*k-2];
+    double secant_right = table[2*k+2] - table[2*k];
+    table[2*k+1] = secant_left*secant_right > 0.0 ? 2.0*secant_left*secant_right/(secant_left + secant_right) : 0.0;
+  }
+
+  for (int end = 0; end < 2; end++) {
+    int k = end == 0 ? 0 : num_intervals;
+    int direction = end == 0 ? 1 : -1;
+    double secant_0 = direction * (table[2*(k+direction)] - table[2*k]);
+    double secant_1 = direction * (table[2*(k+2*direction)] - table[2*(k+direction)]);
+    double slope = 0.5*(3.0*secant_0 - secant_1);
+
+    if (slope*secant_0 <= 0.0)
+      slope = 0.0;
+    else if (secant_0*secant_1 <= 0.0 && fabs(slope) > 3.0*fabs(secant_0))
+      slope = 3.0*secant_0;
+
+    table[2*k+1] = slope;
+  }
+}
+
+// value of the PCHIP interpolant of a table at x (in units of the node spacing, 0 <= x <= num_intervals); its
+// derivative with respect to x is returned in slope if slope is not NULL
+static inline double pchip(const double *table, int num_intervals, double x, double *slope = NULL)
+{
+  int k = (int) x;
+  if (k >= num_intervals)
+    k = num_intervals - 1;
+
+  const double *node = &table[2*k];  // value and slope at node k, then at node k+1
+  double t = x - k;
+
+  if (slope != NULL)
+    *slope = 6.0*t*(t - 1.0)*(node[0] - node[2]) + (3.0*t - 1.0)*(t - 1.0)*node[1] + t*(3.0*t - 2.0)*node[3];
+
+  return hermite(t, node[0], node[2], node[1], node[3]);
+}
+
+/***********************************************************************************************/
+/* builds the tables of the van Genuchten relations of a soil (see above). The table is         */
+/* accepted only if, at four points in every interval, the relative error of the interpolated  */
+/* Se, h and K/Ksat is below tolerance; otherwise false is returned and the soil uses the       */
+/* formulas. The tables are independent of theta_e, theta_r and Ksat.                           */
+/***********************************************************************************************/
+extern bool calc_vg_table(struct vg_table_ *table, double vg_alpha, double vg_n, double vg_m, double tolerance)
+{
+  for (int k = 0; k <= VG_TABLE_H_INTERVALS; k++)
+    table->ln_Se[2*k] = vg_ln_Se(VG_TABLE_LN_H_MIN + k*VG_TABLE_DX, vg_alpha, vg_n, vg_m);
+
+  for (int k = 0; k <= VG_TABLE_SE_INTERVALS; k++) {
+    double t = VG_TABLE_LOGIT_MIN + k*VG_TABLE_DX;
+    table->ln_h[2*k]  = vg_ln_h(t, vg_alpha, vg_n, vg_m);
+    table->ln_Kr[2*k] = vg_ln_Kr(t, vg_m);
+  }
+
+  pchip_slopes(table->ln_Se, VG_TABLE_H_INTERVALS);
+  pchip_slopes(table->ln_h, VG_TABLE_SE_INTERVALS);
+  pchip_slopes(table->ln_Kr, VG_TABLE_SE_INTERVALS);
+
+  // the error of the interpolated ln(y) is the relative error of y; checked at the quarter points of every interval
+  table->max_error = 0.0;
+
+  for (int k = 0; k < 4*VG_TABLE_H_INTERVALS; k++) {
+    double x = 0.25*(k + 0.5);
+    double error = fabs(pchip(table->ln_Se, VG_TABLE_H_INTERVALS, x)
+			- vg_ln_Se(VG_TABLE_LN_H_MIN + x*VG_TABLE_DX, vg_alpha, vg_n, vg_m));
+    table->max_error = fmax(table->max_error, error);
+  }
+
+  for (int k = 0; k < 4*VG_TABLE_SE_INTERVALS; k++) {
+    double x = 0.25*(k + 0.5);
+    double t = VG_TABLE_LOGIT_MIN + x*VG_TABLE_DX;
+    double error_h = fabs(pchip(table->ln_h, VG_TABLE_SE_INTERVALS, x) - vg_ln_h(t, vg_alpha, vg_n, vg_m));
+    double error_K = fabs(pchip(table->ln_Kr, VG_TABLE_SE_INTERVALS, x) - vg_ln_Kr(t, vg_m));
+    table->max_error = fmax(table->max_error, fmax(error_h, error_K));
+  }
+
+  if (verbosity.compare("high") == 0)
+    printf("van Genuchten table: maximum relative error = %e \n", table->max_error);
+
+  return table->max_error <= tolerance;
+}
+
+/*************************************************************/
+/* the functions above for a soil, with the constants derived */
+/* from its parameters (see lgar_update_soil_constants) in    */
+/* place of divisions and pow; the van Genuchten relations    */
+/* come from the tables of the soil within their range, from  */
+/* the formulas otherwise                                     */
+/*************************************************************/
+double calc_theta_from_h(double h, const struct soil_properties_ *soil)
+{
+  const struct soil_constants_ *c = &soil->constants;
+  const struct vg_table_ *table = soil->vg_table;
+
+  if (table == NULL || !(h > vg_table_h_min && h < vg_table_h_max))
+    return pow(1.0 + pow(soil->vg_alpha_per_cm*h, soil->vg_n), -soil->vg_m) * c->theta_range + soil->theta_r;
+
+  double x = (log(h) - VG_TABLE_LN_H_MIN) * VG_TABLE_NODES_PER_UNIT;
+  return exp(pchip(table->ln_Se, VG_TABLE_H_INTERVALS, x)) * c->theta_range + soil->theta_r;
+}
+
+double calc_dtheta_dh(double h, const struct soil_properties_ *soil)
+{
+  if (h <= 0.0) return 0.0;  // saturated; the curve is flat at h = 0 for n > 1
+
+  double ah_n = pow(soil->vg_alpha_per_cm*h, soil->vg_n);
+  return -soil->constants.dtheta_dh_scale * ah_n * pow(1.0 + ah_n, soil->constants.dtheta_dh_exponent) / h;
+}
+
+double calc_h_from_Se(double Se, const struct soil_properties_ *soil)
+{
+  const struct soil_constants_ *c = &soil->constants;
+  const struct vg_table_ *table = soil->vg_table;
+
+  if (table == NULL || !(Se > 0.0 && Se < 1.0))
+    return c->inv_vg_alpha * pow(pow(Se, -c->inv_vg_m) - 1.0, c->inv_vg_n);
+
+  double ln_Se = log(Se);
+  double ln_h;
+
+  if (Se > vg_table_Se_min && Se < vg_table_Se_max)
+    ln_h = pchip(table->ln_h, VG_TABLE_SE_INTERVALS, (ln_Se - log1p(-Se) - VG_TABLE_LOGIT_MIN) * VG_TABLE_NODES_PER_UNIT);
+  else
+    ln_h = log(c->inv_vg_alpha * pow(pow(Se, -c->inv_vg_m) - 1.0, c->inv_vg_n));
+
+  // where theta(h) is tabulated, h is refined by a Newton step on that table so that theta -> h -> theta returns theta
+  // to round-off, as the formulas do; otherwise water would be gained or lost wherever theta is recomputed from h
+  double x = (ln_h - VG_TABLE_LN_H_MIN) * VG_TABLE_NODES_PER_UNIT;
+
+  if (x > 0.0 && x < VG_TABLE_H_INTERVALS) {
+    double slope;
+    double ln_Se_table = pchip(table->ln_Se, VG_TABLE_H_INTERVALS, x, &slope);
+    if (slope < 0.0)
+      ln_h += (ln_Se - ln_Se_table) / (slope * VG_TABLE_NODES_PER_UNIT);
+  }
+
+  return exp(ln_h);
+}
+
+double calc_K_from_Se(double Se, double Ksat, const struct soil_properties_ *soil)
+{
+  const struct vg_table_ *table = soil->vg_table;
+
+  if (table == NULL || !(Se > vg_table_Se_min && Se < vg_table_Se_max)) {
+    double x = 1.0 - pow(1.0 - pow(Se, soil->constants.inv_vg_m), soil->vg_m);
+    return Ksat * sqrt(Se) * x * x;
+  }
+
+  double x = (log(Se/(1.0 - Se)) - VG_TABLE_LOGIT_MIN) * VG_TABLE_NODES_PER_UNIT;
+  return Ksat * exp(pchip(table->ln_Kr, VG_TABLE_SE_INTERVALS, x));
+}
+
+double calc_Se_from_theta(double theta, const struct soil_properties_ *soil)
+{
+  // divided rather than multiplied by the reciprocal: Se must be exactly 1 at theta_e (h = 0, K = Ksat), and a Se
+  // one ulp above 1 would make h NaN
+  return (theta - soil->theta_r) / soil->constants.theta_range;
+}
+
+/*************************************************************/
+/* Geff of a soil (see calc_Geff above); the numeric integral */
+/* uses the table of the soil if it has one that meets the    */
+/* tolerance (built at its first use, see geff_table_of), the */
+/* closed form the Brooks & Corey constants of the soil       */
+/*************************************************************/
+extern double calc_Geff(bool use_closed_form_G, double theta1, double theta2, const struct soil_properties_ *soil,
+			double Ksat, double tolerance)
+{
+  const struct soil_constants_ *c = &soil->constants;
+  double Geff;
+
+#ifdef GEFF_STATISTICS
+  geff_stats.calls++;
+#endif
+
+  if (!use_closed_form_G) {
+    double h_i = calc_h_from_Se(calc_Se_from_theta(theta1, soil), soil);  // capillary head below the front [cm]
+    double h_f = calc_h_from_Se(calc_Se_from_theta(theta2, soil), soil);  // capillary head of the front [cm]
+
+    Geff = 0.0;
+
+    // integrate K(h) dh from h_f to h_i; zero if the front is not wetter than the soil below it
+    if (h_i > h_f) {
+      const struct geff_table_ *table = geff_table_of(soil, tolerance);
+      if (table != NULL)   // the table is normalized by Ksat
+	Geff = Ksat * (geff_table_integral(h_i, table->I, soil->vg_alpha_per_cm, soil->vg_n, soil->vg_m, tolerance) -
+		       geff_table_integral(h_f, table->I, soil->vg_alpha_per_cm, soil->vg_n, soil->vg_m, tolerance));
+      else
+	Geff = geff_integral(h_f, h_i, soil->vg_alpha_per_cm, soil->vg_n, soil->vg_m, Ksat, tolerance);
+    }
+
+    Geff = fabs(Geff/Ksat);       // by convention Geff is a positive quantity
+
+    if (verbosity.compare("high") == 0)
+      printf ("Capillary suction (G) = %8.6lf \n", Geff);
+  }
+  else {
+    double Se_f_pow = pow(calc_Se_from_theta(theta1, soil), c->bc_exponent);  // of the wetting front
+    double Se_i_pow = pow(calc_Se_from_theta(theta2, soil), c->bc_exponent);  // of the soil below the front
+
+    Geff = c->bc_Hc_cm*(Se_i_pow - Se_f_pow)/(1.0 - Se_f_pow);
+    if (isinf(Geff) || isnan(Geff))
+      Geff = c->bc_Hc_cm;
+  }
+
+  return Geff;
+}
@@ -0,0 +1,155 @@
+/*
+  - Scaling benchmark: runs the model through its BMI for soil columns discretized into 3 to 50 layers and
+    reports the cost of an Update (one hour) against the 3-layer column
+  - the 200 cm column of the unit test (soil types 13, 14, 15 with interfaces at 44 and 175 cm) is split into
+    layers of equal thickness; each layer takes the soil type of the horizon its center lies in, so all columns
+    represent the same soil and differ only in the number of layers
+  - forcing: 6 hours of rain (12 mm/h) every 2 days, PET = 0.2 mm/h, so that wetting fronts are created,
+    merged, and cross layer boundaries
+  - also reports how many Geff values (capillary drive) an Update computes and the cost of each (K(h) evaluations)
+  - run from the tests directory (the soil parameters file is ../data/vG_default_params.dat)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip> // std::setw
+#include <chrono>
+#include <vector>
+#include "../bmi/bmi.hxx"
+#include "../include/bmi_lgar.hxx"
+
+#define SUCCESS 0
+
+// writes a config file for a column of num_layers layers; returns the config file name
+static std::string WriteConfigFile(int num_layers, int num_updates)
+{
+  double soil_depth_cm    = 200.0;
+  double horizon_bottom[] = {44.0, 175.0, 200.0}; // bottom of the soil horizons [cm]
+  int    horizon_soil[]   = {13, 14, 15};
+
+  std::stringstream thickness, soil_type;
+  thickness << std::setprecision(17);
+
+  for (int layer=0; layer < num_layers; layer++) {
+    double top, bottom;
+
+    if (num_layers == 3) { // the unit test column
+      top    = layer == 0 ? 0.0 : horizon_bottom[layer-1];
+      bottom = horizon_bottom[layer];
+    }
+    else {
+      top    = layer * soil_depth_cm / num_layers;
+      bottom = (layer+1) * soil_depth_cm / num_layers;
+    }
+
+    int h = 0;
+    while (h < 2 && 0.5*(top + bottom) > horizon_bottom[h])
+      h++;
+
+    thickness << (layer > 0 ? "," : "") << bottom - top;
+    soil_type << (layer > 0 ? "," : "") << horizon_soil[h];
+  }
+
+  std::stringstream config_file;
+  config_file << "benchmark_layers_" << num_layers << ".txt";
+
+  std::ofstream config(config_file.str().c_str());
+  config << "verbosity=none\n";
+  config << "soil_params_file=../data/vG_default_params.dat\n";
+  config << "layer_thickness=" << thickness.str() << "[cm]\n";
+  config << "initial_psi=2000.0[cm]\n";
+  config << "timestep=300[sec]\n";
+  config << "endtime=" << num_updates << "[hr]\n";
+  config << "forcing_resolution=3600[sec]\n";
+  config << "ponded_depth_max=0[cm]\n";
+  config << "layer_soil_type=" << soil_type.str() << "\n";
+  config << "max_soil_types=15\n";
+  config << "wilting_point_psi=15495.0[cm]\n";
+  config << "field_capacity_psi=340.9[cm]\n";
+  config << "giuh_ordinates=0.06,0.51,0.28,0.12,0.03\n";
+  config.close();
+
+  return config_file.str();
+}
+
+int main(int argc, char *argv[])
+{
+  int num_updates = 2000; // number of (hourly) Update calls per column
+
+  if (argc > 2 || (argc == 2 && atoi(argv[1]) <= 0)) {
+    printf("Usage: ../build/lasam_benchmark [num_updates] \n");
+    printf("Runs the LASAM scaling benchmark for 3 to 50 soil layers (default num_updates = 2000).\n");
+    return SUCCESS;
+  }
+
+  if (argc == 2)
+    num_updates = atoi(argv[1]);
+
+  std::vector<int> layers = {3, 5, 10, 20, 30, 40, 50};
+  std::vector<double> time_per_update_ms(layers.size());
+  std::vector<double> global_error_cm(layers.size());
+  std::vector<int> num_wetting_fronts(layers.size());
+  std::vector<size_t> footprint_bytes(layers.size());
+  std::vector<double> geff_calls_per_update(layers.size());
+  std::vector<double> K_evals_per_geff_call(layers.size());
+
+  std::cout<<"\n**************** BEGIN LASAM LAYER SCALING BENCHMARK *******************\n";
+
+  for (unsigned int n=0; n < layers.size(); n++) {
+    std::string config_file = WriteConfigFile(layers[n], num_updates);
+
+    BmiLGAR model;
+    model.Initialize(config_file);
+
+    double PET = 0.2; // mm/hr
+    model.SetValue("potential_evapotranspiration_rate", &PET);
+
+    std::chrono::duration<double> elapsed(0.0);
+    geff_stats.calls = 0;
+    geff_stats.K_evaluations = 0;
+
+    for (int i=0; i < num_updates; i++) {
+      double precip = (i % 48) < 6 ? 12.0 : 0.0; // mm/hr
+      model.SetValue("precipitation_rate", &precip);
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      model.Update();
+      elapsed += std::chrono::steady_clock::now() - start;
+    }
+
+    struct model_state *state = model.get_model();
+    struct lgar_mass_balance_variables *mb = &state->lgar_mass_balance;
+
+    time_per_update_ms[n] = 1000.0 * elapsed.count() / num_updates;
+    global_error_cm[n]    = mb->volstart_cm + mb->volprecip_cm - mb->volrunoff_cm - mb->volAET_cm - mb->volon_cm
+                          - mb->volrech_cm - mb->volend_cm + mb->volchange_calib_cm;
+    num_wetting_fronts[n] = state->lgar_bmi_params.num_wetting_fronts;
+    footprint_bytes[n]    = model.GetMemoryFootprint();
+    geff_calls_per_update[n] = double(geff_stats.calls) / num_updates;
+    K_evals_per_geff_call[n] = geff_stats.calls > 0 ? double(geff_stats.K_evaluations) / geff_stats.calls : 0.0;
+
+    model.Finalize();
+    remove(config_file.c_str());
+  }
+
+  std::cout<<"\n| *************************************** \n";
+  std::cout<<"| Layer scaling ("<< num_updates <<" Update calls per column) \n";
+  std::cout<<"| layers | time per Update [ms] | relative to 3 layers | wetting fronts | memory [bytes] | Geff calls per Update | K evaluations per Geff call | global balance [cm] \n";
+
+  for (unsigned int n=0; n < layers.size(); n++)
+    std::cout<<"| "<< std::left << std::setw(7) << layers[n]
+	     <<"| "<< std::setw(21) << time_per_update_ms[n]
+	     <<"| "<< std::setw(21) << time_per_update_ms[n]/time_per_update_ms[0]
+	     <<"| "<< std::setw(15) << num_wetting_fronts[n]
+	     <<"| "<< std::setw(15) << footprint_bytes[n]
+	     <<"| "<< std::setw(22) << geff_calls_per_update[n]
+	     <<"| "<< std::setw(28) << K_evals_per_geff_call[n]
+	     <<"| "<< global_error_cm[n] <<"\n";
+
+  std::cout<<"| *************************************** \n";
+
+  return SUCCESS;
+}
@@ -0,0 +1,2 @@
+#!/bin/bash
+../build/lasam_benchmark $1